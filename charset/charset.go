@@ -0,0 +1,245 @@
+// charset.go - Export-time charset validation and conversion to UTF-8
+package charset
+
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"unicode/utf8"
+)
+
+// String columns are decoded as raw bytes in the column's charset. Before
+// export they go through a Converter, which produces valid UTF-8:
+//
+//   - utf8mb4, utf8mb3/utf8 and ascii are validated; valid values are passed
+//     through without copying (utf8mb3 is a byte-for-byte subset of utf8mb4).
+//   - latin1 (MySQL's latin1 is Windows-1252) is converted to UTF-8.
+//   - binary is passed through untouched.
+//
+// Pure ASCII is by far the common case, so all paths first skip ASCII runs
+// eight bytes at a time and only decode byte by byte once a non-ASCII byte
+// is found.
+
+// Policy selects what happens to invalid input
+type Policy int
+
+const (
+	// PolicyReplace substitutes U+FFFD for each invalid byte
+	PolicyReplace Policy = iota
+	// PolicyError fails the conversion with ErrInvalidUTF8
+	PolicyError
+)
+
+// ParsePolicy returns the Policy named "replace" or "error"
+func ParsePolicy(name string) (Policy, error) {
+	switch name {
+	case "replace":
+		return PolicyReplace, nil
+	case "error":
+		return PolicyError, nil
+	}
+	return 0, fmt.Errorf("unknown charset policy %q (want replace or error)", name)
+}
+
+// ErrInvalidUTF8 is returned under PolicyError for invalid input
+var ErrInvalidUTF8 = errors.New("invalid UTF-8 in string column")
+
+type sourceKind uint8
+
+const (
+	sourceUTF8 sourceKind = iota
+	sourceLatin1
+	sourceBinary
+)
+
+// Converter converts values of one column charset to UTF-8
+type Converter struct {
+	kind   sourceKind
+	policy Policy
+}
+
+// NewConverter returns a converter for a MySQL charset name
+func NewConverter(charset string, policy Policy) *Converter {
+	c := &Converter{policy: policy}
+	switch charset {
+	case "latin1":
+		c.kind = sourceLatin1
+	case "binary":
+		c.kind = sourceBinary
+	default:
+		c.kind = sourceUTF8
+	}
+	return c
+}
+
+// Passthrough reports whether valid values of this charset are already UTF-8
+func (c *Converter) Passthrough() bool { return c.kind != sourceLatin1 }
+
+// Append appends src converted to UTF-8 to dst
+func (c *Converter) Append(dst, src []byte) ([]byte, error) {
+	switch c.kind {
+	case sourceBinary:
+		return append(dst, src...), nil
+	case sourceLatin1:
+		return appendLatin1(dst, src), nil
+	}
+	n := ValidPrefix(src)
+	if n == len(src) {
+		return append(dst, src...), nil
+	}
+	if c.policy == PolicyError {
+		return dst, ErrInvalidUTF8
+	}
+	return appendReplacingInvalid(append(dst, src[:n]...), src[n:]), nil
+}
+
+// ConvertBatch converts a batch of values of one column in place. Values
+// that are already valid UTF-8 are left pointing at their original bytes;
+// the others are rewritten into buf and values[i] is replaced by a slice of
+// it. The grown buf is returned so the caller can reuse it for the next
+// batch. NULL (nil) values are left alone.
+func (c *Converter) ConvertBatch(values [][]byte, buf []byte) ([]byte, error) {
+	if c.kind == sourceBinary {
+		return buf, nil
+	}
+
+	// Converted output is at most 3 bytes per input byte (Windows-1252 and
+	// U+FFFD both need 3), so growing once keeps earlier slices valid.
+	need := 0
+	for _, v := range values {
+		if c.kind == sourceLatin1 || !IsASCII(v) {
+			need += 3 * len(v)
+		}
+	}
+	if need == 0 {
+		return buf, nil
+	}
+	if cap(buf)-len(buf) < need {
+		grown := make([]byte, len(buf), len(buf)+need)
+		copy(grown, buf)
+		buf = grown
+	}
+
+	for i, v := range values {
+		if v == nil {
+			continue
+		}
+		if c.kind == sourceLatin1 {
+			if IsASCII(v) {
+				continue
+			}
+			start := len(buf)
+			buf = appendLatin1(buf, v)
+			values[i] = buf[start:len(buf):len(buf)]
+			continue
+		}
+		n := ValidPrefix(v)
+		if n == len(v) {
+			continue
+		}
+		if c.policy == PolicyError {
+			return buf, fmt.Errorf("value %d: %w", i, ErrInvalidUTF8)
+		}
+		start := len(buf)
+		buf = appendReplacingInvalid(append(buf, v[:n]...), v[n:])
+		values[i] = buf[start:len(buf):len(buf)]
+	}
+	return buf, nil
+}
+
+const highBits = 0x8080808080808080
+
+// asciiPrefix returns the length of the leading ASCII run of b
+func asciiPrefix(b []byte) int {
+	i := 0
+	for ; i+8 <= len(b); i += 8 {
+		if binary.LittleEndian.Uint64(b[i:])&highBits != 0 {
+			break
+		}
+	}
+	for ; i < len(b) && b[i] < utf8.RuneSelf; i++ {
+	}
+	return i
+}
+
+// IsASCII reports whether b contains only 7-bit bytes
+func IsASCII(b []byte) bool { return asciiPrefix(b) == len(b) }
+
+// ValidPrefix returns the length of the longest valid UTF-8 prefix of b
+func ValidPrefix(b []byte) int {
+	i := 0
+	for i < len(b) {
+		i += asciiPrefix(b[i:])
+		if i == len(b) {
+			break
+		}
+		r, size := utf8.DecodeRune(b[i:])
+		if r == utf8.RuneError && size == 1 {
+			return i
+		}
+		i += size
+	}
+	return i
+}
+
+// appendReplacingInvalid appends b with every invalid byte replaced by U+FFFD
+func appendReplacingInvalid(dst, b []byte) []byte {
+	for len(b) > 0 {
+		n := asciiPrefix(b)
+		dst = append(dst, b[:n]...)
+		b = b[n:]
+		if len(b) == 0 {
+			break
+		}
+		r, size := utf8.DecodeRune(b)
+		if r == utf8.RuneError && size == 1 {
+			dst = append(dst, "�"...)
+		} else {
+			dst = append(dst, b[:size]...)
+		}
+		b = b[size:]
+	}
+	return dst
+}
+
+// appendLatin1 appends MySQL latin1 (Windows-1252) text as UTF-8
+func appendLatin1(dst, b []byte) []byte {
+	for len(b) > 0 {
+		n := asciiPrefix(b)
+		dst = append(dst, b[:n]...)
+		b = b[n:]
+		for len(b) > 0 && b[0] >= utf8.RuneSelf {
+			e := &latin1High[b[0]-0x80]
+			dst = append(dst, e.b[:e.n]...)
+			b = b[1:]
+		}
+	}
+	return dst
+}
+
+type utf8Seq struct {
+	b [3]byte
+	n uint8
+}
+
+// latin1High maps bytes 0x80-0xFF to UTF-8. 0x80-0x9F follow Windows-1252
+// like MySQL does; its five undefined bytes map to the same code point.
+var latin1High [128]utf8Seq
+
+var cp1252 = [32]rune{
+	0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+	0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+	0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+	0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178,
+}
+
+func init() {
+	for i := range latin1High {
+		r := rune(0x80 + i)
+		if i < len(cp1252) {
+			r = cp1252[i]
+		}
+		e := &latin1High[i]
+		e.n = uint8(utf8.EncodeRune(e.b[:], r))
+	}
+}
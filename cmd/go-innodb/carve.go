@@ -0,0 +1,98 @@
+package main
+
+import (
+	"fmt"
+	"io"
+	"os"
+	"path/filepath"
+	"sync"
+
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/scan"
+)
+
+// outputCarve scans a raw image for INDEX pages and prints them grouped by
+// space and index. With outDir, the newest copy of each page is written to
+// <outDir>/space_<id>.ibd at its page number, ready for -chains.
+func outputCarve(f *os.File, src io.ReaderAt, align int, outDir string) error {
+	st, err := f.Stat()
+	if err != nil {
+		return err
+	}
+	size := st.Size()
+	if size == 0 {
+		// Block devices report no size through Stat
+		if size, err = f.Seek(0, 2); err != nil {
+			return err
+		}
+	}
+
+	var (
+		mu    sync.Mutex
+		found []scan.CarvedPage
+	)
+	err = scan.Carve(src, size, scan.CarveOptions{Align: align}, func(p scan.CarvedPage, _ []byte) error {
+		mu.Lock()
+		found = append(found, p)
+		mu.Unlock()
+		return nil
+	})
+	if err != nil {
+		return err
+	}
+
+	groups, stale := scan.GroupCarved(found)
+	fmt.Printf("=== Carved %d INDEX page(s) from %d bytes (%d stale copies) ===\n", len(found), size, stale)
+	for _, g := range groups {
+		leaves, recs := 0, 0
+		minLSN, maxLSN := g.Pages[0].LSN, g.Pages[0].LSN
+		for _, p := range g.Pages {
+			if p.Level == 0 {
+				leaves++
+				recs += int(p.NumRecs)
+			}
+			if p.LSN < minLSN {
+				minLSN = p.LSN
+			}
+			if p.LSN > maxLSN {
+				maxLSN = p.LSN
+			}
+		}
+		fmt.Printf("Space %d, Index %d: %d page(s), %d leaf, %d leaf records, LSN %d..%d\n",
+			g.SpaceID, g.IndexID, len(g.Pages), leaves, recs, minLSN, maxLSN)
+	}
+
+	if outDir == "" {
+		return nil
+	}
+	if err := os.MkdirAll(outDir, 0755); err != nil {
+		return err
+	}
+	files := map[uint32]*os.File{}
+	defer func() {
+		for _, out := range files {
+			out.Close()
+		}
+	}()
+	buf := make([]byte, format.PageSize)
+	for _, g := range groups {
+		out := files[g.SpaceID]
+		if out == nil {
+			name := filepath.Join(outDir, fmt.Sprintf("space_%d.ibd", g.SpaceID))
+			if out, err = os.Create(name); err != nil {
+				return err
+			}
+			files[g.SpaceID] = out
+			fmt.Printf("Writing %s\n", name)
+		}
+		for _, p := range g.Pages {
+			if _, err := src.ReadAt(buf, p.Offset); err != nil {
+				return fmt.Errorf("re-read page at %d: %w", p.Offset, err)
+			}
+			if _, err := out.WriteAt(buf, int64(p.PageNo)*format.PageSize); err != nil {
+				return err
+			}
+		}
+	}
+	return nil
+}
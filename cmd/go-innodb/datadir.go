@@ -0,0 +1,147 @@
+package main
+
+import (
+	"errors"
+	"fmt"
+	"io"
+	"io/fs"
+	"os"
+	"path/filepath"
+	"strings"
+	"time"
+
+	"github.com/wilhasse/go-innodb/export"
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// runDatadirExport exports every tablespace under dir that has a schema in
+// schemaDir to cfg.outPath, a directory mirroring dir: db/t.ibd becomes
+// db/t.csv, or db/t.000.csv, db/t.001.csv, ... and db/t.manifest.json when
+// the table is split into parts of partSize bytes of leaf pages. A line is
+// printed as each table finishes.
+func runDatadirExport(dir, schemaDir string, partSize int64, cfg exportConfig, thCfg throttleConfig) error {
+	if schemaDir == "" {
+		return fmt.Errorf("-datadir requires -schema-dir")
+	}
+	if cfg.outPath == "" {
+		return fmt.Errorf("-datadir requires -o (the output directory)")
+	}
+	if partSize < format.PageSize {
+		return fmt.Errorf("-part-size must be at least one page")
+	}
+	if cfg.resume || cfg.shards > 1 {
+		return fmt.Errorf("-resume and -shards do not apply to -datadir (large tables are split by -part-size)")
+	}
+	opts, blocks, err := exportOptions(cfg)
+	if err != nil {
+		return err
+	}
+	th, err := newThrottle(nil, thCfg)
+	if err != nil {
+		return err
+	}
+	tables, err := findTables(dir, schemaDir)
+	if err != nil {
+		return err
+	}
+	if len(tables) == 0 {
+		return fmt.Errorf("no tablespace with a schema under %s", dir)
+	}
+
+	ext := "." + opts.Format.String()
+	if blocks {
+		ext += ".gz"
+	}
+	outPath := func(t *export.TableSource, part, parts int) string {
+		if parts == 1 {
+			return filepath.Join(cfg.outPath, t.Name+ext)
+		}
+		return filepath.Join(cfg.outPath, fmt.Sprintf("%s.%03d%s", t.Name, part, ext))
+	}
+	manifestErrs := 0
+	dopts := export.DatadirOptions{
+		Options:   opts,
+		PartPages: int(partSize / format.PageSize),
+		Create: func(t *export.TableSource, part, parts int) (io.WriteCloser, error) {
+			path := outPath(t, part, parts)
+			if err := os.MkdirAll(filepath.Dir(path), 0o755); err != nil {
+				return nil, err
+			}
+			return openSink(path, blocks, cfg, nil)
+		},
+		OnTable: func(res *export.TableResult) {
+			if res.Err == nil && len(res.Parts) > 1 {
+				files := make([]string, len(res.Parts))
+				for i := range files {
+					files[i] = filepath.Base(outPath(res.Table, i, len(res.Parts)))
+				}
+				mPath := filepath.Join(cfg.outPath, res.Table.Name+".manifest.json")
+				if res.Err = writeManifest(mPath, res.Table.Def, cfg.format, res.Parts, files); res.Err != nil {
+					manifestErrs++
+				}
+			}
+			if res.Err != nil {
+				fmt.Fprintf(os.Stderr, "%s: %v\n", res.Table.Name, res.Err)
+				return
+			}
+			fmt.Fprintf(os.Stderr, "%s: %d rows from %d leaf pages, %d bytes in %d parts (%d tasks, %v)\n",
+				res.Table.Name, res.Rows, res.Pages, res.Bytes, len(res.Parts), res.Tasks,
+				res.Elapsed.Round(time.Millisecond))
+		},
+	}
+	if th != nil {
+		dopts.Reader = func(f *os.File) io.ReaderAt { return th.Reader(f) }
+	}
+	st, err := export.ExportDatadir(tables, dopts)
+	if cfg.verbose {
+		fmt.Fprintf(os.Stderr, "Pool: %d workers ran %d tasks (%d stolen), busy %v, idle %v\n",
+			st.Workers, st.Tasks, st.Steals, st.Busy.Round(time.Millisecond), st.Idle.Round(time.Millisecond))
+	}
+	printThrottleStats(th)
+	if err == nil && manifestErrs > 0 {
+		err = fmt.Errorf("%d manifests could not be written", manifestErrs)
+	}
+	if err != nil {
+		return err
+	}
+	fmt.Fprintf(os.Stderr, "Exported %d rows from %d tables to %s\n", st.Rows, st.Tables, cfg.outPath)
+	return nil
+}
+
+// findTables lists the .ibd files under dir whose CREATE TABLE is found in
+// schemaDir, as db/t.sql or t.sql for db/t.ibd. Tablespaces without one
+// (system and undo tablespaces, tables not asked for) are skipped with a
+// warning.
+func findTables(dir, schemaDir string) ([]export.TableSource, error) {
+	var tables []export.TableSource
+	err := filepath.WalkDir(dir, func(path string, d fs.DirEntry, err error) error {
+		if err != nil {
+			return err
+		}
+		if d.IsDir() || !strings.HasSuffix(d.Name(), ".ibd") {
+			return nil
+		}
+		rel, err := filepath.Rel(dir, path)
+		if err != nil {
+			return err
+		}
+		name := filepath.ToSlash(strings.TrimSuffix(rel, ".ibd"))
+		sqlPath := filepath.Join(schemaDir, filepath.FromSlash(name)+".sql")
+		if _, err := os.Stat(sqlPath); err != nil {
+			sqlPath = filepath.Join(schemaDir, strings.TrimSuffix(d.Name(), ".ibd")+".sql")
+		}
+		td, err := schema.ParseTableDefFromSQLFile(sqlPath)
+		if err != nil {
+			if errors.Is(err, fs.ErrNotExist) {
+				fmt.Fprintf(os.Stderr, "Skipping %s: no schema\n", name)
+			} else {
+				fmt.Fprintf(os.Stderr, "Skipping %s: %v\n", name, err)
+			}
+			return nil
+		}
+		tables = append(tables, export.TableSource{Name: name, Path: path, Def: td})
+		return nil
+	})
+	return tables, err
+}
@@ -0,0 +1,432 @@
+package main
+
+import (
+	"bufio"
+	"encoding/json"
+	"fmt"
+	"io"
+	"os"
+	"path/filepath"
+	"strconv"
+	"strings"
+	"text/tabwriter"
+	"time"
+
+	"github.com/wilhasse/go-innodb/charset"
+	"github.com/wilhasse/go-innodb/export"
+	"github.com/wilhasse/go-innodb/scan"
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// exportConfig holds the -export command line options
+type exportConfig struct {
+	format    string
+	outPath   string
+	header    bool
+	charset   string
+	csPolicy  string // -charset-policy
+	rowGroup  int
+	compress  string
+	level     int
+	blockSize int
+	shards    int
+	resume    bool
+	budget    *scan.Budget // -mem-limit, nil if unlimited
+	verify    bool
+	stages    string // -stage-workers
+	verbose   bool
+}
+
+// runExport writes every row of the table in f, read through src, to
+// cfg.outPath (stdout if empty), in primary key order. With cfg.shards > 1
+// the table is split into that many key ranges written to separate files,
+// plus a manifest.
+func runExport(f *os.File, src io.ReaderAt, tableDef *schema.TableDef, cfg exportConfig) error {
+	if tableDef == nil {
+		return fmt.Errorf("-export requires -sql")
+	}
+	opts, blocks, err := exportOptions(cfg)
+	if err != nil {
+		return err
+	}
+	fmtKind := opts.Format
+	st, err := f.Stat()
+	if err != nil {
+		return err
+	}
+
+	// Plain text exports to a file keep a checkpoint next to it, so an
+	// interrupted export can be continued with -resume
+	resumable := cfg.outPath != "" && !fmtKind.Columnar() && !blocks && cfg.shards <= 1
+	if cfg.resume && !resumable {
+		return fmt.Errorf("-resume requires -o and an uncompressed, unsharded csv, tsv or ndjson export")
+	}
+	if cfg.shards > 1 {
+		return runShardedExport(src, st.Size(), tableDef, opts, cfg, blocks)
+	}
+
+	statePath := cfg.outPath + ".ckpt"
+	if cfg.resume {
+		if opts.Resume, err = export.LoadCheckpoint(statePath); err != nil {
+			return fmt.Errorf("cannot resume: %w", err)
+		}
+		if opts.Resume.Done {
+			fmt.Fprintf(os.Stderr, "Export to %s already completed\n", cfg.outPath)
+			return os.Remove(statePath)
+		}
+	}
+	s, err := openSink(cfg.outPath, blocks, cfg, opts.Resume)
+	if err != nil {
+		return err
+	}
+	if resumable {
+		opts.OnCheckpoint = func(cp *export.Checkpoint) error {
+			// The output must be on disk before the checkpoint says so
+			if err := s.bf.Flush(); err != nil {
+				return err
+			}
+			if err := s.f.Sync(); err != nil {
+				return err
+			}
+			return cp.Save(statePath)
+		}
+	}
+	stats, err := export.ExportTable(s.w, src, st.Size(), tableDef, opts)
+	if cerr := s.finish(); err == nil {
+		err = cerr
+	}
+	if err != nil || cfg.outPath == "" {
+		return err
+	}
+	if resumable {
+		if err := os.Remove(statePath); err != nil {
+			return err
+		}
+	}
+	if cfg.verbose {
+		printStageStats(stats.Stages)
+	}
+	verb := "Exported"
+	if opts.Resume != nil {
+		verb = fmt.Sprintf("Resumed after %d rows; exported", opts.Resume.Rows)
+	}
+	fmt.Fprintf(os.Stderr, "%s %d rows from %d leaf pages (%s) to %s\n",
+		verb, stats.Rows, stats.Pages, s.describe(stats), cfg.outPath)
+	return nil
+}
+
+// exportOptions builds the export options of cfg. blocks reports that the
+// output is compressed as a whole by parallel gzip blocks (see openSink)
+// rather than by the format.
+func exportOptions(cfg exportConfig) (opts export.Options, blocks bool, err error) {
+	fmtKind, err := export.ParseFormat(cfg.format)
+	if err != nil {
+		return opts, false, err
+	}
+	codec, err := export.ParseCodec(cfg.compress)
+	if err != nil {
+		return opts, false, err
+	}
+	opts = export.Options{
+		Format:       fmtKind,
+		Header:       cfg.header,
+		RowGroupRows: cfg.rowGroup,
+		Codec:        codec,
+		Level:        cfg.level,
+		Budget:       cfg.budget,
+
+		VerifyChecksums: cfg.verify,
+	}
+	if opts.StageWorkers, err = parseStageWorkers(cfg.stages); err != nil {
+		return opts, false, err
+	}
+	if opts.CharsetPolicy, err = charset.ParsePolicy(cfg.csPolicy); err != nil {
+		return opts, false, err
+	}
+	if cfg.charset != "" {
+		opts.Conv = charset.NewConverter(cfg.charset, opts.CharsetPolicy)
+	}
+	// Parquet compresses its pages; any other format is compressed as a
+	// whole by parallel gzip blocks
+	blocks = codec == export.Gzip && fmtKind != export.Parquet
+	if blocks {
+		opts.Codec = export.Uncompressed
+	}
+	return opts, blocks, nil
+}
+
+// runShardedExport writes cfg.shards files named after cfg.outPath
+// (table.csv becomes table.000.csv, table.001.csv, ...) and a
+// table.manifest.json listing their key ranges
+func runShardedExport(src io.ReaderAt, size int64, tableDef *schema.TableDef, opts export.Options, cfg exportConfig, blocks bool) error {
+	if cfg.outPath == "" {
+		return fmt.Errorf("-shards requires -o")
+	}
+	dir, base := filepath.Split(cfg.outPath)
+	stem, ext := base, ""
+	if i := strings.IndexByte(base, '.'); i > 0 {
+		stem, ext = base[:i], base[i:]
+	}
+
+	sinks := make([]*sink, cfg.shards)
+	ws := make([]io.Writer, cfg.shards)
+	var err error
+	for i := range sinks {
+		path := filepath.Join(dir, fmt.Sprintf("%s.%03d%s", stem, i, ext))
+		if sinks[i], err = openSink(path, blocks, cfg, nil); err != nil {
+			for _, s := range sinks[:i] {
+				s.finish()
+			}
+			return err
+		}
+		ws[i] = sinks[i].w
+	}
+	shards, err := export.ExportShards(ws, src, size, tableDef, opts)
+	for _, s := range sinks {
+		if cerr := s.finish(); err == nil {
+			err = cerr
+		}
+	}
+	if err != nil {
+		return err
+	}
+
+	files := make([]string, len(sinks))
+	var rows int64
+	for i, s := range sinks {
+		files[i] = filepath.Base(s.path)
+		rows += shards[i].Rows
+	}
+	mPath := filepath.Join(dir, stem+".manifest.json")
+	if err := writeManifest(mPath, tableDef, cfg.format, shards, files); err != nil {
+		return err
+	}
+	if cfg.verbose {
+		// Every shard runs the same stages
+		var total []scan.StageStats
+		for _, sh := range shards {
+			for i, ss := range sh.Stages {
+				if i == len(total) {
+					total = append(total, scan.StageStats{Name: ss.Name})
+				}
+				total[i].Workers += ss.Workers
+				total[i].Batches += ss.Batches
+				total[i].Pages += ss.Pages
+				total[i].Busy += ss.Busy
+				total[i].Idle += ss.Idle
+			}
+		}
+		printStageStats(total)
+	}
+	fmt.Fprintf(os.Stderr, "Exported %d rows in %d shards, manifest %s\n", rows, len(shards), mPath)
+	return nil
+}
+
+// writeManifest writes the manifest of a table exported as key ranges,
+// shards[i] having been written to files[i]
+func writeManifest(path string, tableDef *schema.TableDef, format string, shards []export.Shard, files []string) error {
+	// Loaders read a shard's range as [first_key, next shard's first_key)
+	type manifestShard struct {
+		File      string          `json:"file"`
+		Rows      int64           `json:"rows"`
+		Pages     int             `json:"pages"`
+		Bytes     int64           `json:"bytes"`
+		FirstPage uint32          `json:"first_page"`
+		LastPage  uint32          `json:"last_page"`
+		FirstKey  json.RawMessage `json:"first_key"`
+		EndKey    json.RawMessage `json:"end_key"`
+	}
+	manifest := struct {
+		Table      string          `json:"table"`
+		Format     string          `json:"format"`
+		PrimaryKey []string        `json:"primary_key"`
+		Shards     []manifestShard `json:"shards"`
+	}{Table: tableDef.Name, Format: format}
+	for _, col := range tableDef.PrimaryKeyColumns() {
+		manifest.PrimaryKey = append(manifest.PrimaryKey, col.Name)
+	}
+	for i, sh := range shards {
+		m := manifestShard{
+			File:      files[i],
+			Rows:      sh.Rows,
+			Pages:     sh.Pages,
+			Bytes:     sh.Bytes,
+			FirstPage: sh.FirstPage,
+			LastPage:  sh.LastPage,
+			FirstKey:  rawOrNull(sh.FirstKey),
+			EndKey:    json.RawMessage("null"),
+		}
+		// The end of a range is the first key of the next non-empty one
+		for _, next := range shards[i+1:] {
+			if next.FirstKey != nil {
+				m.EndKey = next.FirstKey
+				break
+			}
+		}
+		manifest.Shards = append(manifest.Shards, m)
+	}
+	mf, err := os.Create(path)
+	if err != nil {
+		return err
+	}
+	enc := json.NewEncoder(mf)
+	enc.SetIndent("", "  ")
+	if err := enc.Encode(manifest); err != nil {
+		mf.Close()
+		return err
+	}
+	return mf.Close()
+}
+
+// parseStageWorkers parses -stage-workers, a list of stage=goroutines
+// pairs such as "read=2,encode=6"
+func parseStageWorkers(spec string) (map[string]int, error) {
+	if spec == "" {
+		return nil, nil
+	}
+	m := map[string]int{}
+	for _, kv := range strings.Split(spec, ",") {
+		name, val, ok := strings.Cut(kv, "=")
+		n, err := strconv.Atoi(val)
+		if !ok || err != nil || n < 0 {
+			return nil, fmt.Errorf("invalid -stage-workers entry %q (want stage=N)", kv)
+		}
+		switch name {
+		case "read", "checksum", "parse", "filter", "encode", "decode":
+		default:
+			return nil, fmt.Errorf("unknown stage %q (want read, checksum, parse, filter, encode or decode)", name)
+		}
+		m[name] = n
+	}
+	return m, nil
+}
+
+// printStageStats reports the time spent in each stage of the export
+// pipeline, to help choose -stage-workers
+func printStageStats(stages []scan.StageStats) {
+	w := tabwriter.NewWriter(os.Stderr, 0, 0, 2, ' ', 0)
+	fmt.Fprintln(w, "Stage\tWorkers\tBatches\tBusy\tIdle")
+	for _, ss := range stages {
+		fmt.Fprintf(w, "%s\t%d\t%d\t%v\t%v\n", ss.Name, ss.Workers, ss.Batches,
+			ss.Busy.Round(time.Millisecond), ss.Idle.Round(time.Millisecond))
+	}
+	w.Flush()
+}
+
+func rawOrNull(b []byte) json.RawMessage {
+	if b == nil {
+		return json.RawMessage("null")
+	}
+	return b
+}
+
+// sink is one export output file (or stdout), optionally compressed in
+// parallel gzip blocks
+type sink struct {
+	path string
+	f    *os.File
+	w    io.Writer
+	bw   *export.BlockWriter
+	bf   *bufio.Writer
+}
+
+// openSink creates path (stdout if empty), or reopens it to continue at
+// the offset of resume, dropping anything written after the checkpoint.
+// Export chunks are already large, so the block writer (or the buffer)
+// only has to merge small ones.
+func openSink(path string, blocks bool, cfg exportConfig, resume *export.Checkpoint) (*sink, error) {
+	s := &sink{path: path, f: os.Stdout}
+	var err error
+	switch {
+	case path != "" && resume != nil:
+		if s.f, err = os.OpenFile(path, os.O_WRONLY, 0); err != nil {
+			return nil, err
+		}
+		if err := s.truncate(resume.Bytes); err != nil {
+			s.close()
+			return nil, fmt.Errorf("cannot resume %s: %w", path, err)
+		}
+	case path != "":
+		if s.f, err = os.Create(path); err != nil {
+			return nil, err
+		}
+	}
+	if blocks {
+		s.bw, err = export.NewBlockWriter(s.f, export.BlockOptions{Level: cfg.level, BlockSize: cfg.blockSize, Budget: cfg.budget})
+		if err != nil {
+			s.close()
+			return nil, err
+		}
+		s.w = s.bw
+	} else {
+		s.bf = bufio.NewWriterSize(s.f, 1<<20)
+		s.w = s.bf
+	}
+	return s, nil
+}
+
+// Write and Close let a sink serve as an export.DatadirOptions output
+func (s *sink) Write(p []byte) (int, error) { return s.w.Write(p) }
+func (s *sink) Close() error                { return s.finish() }
+
+// finish flushes the output, writes the .gzi member index of a compressed
+// file next to it and closes the file
+func (s *sink) finish() error {
+	var err error
+	if s.bw != nil {
+		err = s.bw.Close()
+	} else {
+		err = s.bf.Flush()
+	}
+	if err == nil && s.bw != nil && s.path != "" {
+		err = writeIndex(s.path+".gzi", s.bw.Index())
+	}
+	if cerr := s.close(); err == nil {
+		err = cerr
+	}
+	return err
+}
+
+// truncate cuts the file to n bytes and positions writes there
+func (s *sink) truncate(n int64) error {
+	fi, err := s.f.Stat()
+	if err != nil {
+		return err
+	}
+	if fi.Size() < n {
+		return fmt.Errorf("file has %d bytes, checkpoint needs %d", fi.Size(), n)
+	}
+	if err := s.f.Truncate(n); err != nil {
+		return err
+	}
+	_, err = s.f.Seek(n, io.SeekStart)
+	return err
+}
+
+func (s *sink) close() error {
+	if s.path == "" {
+		return nil
+	}
+	return s.f.Close()
+}
+
+// describe summarizes the bytes written for the export message
+func (s *sink) describe(st export.Stats) string {
+	if s.bw == nil {
+		return fmt.Sprintf("%d bytes", st.Bytes)
+	}
+	return fmt.Sprintf("%d bytes, %d compressed in %d blocks", st.Bytes, s.bw.CompressedBytes(), len(s.bw.Index()))
+}
+
+// writeIndex lets readers seek into a block-compressed output
+func writeIndex(path string, idx []export.BlockIndexEntry) error {
+	f, err := os.Create(path)
+	if err != nil {
+		return err
+	}
+	if err := export.WriteGzipIndex(f, idx); err != nil {
+		f.Close()
+		return err
+	}
+	return f.Close()
+}
@@ -0,0 +1,38 @@
+//go:build linux
+
+package main
+
+import (
+	"os"
+	"strconv"
+	"syscall"
+)
+
+// ioprioWhoProcess selects a single thread in ioprio_set(2)
+const ioprioWhoProcess = 1
+
+// setIOPriority sets the I/O scheduling class of every thread of the
+// process. Threads the Go runtime starts later inherit it from the thread
+// that creates them. Only schedulers that honor priorities (BFQ, CFQ)
+// act on it.
+func setIOPriority(spec string) error {
+	class, level, err := parseIOPriority(spec)
+	if err != nil {
+		return err
+	}
+	prio := uintptr(class<<13 | level)
+	tasks, err := os.ReadDir("/proc/self/task")
+	if err != nil {
+		return err
+	}
+	for _, t := range tasks {
+		tid, err := strconv.Atoi(t.Name())
+		if err != nil {
+			continue
+		}
+		if _, _, e := syscall.Syscall(syscall.SYS_IOPRIO_SET, ioprioWhoProcess, uintptr(tid), prio); e != 0 {
+			return e
+		}
+	}
+	return nil
+}
@@ -0,0 +1,13 @@
+//go:build !linux
+
+package main
+
+import "fmt"
+
+// setIOPriority is only implemented on Linux
+func setIOPriority(spec string) error {
+	if _, _, err := parseIOPriority(spec); err != nil {
+		return err
+	}
+	return fmt.Errorf("I/O priorities are not supported on this platform")
+}
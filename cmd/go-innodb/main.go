@@ -1,28 +1,55 @@
 package main
 
 import (
-	"encoding/json"
+	"bufio"
 	"flag"
 	"fmt"
 	"os"
+	"strconv"
 	"strings"
 	"text/tabwriter"
 
 	goinnodb "github.com/wilhasse/go-innodb"
+	"github.com/wilhasse/go-innodb/export"
 	"github.com/wilhasse/go-innodb/record"
 	"github.com/wilhasse/go-innodb/schema"
 )
 
 func main() {
 	var (
-		file      = flag.String("file", "", "Path to InnoDB data file (required)")
+		file      = flag.String("file", "", "Path to InnoDB data file (required unless -datadir)")
 		pageNum   = flag.Uint("page", 0, "Page number to read (default: 0)")
-		format    = flag.String("format", "text", "Output format: text, json, or summary")
+		format    = flag.String("format", "text", "Output format: text, json (NDJSON: page line, then one line per record), or summary")
 		showRecs  = flag.Bool("records", false, "Show all records in the page")
 		maxRecs   = flag.Int("max-records", 100, "Maximum records to display")
 		verbose   = flag.Bool("v", false, "Verbose output")
 		sqlFile   = flag.String("sql", "", "Path to SQL file with CREATE TABLE statement")
 		parseData = flag.Bool("parse", false, "Parse column data using table schema")
+		exportFmt = flag.String("export", "", "Export the whole table as csv, tsv, ndjson, parquet, arrow (file) or arrows (stream) in primary key order (requires -sql)")
+		outFile   = flag.String("o", "", "With -export, output file (default: stdout)")
+		header    = flag.Bool("header", true, "With -export, write a header line")
+		srcCs     = flag.String("charset", "", "With -export, convert strings from this charset (e.g. latin1) to UTF-8 (default: each column's declared charset; utf8mb4 is validated)")
+		csPolicy  = flag.String("charset-policy", "replace", "With -export, invalid UTF-8 in string columns: replace (with U+FFFD) or error")
+		rowGroup  = flag.Int("row-group", 1<<20, "With -export parquet/arrow, rows per row group or record batch")
+		compress  = flag.String("compress", "none", "With -export, compression: none or gzip (parquet pages; other formats as parallel gzip blocks with a .gzi index next to -o)")
+		level     = flag.Int("compress-level", 0, "With -compress gzip, gzip level 1-9 (0: default)")
+		blockSize = flag.Int("block-size", 4<<20, "With -compress gzip and a non-parquet format, input bytes per gzip block")
+		resume    = flag.Bool("resume", false, "With -export csv/tsv/ndjson -o, continue an interrupted export from its <out>.ckpt checkpoint")
+		shards    = flag.Int("shards", 1, "With -export and -o, split the table into this many primary key ranges written concurrently to numbered files, plus a manifest")
+		verify    = flag.Bool("verify-checksums", false, "With -export, fail on the first leaf page whose checksum does not match")
+		stageWork = flag.String("stage-workers", "", "With -export, fix the goroutines of pipeline stages, e.g. read=2,encode=6 (others are auto-tuned; -v prints stage timings)")
+		memLimit  = flag.String("mem-limit", "", "With -export, bound the memory of buffers in flight to this many bytes (K, M, G suffixes), e.g. 2G")
+		carve     = flag.Bool("carve", false, "Treat -file as a raw disk image and carve INDEX pages from it")
+		carveOut  = flag.String("carve-out", "", "With -carve, write recovered pages to <dir>/space_<id>.ibd")
+		align     = flag.Int("align", 512, "With -carve, step in bytes between candidate page starts")
+		readRate  = flag.String("read-rate", "", "Limit reads to this many bytes/s (K, M, G suffixes), e.g. 200M")
+		readIOPS  = flag.Int("read-iops", 0, "Limit reads to this many operations/s")
+		readLat   = flag.Duration("read-latency", 0, "Adaptive throttling: back off while p99 read latency exceeds this, e.g. 20ms")
+		ionice    = flag.String("ionice", "", "I/O scheduling class for reads: idle, be:0-7 or rt:0-7 (Linux)")
+		datadir   = flag.String("datadir", "", "Export every tablespace under this directory that has a schema in -schema-dir, with -export and -o (an output directory)")
+		schemaDir = flag.String("schema-dir", "", "With -datadir, directory of CREATE TABLE files: <db>/<table>.sql or <table>.sql")
+		partSize  = flag.String("part-size", "1G", "With -datadir, split tables into primary key ranges of about this many bytes of leaf pages, exported in parallel to numbered files")
+		chains    = flag.Bool("chains", false, "Rebuild leaf chains from page headers (no B-tree descent); with -records -sql -parse, dump their rows")
 	)
 
 	flag.Usage = func() {
@@ -34,12 +61,67 @@ func main() {
 		fmt.Fprintf(os.Stderr, "  %s -file data.ibd -page 3\n", os.Args[0])
 		fmt.Fprintf(os.Stderr, "  %s -file data.ibd -page 3 -format json\n", os.Args[0])
 		fmt.Fprintf(os.Stderr, "  %s -file data.ibd -page 3 -records\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "  %s -file data.ibd -chains -records -sql table.sql -parse\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "  %s -file /dev/sdb1 -carve -carve-out recovered\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "  %s -file data.ibd -sql table.sql -export csv -o table.csv\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "  %s -file data.ibd -sql table.sql -export parquet -compress gzip -o table.parquet\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "  %s -file data.ibd -sql table.sql -export csv -compress gzip -o table.csv.gz\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "  %s -file data.ibd -sql table.sql -export parquet -shards 8 -o out/table.parquet\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "  %s -file data.ibd -sql table.sql -export csv -o t.csv -read-rate 100M -read-latency 20ms -ionice idle\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "  %s -file data.ibd -sql table.sql -export parquet -mem-limit 2G -o table.parquet\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "  %s -datadir /backup/mysql -schema-dir schemas -export parquet -o out\n", os.Args[0])
 	}
 
 	flag.Parse()
 
+	cfg := exportConfig{
+		format:    *exportFmt,
+		outPath:   *outFile,
+		header:    *header,
+		charset:   *srcCs,
+		csPolicy:  *csPolicy,
+		rowGroup:  *rowGroup,
+		compress:  *compress,
+		level:     *level,
+		blockSize: *blockSize,
+		shards:    *shards,
+		resume:    *resume,
+		verify:    *verify,
+		stages:    *stageWork,
+		verbose:   *verbose,
+	}
+	thCfg := throttleConfig{
+		rate:    *readRate,
+		iops:    *readIOPS,
+		latency: *readLat,
+		ionice:  *ionice,
+	}
+
+	if *datadir != "" {
+		if *exportFmt == "" {
+			fmt.Fprintf(os.Stderr, "Error: -datadir requires -export\n")
+			os.Exit(1)
+		}
+		var err error
+		if cfg.budget, err = parseMemLimit(*memLimit); err != nil {
+			fmt.Fprintf(os.Stderr, "Error: -mem-limit: %v\n", err)
+			os.Exit(1)
+		}
+		part, err := parseByteSize(*partSize)
+		if err != nil {
+			fmt.Fprintf(os.Stderr, "Error: -part-size: %v\n", err)
+			os.Exit(1)
+		}
+		if err := runDatadirExport(*datadir, *schemaDir, part, cfg, thCfg); err != nil {
+			fmt.Fprintf(os.Stderr, "Error exporting datadir: %v\n", err)
+			os.Exit(1)
+		}
+		printBudgetStats(cfg.budget)
+		return
+	}
+
 	if *file == "" {
-		fmt.Fprintf(os.Stderr, "Error: -file is required\n\n")
+		fmt.Fprintf(os.Stderr, "Error: -file or -datadir is required\n\n")
 		flag.Usage()
 		os.Exit(1)
 	}
@@ -52,6 +134,14 @@ func main() {
 	}
 	defer f.Close()
 
+	// Scans and exports read through src, which applies -read-rate,
+	// -read-iops and -read-latency
+	src, throttle, err := openSource(f, thCfg)
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error: %v\n", err)
+		os.Exit(1)
+	}
+
 	// Load table schema if provided
 	var tableDef *schema.TableDef
 	if *sqlFile != "" {
@@ -65,8 +155,40 @@ func main() {
 		}
 	}
 
+	if *exportFmt != "" {
+		if cfg.budget, err = parseMemLimit(*memLimit); err != nil {
+			fmt.Fprintf(os.Stderr, "Error: -mem-limit: %v\n", err)
+			os.Exit(1)
+		}
+		if err := runExport(f, src, tableDef, cfg); err != nil {
+			fmt.Fprintf(os.Stderr, "Error exporting table: %v\n", err)
+			os.Exit(1)
+		}
+		printThrottleStats(throttle)
+		printBudgetStats(cfg.budget)
+		return
+	}
+
+	if *carve {
+		if err := outputCarve(f, src, *align, *carveOut); err != nil {
+			fmt.Fprintf(os.Stderr, "Error carving pages: %v\n", err)
+			os.Exit(1)
+		}
+		printThrottleStats(throttle)
+		return
+	}
+
+	if *chains {
+		if err := outputChains(f, src, *showRecs, *maxRecs, tableDef, *parseData); err != nil {
+			fmt.Fprintf(os.Stderr, "Error rebuilding leaf chains: %v\n", err)
+			os.Exit(1)
+		}
+		printThrottleStats(throttle)
+		return
+	}
+
 	// Create page reader
-	reader := goinnodb.NewPageReader(f)
+	reader := goinnodb.NewPageReader(src)
 
 	// Read the page
 	page, err := reader.ReadPage(uint32(*pageNum))
@@ -78,7 +200,10 @@ func main() {
 	// Output based on format
 	switch *format {
 	case "json":
-		outputJSON(page, *showRecs, *maxRecs, tableDef, *parseData)
+		if err := outputJSON(page, *showRecs, *maxRecs, tableDef, *parseData); err != nil {
+			fmt.Fprintf(os.Stderr, "Error writing JSON: %v\n", err)
+			os.Exit(1)
+		}
 	case "summary":
 		outputSummary(page)
 	default:
@@ -147,27 +272,26 @@ func outputText(page *goinnodb.InnerPage, showRecs bool, maxRecs int, verbose bo
 			if parseData && tableDef != nil {
 				// Use compact parser to parse records with column values
 				parser := record.NewCompactParser(tableDef)
-				parsedRecords := make([]goinnodb.GenericRecord, 0)
+				batch := record.AcquireBatch()
+				defer batch.Release()
 
-				// Walk and parse each record
-				rawRecords, err := goinnodb.WalkRecords(indexPage, maxRecs, true)
+				// Walk the record chain and parse each record in place
+				err := indexPage.ForEachRecord(true, func(pos int, hdr goinnodb.RecordHeader) bool {
+					if batch.Len() >= maxRecs {
+						return false
+					}
+					rec := batch.Next()
+					if err := parser.ParseRecordInto(rec, indexPage.Inner.Data, pos, indexPage.IsLeaf()); err != nil {
+						// Fall back to the bare header if parsing fails
+						*rec = goinnodb.GenericRecord{Header: hdr, PrimaryKeyPos: pos}
+					}
+					rec.PageNumber = page.PageNo
+					return batch.Len() < maxRecs
+				})
 				if err != nil {
 					fmt.Printf("  Error walking records: %v\n", err)
-				} else {
-					for _, rawRec := range rawRecords {
-						// Re-parse with column data
-						parsedRec, err := parser.ParseRecord(indexPage.Inner.Data, rawRec.PrimaryKeyPos, indexPage.IsLeaf())
-						if err != nil {
-							// Fall back to raw record if parsing fails
-							parsedRecords = append(parsedRecords, rawRec)
-						} else {
-							// Copy metadata from raw record
-							parsedRec.PageNumber = rawRec.PageNumber
-							parsedRecords = append(parsedRecords, *parsedRec)
-						}
-					}
-					records = parsedRecords
 				}
+				records = batch.Records
 			} else {
 				// Use standard walk without parsing
 				records, err = goinnodb.WalkRecords(indexPage, maxRecs, true)
@@ -246,90 +370,144 @@ func outputText(page *goinnodb.InnerPage, showRecs bool, maxRecs int, verbose bo
 }
 
 func outputSummary(page *goinnodb.InnerPage) {
+	v := page.View()
 	fmt.Printf("Page %d: Type=%s, Space=%d, LSN=%d",
-		page.PageNo, pageTypeName(page.FIL.PageType),
-		page.FIL.SpaceID, page.FIL.LastModLSN)
+		page.PageNo, pageTypeName(v.PageType()),
+		v.SpaceID(), v.LastModLSN())
 
-	if page.FIL.PageType == goinnodb.PageTypeIndex {
-		if indexPage, err := goinnodb.ParseIndexPage(page); err == nil {
-			fmt.Printf(", Records=%d, Level=%d, IndexID=%d",
-				indexPage.Hdr.NumUserRecs,
-				indexPage.Hdr.PageLevel,
-				indexPage.Hdr.IndexID)
-		}
+	if v.IsIndex() && v.Format() == goinnodb.FormatCompact {
+		fmt.Printf(", Records=%d, Level=%d, IndexID=%d",
+			v.NumUserRecs(), v.PageLevel(), v.IndexID())
 	}
 	fmt.Println()
 }
 
-func outputJSON(page *goinnodb.InnerPage, showRecs bool, maxRecs int, tableDef *schema.TableDef, parseData bool) {
-	output := map[string]interface{}{
-		"page_number": page.PageNo,
-		"fil_header": map[string]interface{}{
-			"checksum":       page.FIL.Checksum,
-			"page_number":    page.FIL.PageNumber,
-			"page_type":      page.FIL.PageType,
-			"page_type_name": pageTypeName(page.FIL.PageType),
-			"space_id":       page.FIL.SpaceID,
-			"lsn":            page.FIL.LastModLSN,
-			"flush_lsn":      page.FIL.FlushLSN,
-			"prev":           page.FIL.Prev,
-			"next":           page.FIL.Next,
-		},
-		"fil_trailer": map[string]interface{}{
-			"checksum":  page.Trailer.Checksum,
-			"low32_lsn": page.Trailer.Low32LSN,
-		},
+// outputJSON writes the page as newline-delimited JSON: one object with the
+// FIL header, trailer and index header, then with -records one object per
+// record, written as the record is walked. Each line is appended to a reused
+// buffer with constant keys and parsed values go through the export
+// package's NDJSON encoder, so memory does not grow with the record count.
+func outputJSON(page *goinnodb.InnerPage, showRecs bool, maxRecs int, tableDef *schema.TableDef, parseData bool) error {
+	w := bufio.NewWriter(os.Stdout)
+	b := make([]byte, 0, 4096)
+
+	b = jsonUint(append(b, '{'), `"page_number":`, uint64(page.PageNo))
+	b = jsonUint(b, `,"fil_header":{"checksum":`, uint64(page.FIL.Checksum))
+	b = jsonUint(b, `,"page_number":`, uint64(page.FIL.PageNumber))
+	b = jsonUint(b, `,"page_type":`, uint64(page.FIL.PageType))
+	b = jsonString(b, `,"page_type_name":`, pageTypeName(page.FIL.PageType))
+	b = jsonUint(b, `,"space_id":`, uint64(page.FIL.SpaceID))
+	b = jsonUint(b, `,"lsn":`, page.FIL.LastModLSN)
+	b = jsonUint(b, `,"flush_lsn":`, page.FIL.FlushLSN)
+	b = jsonPageRef(b, `,"prev":`, page.FIL.Prev)
+	b = jsonPageRef(b, `,"next":`, page.FIL.Next)
+	b = jsonUint(b, `},"fil_trailer":{"checksum":`, uint64(page.Trailer.Checksum))
+	b = jsonUint(b, `,"low32_lsn":`, uint64(page.Trailer.Low32LSN))
+	b = append(b, '}')
+
+	var indexPage *goinnodb.IndexPage
+	if page.FIL.PageType == goinnodb.PageTypeIndex {
+		var err error
+		if indexPage, err = goinnodb.ParseIndexPage(page); err == nil {
+			h := &indexPage.Hdr
+			b = jsonUint(b, `,"index_page":{"format":`, uint64(h.Format))
+			b = jsonString(b, `,"format_name":`, formatName(h.Format))
+			b = jsonUint(b, `,"user_records":`, uint64(h.NumUserRecs))
+			b = jsonUint(b, `,"heap_records":`, uint64(h.NumHeapRecs))
+			b = jsonUint(b, `,"dir_slots":`, uint64(h.NumDirSlots))
+			b = jsonUint(b, `,"heap_top":`, uint64(h.HeapTop))
+			b = jsonUint(b, `,"garbage_space":`, uint64(h.GarbageSpace))
+			b = jsonUint(b, `,"page_level":`, uint64(h.PageLevel))
+			b = jsonBool(b, `,"is_leaf":`, indexPage.IsLeaf())
+			b = jsonBool(b, `,"is_root":`, indexPage.IsRoot())
+			b = jsonUint(b, `,"index_id":`, h.IndexID)
+			b = jsonUint(b, `,"max_trx_id":`, h.MaxTrxID)
+			b = jsonUint(b, `,"used_bytes":`, uint64(indexPage.UsedBytes()))
+			b = append(b, '}')
+		} else {
+			b = jsonString(b, `,"index_error":`, err.Error())
+		}
+	}
+	if _, err := w.Write(append(b, '}', '\n')); err != nil {
+		return err
 	}
 
-	if page.FIL.PageType == goinnodb.PageTypeIndex {
-		if indexPage, err := goinnodb.ParseIndexPage(page); err == nil {
-			indexData := map[string]interface{}{
-				"format":        indexPage.Hdr.Format,
-				"format_name":   formatName(indexPage.Hdr.Format),
-				"user_records":  indexPage.Hdr.NumUserRecs,
-				"heap_records":  indexPage.Hdr.NumHeapRecs,
-				"dir_slots":     indexPage.Hdr.NumDirSlots,
-				"heap_top":      indexPage.Hdr.HeapTop,
-				"garbage_space": indexPage.Hdr.GarbageSpace,
-				"page_level":    indexPage.Hdr.PageLevel,
-				"is_leaf":       indexPage.IsLeaf(),
-				"is_root":       indexPage.IsRoot(),
-				"index_id":      indexPage.Hdr.IndexID,
-				"max_trx_id":    indexPage.Hdr.MaxTrxID,
-				"used_bytes":    indexPage.UsedBytes(),
-			}
+	if showRecs && indexPage != nil {
+		var parser *record.CompactParser
+		var rec goinnodb.GenericRecord
+		enc := export.Encoder{Format: export.NDJSON}
+		if parseData && tableDef != nil {
+			parser = record.NewCompactParser(tableDef)
+			parser.SetZeroCopy(true)
+		}
 
-			if showRecs {
-				if records, err := goinnodb.WalkRecords(indexPage, maxRecs, true); err == nil {
-					recData := make([]map[string]interface{}, len(records))
-					for i, rec := range records {
-						recData[i] = map[string]interface{}{
-							"heap_number": rec.Header.HeapNumber,
-							"type":        rec.Header.Type,
-							"type_name":   recordTypeName(rec.Header.Type),
-							"deleted":     rec.Header.FlagsDeleted,
-							"min_rec":     rec.Header.FlagsMinRec,
-							"num_owned":   rec.Header.NumOwned,
-							"next_offset": rec.Header.NextRecOffset,
-							"position":    rec.PrimaryKeyPos,
-						}
+		n := 0
+		var writeErr error
+		err := indexPage.ForEachRecord(true, func(pos int, hdr goinnodb.RecordHeader) bool {
+			if n >= maxRecs {
+				return false
+			}
+			b = jsonUint(append(b[:0], '{'), `"page_number":`, uint64(page.PageNo))
+			b = jsonUint(b, `,"record":`, uint64(n))
+			b = jsonUint(b, `,"heap_number":`, uint64(hdr.HeapNumber))
+			b = jsonUint(b, `,"type":`, uint64(hdr.Type))
+			b = jsonString(b, `,"type_name":`, recordTypeName(hdr.Type))
+			b = jsonBool(b, `,"deleted":`, hdr.FlagsDeleted)
+			b = jsonBool(b, `,"min_rec":`, hdr.FlagsMinRec)
+			b = jsonUint(b, `,"num_owned":`, uint64(hdr.NumOwned))
+			b = strconv.AppendInt(append(b, `,"next_offset":`...), int64(hdr.NextRecOffset), 10)
+			b = jsonUint(b, `,"position":`, uint64(pos))
+			if parser != nil {
+				// A record that fails to parse keeps its header fields
+				if err := parser.ParseRecordInto(&rec, indexPage.Inner.Data, pos, indexPage.IsLeaf()); err != nil {
+					b = jsonString(b, `,"parse_error":`, err.Error())
+				} else {
+					var err error
+					if b, err = enc.AppendObject(append(b, `,"values":`...), tableDef.Columns, &rec); err != nil {
+						writeErr = err
+						return false
 					}
-					indexData["records"] = recData
 				}
 			}
-
-			output["index_page"] = indexData
-		} else {
-			output["index_error"] = err.Error()
+			if _, writeErr = w.Write(append(b, '}', '\n')); writeErr != nil {
+				return false
+			}
+			n++
+			return n < maxRecs
+		})
+		if writeErr != nil {
+			return writeErr
+		}
+		if err != nil {
+			b = jsonString(append(b[:0], '{'), `"error":`, err.Error())
+			if _, err := w.Write(append(b, '}', '\n')); err != nil {
+				return err
+			}
 		}
 	}
+	return w.Flush()
+}
 
-	encoder := json.NewEncoder(os.Stdout)
-	encoder.SetIndent("", "  ")
-	if err := encoder.Encode(output); err != nil {
-		fmt.Fprintf(os.Stderr, "Error encoding JSON: %v\n", err)
-		os.Exit(1)
+// jsonUint appends key, which carries its own quotes, colon and leading
+// comma, followed by v
+func jsonUint(b []byte, key string, v uint64) []byte {
+	return strconv.AppendUint(append(b, key...), v, 10)
+}
+
+func jsonBool(b []byte, key string, v bool) []byte {
+	return strconv.AppendBool(append(b, key...), v)
+}
+
+func jsonString(b []byte, key string, v string) []byte {
+	return export.AppendJSONString(append(b, key...), []byte(v))
+}
+
+// jsonPageRef appends a FIL prev/next pointer, null when unset
+func jsonPageRef(b []byte, key string, p *uint32) []byte {
+	if p == nil {
+		return append(append(b, key...), "null"...)
 	}
+	return jsonUint(b, key, uint64(*p))
 }
 
 func pageTypeName(t goinnodb.PageType) string {
@@ -0,0 +1,141 @@
+package main
+
+import (
+	"fmt"
+	"io"
+	"os"
+	"strconv"
+	"strings"
+	"time"
+
+	"github.com/wilhasse/go-innodb/scan"
+)
+
+// throttleConfig holds the read limiting command line options
+type throttleConfig struct {
+	rate    string
+	iops    int
+	latency time.Duration
+	ionice  string
+}
+
+// openSource applies the read priority and wraps f in a scan.Throttle when
+// a limit is set. The throttle is nil when reads are unlimited.
+func openSource(f *os.File, cfg throttleConfig) (io.ReaderAt, *scan.Throttle, error) {
+	th, err := newThrottle(f, cfg)
+	if err != nil || th == nil {
+		return f, nil, err
+	}
+	return th, th, nil
+}
+
+// newThrottle applies the read priority and returns a throttle reading r
+// (nil for one shared through Throttle.Reader), or nil when reads are
+// unlimited
+func newThrottle(r io.ReaderAt, cfg throttleConfig) (*scan.Throttle, error) {
+	if cfg.ionice != "" {
+		if err := setIOPriority(cfg.ionice); err != nil {
+			return nil, fmt.Errorf("-ionice: %w", err)
+		}
+	}
+	rate, err := parseByteSize(cfg.rate)
+	if err != nil {
+		return nil, fmt.Errorf("-read-rate: %w", err)
+	}
+	if rate == 0 && cfg.iops == 0 && cfg.latency == 0 {
+		return nil, nil
+	}
+	return scan.NewThrottle(r, scan.ThrottleOptions{
+		BytesPerSec:   rate,
+		OpsPerSec:     cfg.iops,
+		TargetLatency: cfg.latency,
+	}), nil
+}
+
+// parseByteSize parses a byte count with an optional K, M or G suffix
+// (powers of 1024); "" is 0
+func parseByteSize(s string) (int64, error) {
+	if s == "" {
+		return 0, nil
+	}
+	shift := 0
+	switch strings.ToUpper(s[len(s)-1:]) {
+	case "K":
+		shift = 10
+	case "M":
+		shift = 20
+	case "G":
+		shift = 30
+	}
+	if shift > 0 {
+		s = s[:len(s)-1]
+	}
+	n, err := strconv.ParseInt(s, 10, 64)
+	if err != nil || n < 0 {
+		return 0, fmt.Errorf("invalid byte count %q", s)
+	}
+	return n << shift, nil
+}
+
+// I/O scheduling classes of ioprio_set(2)
+const (
+	ioprioClassRT   = 1
+	ioprioClassBE   = 2
+	ioprioClassIdle = 3
+)
+
+// parseIOPriority parses "idle", "be:N" or "rt:N" (N from 0, highest, to 7)
+func parseIOPriority(spec string) (class, level int, err error) {
+	if spec == "idle" {
+		return ioprioClassIdle, 0, nil
+	}
+	name, lvl, ok := strings.Cut(spec, ":")
+	if ok {
+		level, err = strconv.Atoi(lvl)
+	}
+	if !ok || err != nil || level < 0 || level > 7 {
+		return 0, 0, fmt.Errorf("invalid I/O priority %q (want idle, be:0-7 or rt:0-7)", spec)
+	}
+	switch name {
+	case "be":
+		return ioprioClassBE, level, nil
+	case "rt":
+		return ioprioClassRT, level, nil
+	}
+	return 0, 0, fmt.Errorf("invalid I/O priority %q (want idle, be:0-7 or rt:0-7)", spec)
+}
+
+// parseMemLimit returns the budget of -mem-limit, nil if unlimited
+func parseMemLimit(s string) (*scan.Budget, error) {
+	limit, err := parseByteSize(s)
+	if err != nil || limit == 0 {
+		return nil, err
+	}
+	return scan.NewBudget(limit), nil
+}
+
+// printBudgetStats reports the memory held by an export under -mem-limit
+func printBudgetStats(b *scan.Budget) {
+	if b == nil {
+		return
+	}
+	st := b.Stats()
+	fmt.Fprintf(os.Stderr, "Memory: peak %d of %d bytes, %d waits for %v\n",
+		st.Peak, st.Limit, st.Waits, st.Waited.Round(time.Millisecond))
+}
+
+// printThrottleStats reports how much the reads were held back
+func printThrottleStats(th *scan.Throttle) {
+	if th == nil {
+		return
+	}
+	st := th.Stats()
+	fmt.Fprintf(os.Stderr, "Reads: %d bytes in %d ops, delayed %v", st.Bytes, st.Ops, st.Waited.Round(time.Millisecond))
+	if st.Backoffs > 0 || st.P99 > 0 {
+		fmt.Fprintf(os.Stderr, ", p99 %v, %d backoffs", st.P99.Round(time.Microsecond), st.Backoffs)
+	}
+	if st.Limit > 0 {
+		fmt.Fprintf(os.Stderr, ", limit %d bytes/s", st.Limit)
+	}
+	fmt.Fprintln(os.Stderr)
+}
@@ -0,0 +1,451 @@
+// gen.go - Go source generation for schema-specialized record decoders
+package main
+
+import (
+	"bytes"
+	"fmt"
+	"go/format"
+	"sort"
+	"strings"
+	"unicode"
+
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// field is one column of the clustered index leaf record, in physical order
+type field struct {
+	col     *schema.Column
+	name    string // Go field name
+	goType  string
+	zero    string // zero value literal
+	varLen  bool   // length comes from a variable-length header
+	twoByte bool   // length header may take two bytes
+	size    int    // on-disk size of fixed-length values
+	lenVar  string // local holding the length of a variable-length value
+	sys     bool   // DB_ROW_ID/DB_TRX_ID/DB_ROLL_PTR, not a table column
+}
+
+type generator struct {
+	td       *schema.TableDef
+	pkg      string
+	typeName string
+	source   string
+	fields   []*field
+	imports  map[string]bool
+	decls    []string // package-level declarations (decimal layouts)
+	body     bytes.Buffer
+}
+
+// generate returns the formatted Go source of the decoder for td
+func generate(td *schema.TableDef, pkg, typeName, source string) ([]byte, error) {
+	g := &generator{
+		td: td, pkg: pkg, typeName: typeName, source: source,
+		imports: map[string]bool{"github.com/wilhasse/go-innodb/record": true},
+	}
+	if err := g.plan(); err != nil {
+		return nil, err
+	}
+	g.emitDecoder()
+
+	var out bytes.Buffer
+	fmt.Fprintf(&out, "// Code generated by innodb-gen from %s; DO NOT EDIT.\n\n", source)
+	fmt.Fprintf(&out, "package %s\n\n", pkg)
+	paths := make([]string, 0, len(g.imports))
+	for p := range g.imports {
+		paths = append(paths, p)
+	}
+	sort.Strings(paths)
+	out.WriteString("import (\n")
+	std := true
+	for _, p := range paths {
+		if std && strings.Contains(p, ".") {
+			if p != paths[0] {
+				out.WriteString("\n")
+			}
+			std = false
+		}
+		fmt.Fprintf(&out, "\t%q\n", p)
+	}
+	out.WriteString(")\n\n")
+
+	fmt.Fprintf(&out, "// %s is one row of table %s, decoded from its clustered index\n", typeName, td.Name)
+	fmt.Fprintf(&out, "// leaf record. String and binary fields reference the page buffer.\n")
+	fmt.Fprintf(&out, "type %s struct {\n", typeName)
+	for _, f := range g.fields {
+		if f.sys && f.name == "" {
+			continue
+		}
+		fmt.Fprintf(&out, "\t%s %s\n", f.name, f.goType)
+		if f.col != nil && f.col.Nullable {
+			fmt.Fprintf(&out, "\t%sNull bool\n", f.name)
+		}
+	}
+	out.WriteString("}\n\n")
+	fmt.Fprintf(&out, "var _ record.RowDecoder = (*%s)(nil)\n\n", typeName)
+	for _, d := range g.decls {
+		out.WriteString(d)
+		out.WriteString("\n")
+	}
+	out.Write(g.body.Bytes())
+
+	src, err := format.Source(out.Bytes())
+	if err != nil {
+		return out.Bytes(), fmt.Errorf("format generated code: %w", err)
+	}
+	return src, nil
+}
+
+// plan lays out the record fields in physical order: primary key (or the
+// hidden DB_ROW_ID), DB_TRX_ID + DB_ROLL_PTR, then the remaining columns
+func (g *generator) plan() error {
+	used := map[string]bool{}
+	add := func(col *schema.Column) error {
+		f, err := g.newField(col)
+		if err != nil {
+			return fmt.Errorf("column %s: %w", col.Name, err)
+		}
+		for used[f.name] {
+			f.name += "_"
+		}
+		used[f.name] = true
+		g.fields = append(g.fields, f)
+		return nil
+	}
+
+	pk := g.td.PrimaryKeyColumns()
+	for _, col := range pk {
+		if err := add(col); err != nil {
+			return err
+		}
+	}
+	if len(pk) == 0 {
+		g.fields = append(g.fields, &field{name: "RowID", goType: "uint64", size: 6, sys: true})
+		used["RowID"] = true
+	}
+	g.fields = append(g.fields, &field{size: 13, sys: true})
+	for _, col := range g.td.Columns {
+		if !col.IsPrimaryKey {
+			if err := add(col); err != nil {
+				return err
+			}
+		}
+	}
+	return nil
+}
+
+func (g *generator) newField(col *schema.Column) (*field, error) {
+	f := &field{col: col, name: goName(col.Name), zero: "0", size: col.StorageSize()}
+	if col.IsVariableLength() {
+		f.varLen = true
+		f.twoByte = col.MaxBytes > 255
+		f.size = 0
+	}
+	switch code := col.ResolvedCode(); code {
+	case schema.CodeTinyInt, schema.CodeBool, schema.CodeBoolean:
+		f.goType = signed(col, "int8")
+	case schema.CodeSmallInt:
+		f.goType = signed(col, "int16")
+	case schema.CodeMediumInt, schema.CodeInt:
+		f.goType = signed(col, "int32")
+	case schema.CodeBigInt:
+		f.goType = signed(col, "int64")
+	case schema.CodeYear, schema.CodeEnum:
+		f.goType = "uint16"
+	case schema.CodeSet, schema.CodeBit:
+		f.goType = "uint64"
+	case schema.CodeFloat:
+		f.goType = "float32"
+		g.imports["math"] = true
+		g.imports["encoding/binary"] = true
+	case schema.CodeDouble:
+		f.goType = "float64"
+		g.imports["math"] = true
+		g.imports["encoding/binary"] = true
+	case schema.CodeDate:
+		f.goType = "column.Date"
+	case schema.CodeDateTime, schema.CodeTimestamp, schema.CodeTime:
+		f.goType = "column." + map[schema.TypeCode]string{
+			schema.CodeDateTime: "DateTime", schema.CodeTimestamp: "Timestamp", schema.CodeTime: "Time",
+		}[code]
+		f.zero = f.goType + "{}"
+	case schema.CodeDecimal, schema.CodeNumeric:
+		if col.Precision > 38 {
+			return nil, fmt.Errorf("DECIMAL(%d,%d) exceeds the 38 digits of column.Decimal", col.Precision, col.Scale)
+		}
+		f.goType = "column.Decimal"
+		f.zero = "column.Decimal{}"
+		g.decls = append(g.decls, fmt.Sprintf("var %s = column.NewDecimalLayout(%d, %d)\n",
+			g.layoutVar(f), col.Precision, col.Scale))
+	case schema.CodeChar, schema.CodeVarchar, schema.CodeText, schema.CodeTinyText,
+		schema.CodeMediumText, schema.CodeLongText, schema.CodeBinary, schema.CodeVarBinary,
+		schema.CodeBlob, schema.CodeTinyBlob, schema.CodeMediumBlob, schema.CodeLongBlob:
+		f.goType = "column.View"
+		f.zero = "nil"
+	case schema.CodeJSON:
+		f.goType = "column.JSON"
+		f.zero = "nil"
+	default:
+		return nil, fmt.Errorf("type %s not supported", col.Type)
+	}
+	if strings.HasPrefix(f.goType, "column.") {
+		g.imports["github.com/wilhasse/go-innodb/column"] = true
+	}
+	if !f.varLen && f.size == 0 {
+		return nil, fmt.Errorf("unknown storage size for %s", col.Type)
+	}
+	return f, nil
+}
+
+func signed(col *schema.Column, t string) string {
+	if col.Unsigned {
+		return "u" + t
+	}
+	return t
+}
+
+func (g *generator) layoutVar(f *field) string {
+	return lowerFirst(g.typeName) + f.name + "Layout"
+}
+
+// emitDecoder writes DecodeRecord. Reads are straight-line: NULL flags are
+// tested with constant byte offsets and masks, lengths are read from the
+// variable-length headers in order, and runs of fixed-width NOT NULL fields
+// share one bounds check and use constant offsets.
+func (g *generator) emitDecoder() {
+	w := &g.body
+	g.imports["github.com/wilhasse/go-innodb/format"] = true
+	nullBytes := g.td.NullBitmapSize()
+	if !g.td.HasNullableColumn() {
+		nullBytes = 0
+	}
+
+	fmt.Fprintf(w, "// DecodeRecord decodes the clustered index leaf record of %s whose\n", g.td.Name)
+	fmt.Fprintf(w, "// content starts at pos. Fields reference pageData; see column.View.\n")
+	fmt.Fprintf(w, "func (r *%s) DecodeRecord(p []byte, pos int) error {\n", g.typeName)
+	fmt.Fprintf(w, "if pos < %d || pos > len(p) {\nreturn format.ErrShortRead\n}\n", 5+nullBytes)
+
+	if nullBytes > 0 {
+		w.WriteString("\n// NULL flags\n")
+		for _, f := range g.fields {
+			if f.col == nil || !f.col.Nullable {
+				continue
+			}
+			i := f.col.NullIndex
+			fmt.Fprintf(w, "r.%sNull = p[pos-%d]&%#02x != 0\n", f.name, 6+i/8, 1<<(i%8))
+		}
+	}
+
+	hasVar := false
+	for _, f := range g.fields {
+		hasVar = hasVar || f.varLen
+	}
+	if hasVar {
+		w.WriteString("\n// Variable-length headers, stored backwards before the NULL flags\n")
+		fmt.Fprintf(w, "vp := pos - %d\n", 5+nullBytes)
+		n := 0
+		for _, f := range g.fields {
+			if !f.varLen {
+				continue
+			}
+			f.lenVar = fmt.Sprintf("n%d", n)
+			n++
+			fmt.Fprintf(w, "%s := 0\n", f.lenVar)
+			if f.col.Nullable {
+				fmt.Fprintf(w, "if !r.%sNull {\n", f.name)
+			}
+			need := 1
+			if f.twoByte {
+				need = 2
+			}
+			fmt.Fprintf(w, "if vp < %d {\nreturn format.ErrShortRead\n}\n", need)
+			fmt.Fprintf(w, "vp--\n%s = int(p[vp])\n", f.lenVar)
+			if f.twoByte {
+				fmt.Fprintf(w, "if %s&0x80 != 0 {\n", f.lenVar)
+				fmt.Fprintf(w, "if %s&0x40 != 0 {\nreturn fmt.Errorf(\"column %s: overflow pages not yet supported\")\n}\n", f.lenVar, f.col.Name)
+				fmt.Fprintf(w, "vp--\n%s = (%s&0x3f)<<8 | int(p[vp])\n}\n", f.lenVar, f.lenVar)
+				g.imports["fmt"] = true
+			}
+			if f.col.Nullable {
+				w.WriteString("}\n")
+			}
+		}
+	}
+
+	w.WriteString("\n// Columns\noff := pos\n")
+	constOff := 0
+	flush := func() {
+		if constOff > 0 {
+			fmt.Fprintf(w, "off += %d\n", constOff)
+			constOff = 0
+		}
+	}
+	for i := 0; i < len(g.fields); {
+		f := g.fields[i]
+		if f.varLen || (f.col != nil && f.col.Nullable) {
+			flush()
+			g.emitConditional(f)
+			i++
+			continue
+		}
+		// Run of fixed-width NOT NULL fields: one bounds check
+		j, runSize := i, 0
+		for ; j < len(g.fields); j++ {
+			h := g.fields[j]
+			if h.varLen || (h.col != nil && h.col.Nullable) {
+				break
+			}
+			runSize += h.size
+		}
+		fmt.Fprintf(w, "if off+%d > len(p) {\nreturn format.ErrShortRead\n}\n", constOff+runSize)
+		for ; i < j; i++ {
+			h := g.fields[i]
+			if h.name != "" {
+				g.emitFixed(h, at(constOff))
+			}
+			constOff += h.size
+		}
+	}
+	flush()
+	w.WriteString("_ = off\nreturn nil\n}\n")
+}
+
+// emitConditional emits a nullable or variable-length field, advancing off
+func (g *generator) emitConditional(f *field) {
+	w := &g.body
+	if f.col.Nullable {
+		fmt.Fprintf(w, "if r.%sNull {\nr.%s = %s\n} else {\n", f.name, f.name, f.zero)
+	}
+	if f.varLen {
+		fmt.Fprintf(w, "if off+%s > len(p) {\nreturn format.ErrShortRead\n}\n", f.lenVar)
+		src := fmt.Sprintf("p[off : off+%s]", f.lenVar)
+		switch f.col.ResolvedCode() {
+		case schema.CodeChar:
+			fmt.Fprintf(w, "r.%s = column.View(column.TrimSpacePadding(%s))\n", f.name, src)
+		case schema.CodeJSON:
+			fmt.Fprintf(w, "r.%s = column.JSON(%s)\n", f.name, src)
+		default:
+			fmt.Fprintf(w, "r.%s = column.View(%s)\n", f.name, src)
+		}
+		fmt.Fprintf(w, "off += %s\n", f.lenVar)
+	} else {
+		fmt.Fprintf(w, "if off+%d > len(p) {\nreturn format.ErrShortRead\n}\n", f.size)
+		g.emitFixed(f, "off")
+		fmt.Fprintf(w, "off += %d\n", f.size)
+	}
+	if f.col.Nullable {
+		w.WriteString("}\n")
+	}
+}
+
+// emitFixed emits the assignment of a fixed-width field stored at position
+// expression a (already bounds checked)
+func (g *generator) emitFixed(f *field, a string) {
+	w := &g.body
+	if f.col == nil {
+		// Hidden DB_ROW_ID
+		fmt.Fprintf(w, "r.%s = format.UN(p, %s, 6)\n", f.name, a)
+		return
+	}
+	col, dst := f.col, "r."+f.name
+	switch col.ResolvedCode() {
+	case schema.CodeTinyInt, schema.CodeBool, schema.CodeBoolean:
+		if col.Unsigned {
+			fmt.Fprintf(w, "%s = p[%s]\n", dst, a)
+		} else {
+			fmt.Fprintf(w, "%s = int8(p[%s] ^ 0x80)\n", dst, a)
+		}
+	case schema.CodeSmallInt:
+		if col.Unsigned {
+			fmt.Fprintf(w, "%s = format.U16(p, %s)\n", dst, a)
+		} else {
+			fmt.Fprintf(w, "%s = int16(format.U16(p, %s) ^ 0x8000)\n", dst, a)
+		}
+	case schema.CodeMediumInt:
+		if col.Unsigned {
+			fmt.Fprintf(w, "%s = uint32(format.UN(p, %s, 3))\n", dst, a)
+		} else {
+			fmt.Fprintf(w, "%s = int32((uint32(format.UN(p, %s, 3))^0x800000)<<8) >> 8\n", dst, a)
+		}
+	case schema.CodeInt:
+		if col.Unsigned {
+			fmt.Fprintf(w, "%s = format.U32(p, %s)\n", dst, a)
+		} else {
+			fmt.Fprintf(w, "%s = int32(format.U32(p, %s) ^ 0x80000000)\n", dst, a)
+		}
+	case schema.CodeBigInt:
+		if col.Unsigned {
+			fmt.Fprintf(w, "%s = format.U64(p, %s)\n", dst, a)
+		} else {
+			fmt.Fprintf(w, "%s = int64(format.U64(p, %s) ^ 1<<63)\n", dst, a)
+		}
+	case schema.CodeYear:
+		fmt.Fprintf(w, "%s = 0\nif y := p[%s]; y != 0 {\n%s = 1900 + uint16(y)\n}\n", dst, a, dst)
+	case schema.CodeEnum:
+		fmt.Fprintf(w, "%s = uint16(format.UN(p, %s, %d))\n", dst, a, f.size)
+	case schema.CodeSet, schema.CodeBit:
+		fmt.Fprintf(w, "%s = format.UN(p, %s, %d)\n", dst, a, f.size)
+	case schema.CodeFloat:
+		fmt.Fprintf(w, "%s = math.Float32frombits(binary.LittleEndian.Uint32(p[%s:]))\n", dst, a)
+	case schema.CodeDouble:
+		fmt.Fprintf(w, "%s = math.Float64frombits(binary.LittleEndian.Uint64(p[%s:]))\n", dst, a)
+	case schema.CodeDate:
+		fmt.Fprintf(w, "%s, _ = column.DecodeDate(p, %s)\n", dst, a)
+	case schema.CodeDateTime:
+		fmt.Fprintf(w, "%s, _, _ = column.DecodeDateTime(p, %s, %d)\n", dst, a, col.Precision)
+	case schema.CodeTimestamp:
+		fmt.Fprintf(w, "%s, _, _ = column.DecodeTimestamp(p, %s, %d)\n", dst, a, col.Precision)
+	case schema.CodeTime:
+		fmt.Fprintf(w, "%s, _, _ = column.DecodeTime(p, %s, %d)\n", dst, a, col.Precision)
+	case schema.CodeDecimal, schema.CodeNumeric:
+		fmt.Fprintf(w, "%s, _ = %s.Decode(p, %s)\n", dst, g.layoutVar(f), a)
+	case schema.CodeChar:
+		fmt.Fprintf(w, "%s = column.View(column.TrimSpacePadding(p[%s : %s+%d]))\n", dst, a, a, f.size)
+	case schema.CodeBinary:
+		fmt.Fprintf(w, "%s = column.View(p[%s : %s+%d])\n", dst, a, a, f.size)
+	}
+}
+
+// at formats the position expression off+k
+func at(k int) string {
+	if k == 0 {
+		return "off"
+	}
+	return fmt.Sprintf("off+%d", k)
+}
+
+// goName converts a column or table name to an exported Go identifier
+func goName(s string) string {
+	var b strings.Builder
+	upper := true
+	for _, r := range s {
+		if !unicode.IsLetter(r) && !unicode.IsDigit(r) {
+			upper = true
+			continue
+		}
+		if upper {
+			r = unicode.ToUpper(r)
+			upper = false
+		}
+		b.WriteRune(r)
+	}
+	name := b.String()
+	switch {
+	case name == "":
+		return "X"
+	case strings.EqualFold(name, "id"):
+		return "ID"
+	case strings.HasSuffix(name, "Id"):
+		name = name[:len(name)-2] + "ID"
+	}
+	if unicode.IsDigit(rune(name[0])) {
+		name = "X" + name
+	}
+	return name
+}
+
+func lowerFirst(s string) string {
+	if s == "" {
+		return s
+	}
+	return strings.ToLower(s[:1]) + s[1:]
+}
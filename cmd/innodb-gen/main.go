@@ -0,0 +1,74 @@
+// main.go - Generates typed, schema-specialized record decoders from CREATE TABLE
+//
+// Usage, typically from a go:generate directive:
+//
+//	//go:generate innodb-gen -sql users.sql -type User
+//
+// The output file holds a struct with one field per column (plus a <Field>Null
+// flag for nullable columns) and a DecodeRecord method implementing
+// record.RowDecoder, usable with record.DecodeRows.
+package main
+
+import (
+	"flag"
+	"fmt"
+	"os"
+	"path/filepath"
+	"strings"
+
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+func main() {
+	var (
+		sqlFile  = flag.String("sql", "", "Path to SQL file with CREATE TABLE statement (required)")
+		typeName = flag.String("type", "", "Name of the generated struct (default: table name in CamelCase)")
+		pkg      = flag.String("pkg", os.Getenv("GOPACKAGE"), "Package of the generated file (default: $GOPACKAGE or main)")
+		output   = flag.String("o", "", "Output file (default: <table>_innodb.go)")
+	)
+
+	flag.Usage = func() {
+		fmt.Fprintf(os.Stderr, "InnoDB Decoder Generator\n\n")
+		fmt.Fprintf(os.Stderr, "Usage: %s [OPTIONS]\n\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "Options:\n")
+		flag.PrintDefaults()
+		fmt.Fprintf(os.Stderr, "\nExamples:\n")
+		fmt.Fprintf(os.Stderr, "  %s -sql users.sql -type User\n", os.Args[0])
+		fmt.Fprintf(os.Stderr, "  //go:generate %s -sql users.sql -type User -o user_decoder.go\n", filepath.Base(os.Args[0]))
+	}
+
+	flag.Parse()
+
+	if *sqlFile == "" {
+		fmt.Fprintf(os.Stderr, "Error: -sql is required\n\n")
+		flag.Usage()
+		os.Exit(1)
+	}
+
+	tableDef, err := schema.ParseTableDefFromSQLFile(*sqlFile)
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error parsing SQL file: %v\n", err)
+		os.Exit(1)
+	}
+
+	if *typeName == "" {
+		*typeName = goName(tableDef.Name)
+	}
+	if *pkg == "" {
+		*pkg = "main"
+	}
+	if *output == "" {
+		*output = strings.ToLower(tableDef.Name) + "_innodb.go"
+	}
+
+	src, err := generate(tableDef, *pkg, *typeName, filepath.Base(*sqlFile))
+	if err != nil {
+		fmt.Fprintf(os.Stderr, "Error generating decoder: %v\n", err)
+		os.Exit(1)
+	}
+
+	if err := os.WriteFile(*output, src, 0644); err != nil {
+		fmt.Fprintf(os.Stderr, "Error writing %s: %v\n", *output, err)
+		os.Exit(1)
+	}
+}
@@ -0,0 +1,127 @@
+// batch.go - Columnar batch kernels for fixed-width numeric columns
+package column
+
+import (
+	"encoding/binary"
+	"math"
+
+	"github.com/wilhasse/go-innodb/format"
+)
+
+// Batch kernels decode one column for many records at once. offsets holds
+// the position of the column value in input for each record (as found by
+// the record decoder) and out receives the values in the same order; it
+// must be at least len(offsets) long. Per-column work such as computing the
+// DECIMAL layout is done once per batch, and the inner loops do no
+// allocation or interface dispatch.
+
+// checkBatch validates the offsets of a batch of size-byte values
+func checkBatch(input []byte, offsets []int, size, outLen int) error {
+	if outLen < len(offsets) {
+		return format.ErrShortRead
+	}
+	for _, off := range offsets {
+		if off < 0 || off+size > len(input) {
+			return format.ErrShortRead
+		}
+	}
+	return nil
+}
+
+// DecodeIntBatch decodes size-byte integers (TINYINT to BIGINT, 1 to 8
+// bytes) into int64s. Signed values are stored with the sign bit flipped;
+// unsigned BIGINT values above MaxInt64 wrap and must be reinterpreted as
+// uint64 by the caller.
+func DecodeIntBatch(input []byte, offsets []int, size int, signed bool, out []int64) error {
+	if size < 1 || size > 8 {
+		return format.ErrShortRead
+	}
+	if err := checkBatch(input, offsets, size, len(out)); err != nil {
+		return err
+	}
+	shift := uint(64 - 8*size)
+	for i, off := range offsets {
+		v := format.UN(input, off, size)
+		if signed {
+			// Move the sign bit to bit 63, restore it, then sign-extend
+			out[i] = int64(v<<shift^1<<63) >> shift
+		} else {
+			out[i] = int64(v)
+		}
+	}
+	return nil
+}
+
+// DecodeDecimal64Batch decodes DECIMAL(precision,scale) values with
+// precision <= 18 into unscaled int64s (value = out[i] / 10^scale)
+func DecodeDecimal64Batch(input []byte, offsets []int, precision, scale int, out []int64) error {
+	l := DecimalLayoutFor(precision, scale)
+	if l == nil || precision > MaxDecimal64Precision {
+		return ErrDecimalPrecision
+	}
+	if l.Size == 0 {
+		return format.ErrShortRead
+	}
+	if err := checkBatch(input, offsets, l.Size, len(out)); err != nil {
+		return err
+	}
+	for i, off := range offsets {
+		b := input[off : off+l.Size]
+		neg, mask := decimalSign(b)
+		var acc uint64
+		pos := 0
+		for g := 0; g < l.nGroups; g++ {
+			w := int(l.groupBytes[g])
+			acc = acc*pow10[l.groupDigits[g]] + decimalGroup(b, pos, w, mask)
+			pos += w
+		}
+		if neg {
+			out[i] = -int64(acc)
+		} else {
+			out[i] = int64(acc)
+		}
+	}
+	return nil
+}
+
+// DecodeDecimalBatch decodes DECIMAL(precision,scale) values with
+// precision <= 38 into 128-bit Decimals
+func DecodeDecimalBatch(input []byte, offsets []int, precision, scale int, out []Decimal) error {
+	l := DecimalLayoutFor(precision, scale)
+	if l == nil || precision > MaxDecimalPrecision {
+		return ErrDecimalPrecision
+	}
+	if err := checkBatch(input, offsets, l.Size, len(out)); err != nil {
+		return err
+	}
+	for i, off := range offsets {
+		d, err := l.Decode(input, off)
+		if err != nil {
+			return err
+		}
+		out[i] = d
+	}
+	return nil
+}
+
+// DecodeFloatBatch decodes 4-byte FLOAT values
+func DecodeFloatBatch(input []byte, offsets []int, out []float32) error {
+	if err := checkBatch(input, offsets, 4, len(out)); err != nil {
+		return err
+	}
+	for i, off := range offsets {
+		out[i] = math.Float32frombits(binary.LittleEndian.Uint32(input[off : off+4]))
+	}
+	return nil
+}
+
+// DecodeDoubleBatch decodes 8-byte DOUBLE values
+func DecodeDoubleBatch(input []byte, offsets []int, out []float64) error {
+	if err := checkBatch(input, offsets, 8, len(out)); err != nil {
+		return err
+	}
+	for i, off := range offsets {
+		out[i] = math.Float64frombits(binary.LittleEndian.Uint64(input[off : off+8]))
+	}
+	return nil
+}
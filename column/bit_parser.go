@@ -0,0 +1,33 @@
+// bit_parser.go - Parser for BIT column type
+package column
+
+import (
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// BitParser handles BIT(M), stored as a (M+7)/8-byte big-endian unsigned
+// integer and returned as uint64
+type BitParser struct {
+	BaseParser
+}
+
+// Parse parses a BIT value
+func (p *BitParser) Parse(input []byte, offset int, col *schema.Column, varLen int) (interface{}, int, error) {
+	if col.ResolvedCode() != schema.CodeBit {
+		return nil, 0, schema.ErrUnsupportedType
+	}
+	size := col.StorageSize()
+	if offset < 0 || offset+size > len(input) {
+		return nil, 0, format.ErrShortRead
+	}
+	return readBE(input[offset:], size), size, nil
+}
+
+// Skip skips BIT value without parsing
+func (p *BitParser) Skip(input []byte, offset int, col *schema.Column, varLen int) (int, error) {
+	if col.ResolvedCode() != schema.CodeBit {
+		return 0, schema.ErrUnsupportedType
+	}
+	return col.StorageSize(), nil
+}
@@ -0,0 +1,293 @@
+// decimal.go - Typed DECIMAL values decoded from MySQL's packed binary format
+package column
+
+import (
+	"errors"
+	"math"
+	"math/bits"
+	"strconv"
+	"sync/atomic"
+
+	"github.com/wilhasse/go-innodb/format"
+)
+
+// MySQL stores DECIMAL(p,s) as groups of 9 decimal digits in 4 big-endian
+// bytes. The leading integer group and trailing fraction group may hold
+// fewer digits and use dig2bytes[n] bytes. The sign is the inverted high bit
+// of the first byte, and negative values have every byte inverted.
+//
+// Values are decoded straight into scaled integers: int64 for precision up
+// to 18 and 128 bits (Decimal) up to 38, without big.Float or strings.
+
+// MaxDecimal64Precision is the largest precision Decode64 accepts
+const MaxDecimal64Precision = 18
+
+// MaxDecimalPrecision is the largest precision the Decimal type holds
+const MaxDecimalPrecision = 38
+
+// MaxDecimalDigits and MaxDecimalScale are MySQL's limits on DECIMAL(p,s)
+const (
+	MaxDecimalDigits = 65
+	MaxDecimalScale  = 30
+)
+
+// ErrDecimalPrecision is returned when a DECIMAL does not fit the target type
+var ErrDecimalPrecision = errors.New("decimal precision too large for target type")
+
+var dig2bytes = [10]int{0, 1, 1, 2, 2, 3, 3, 4, 4, 4}
+
+var pow10 = [10]uint64{1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000}
+
+// DecimalLayout describes the on-disk layout of a DECIMAL(p,s) column.
+// Compute it once per column and reuse it for every value; DecimalLayoutFor
+// returns a shared one.
+type DecimalLayout struct {
+	Precision int
+	Scale     int
+	Size      int // total bytes
+
+	// Digit groups in storage order: byte width and digit count of each
+	nGroups     int
+	groupBytes  [16]uint8
+	groupDigits [16]uint8
+}
+
+// NewDecimalLayout computes the layout for DECIMAL(precision, scale)
+func NewDecimalLayout(precision, scale int) DecimalLayout {
+	l := DecimalLayout{Precision: precision, Scale: scale}
+	add := func(digits int) {
+		l.groupBytes[l.nGroups] = uint8(dig2bytes[digits])
+		l.groupDigits[l.nGroups] = uint8(digits)
+		l.Size += dig2bytes[digits]
+		l.nGroups++
+	}
+	intg := precision - scale
+	if intg%9 > 0 {
+		add(intg % 9)
+	}
+	for i := 0; i < intg/9; i++ {
+		add(9)
+	}
+	for i := 0; i < scale/9; i++ {
+		add(9)
+	}
+	if scale%9 > 0 {
+		add(scale % 9)
+	}
+	return l
+}
+
+// ValidDecimal reports whether DECIMAL(precision, scale) is a type MySQL
+// accepts: 1 to 65 digits, of which at most 30 after the point
+func ValidDecimal(precision, scale int) bool {
+	return precision >= 1 && precision <= MaxDecimalDigits &&
+		scale >= 0 && scale <= precision && scale <= MaxDecimalScale
+}
+
+// decimalLayouts caches the layout of every valid DECIMAL(p,s)
+var decimalLayouts [MaxDecimalDigits + 1][MaxDecimalScale + 1]atomic.Pointer[DecimalLayout]
+
+// DecimalLayoutFor returns the layout of DECIMAL(precision, scale), computed
+// on first use and shared by every column of that type, or nil if the type
+// is not valid
+func DecimalLayoutFor(precision, scale int) *DecimalLayout {
+	if !ValidDecimal(precision, scale) {
+		return nil
+	}
+	slot := &decimalLayouts[precision][scale]
+	if l := slot.Load(); l != nil {
+		return l
+	}
+	l := NewDecimalLayout(precision, scale)
+	slot.Store(&l)
+	return &l
+}
+
+// decimalSign returns whether the value at b is negative and the XOR mask that
+// undoes the byte inversion of negative values
+func decimalSign(b []byte) (bool, uint64) {
+	if b[0]&0x80 == 0 {
+		return true, math.MaxUint64
+	}
+	return false, 0
+}
+
+// decimalGroup reads the w-byte digit group at b[pos:]
+func decimalGroup(b []byte, pos, w int, mask uint64) uint64 {
+	v := readBE(b[pos:], w)
+	if pos == 0 {
+		v ^= 0x80 << (8 * (w - 1))
+	}
+	return (v ^ mask) & (1<<(8*w) - 1)
+}
+
+// Decode64 decodes a value with precision <= 18 into an unscaled int64
+// (the value is n / 10^Scale).
+func (l *DecimalLayout) Decode64(input []byte, offset int) (int64, error) {
+	if l.Precision > MaxDecimal64Precision {
+		return 0, ErrDecimalPrecision
+	}
+	if offset < 0 || offset+l.Size > len(input) || l.Size == 0 {
+		return 0, format.ErrShortRead
+	}
+	b := input[offset : offset+l.Size]
+	neg, mask := decimalSign(b)
+	var acc uint64
+	pos := 0
+	for g := 0; g < l.nGroups; g++ {
+		w := int(l.groupBytes[g])
+		acc = acc*pow10[l.groupDigits[g]] + decimalGroup(b, pos, w, mask)
+		pos += w
+	}
+	if neg {
+		return -int64(acc), nil
+	}
+	return int64(acc), nil
+}
+
+// Decode decodes a value with precision <= 38 into a 128-bit Decimal
+func (l *DecimalLayout) Decode(input []byte, offset int) (Decimal, error) {
+	if l.Precision > MaxDecimalPrecision {
+		return Decimal{}, ErrDecimalPrecision
+	}
+	if offset < 0 || offset+l.Size > len(input) || l.Size == 0 {
+		return Decimal{}, format.ErrShortRead
+	}
+	b := input[offset : offset+l.Size]
+	neg, mask := decimalSign(b)
+	var hi, lo uint64
+	pos := 0
+	for g := 0; g < l.nGroups; g++ {
+		w := int(l.groupBytes[g])
+		m := pow10[l.groupDigits[g]]
+		h, l0 := bits.Mul64(lo, m)
+		hi = hi*m + h
+		var c uint64
+		lo, c = bits.Add64(l0, decimalGroup(b, pos, w, mask), 0)
+		hi += c
+		pos += w
+	}
+	if neg {
+		lo, hi = negate128(lo, hi)
+	}
+	return Decimal{Hi: int64(hi), Lo: lo, Scale: uint8(l.Scale)}, nil
+}
+
+// AppendText appends the decimal text of a value of any precision (up to
+// MySQL's 65 digits) directly from its digit groups.
+func (l *DecimalLayout) AppendText(out []byte, input []byte, offset int) ([]byte, error) {
+	if offset < 0 || offset+l.Size > len(input) || l.Size == 0 {
+		return out, format.ErrShortRead
+	}
+	b := input[offset : offset+l.Size]
+	neg, mask := decimalSign(b)
+	var digits [81]byte
+	n, pos := 0, 0
+	for g := 0; g < l.nGroups; g++ {
+		w, width := int(l.groupBytes[g]), int(l.groupDigits[g])
+		v := decimalGroup(b, pos, w, mask)
+		for i := width - 1; i >= 0; i-- {
+			digits[n+i] = byte('0' + v%10)
+			v /= 10
+		}
+		n += width
+		pos += w
+	}
+	intDigits := n - l.Scale
+	start := 0
+	for start < intDigits-1 && digits[start] == '0' {
+		start++
+	}
+	if neg {
+		out = append(out, '-')
+	}
+	if intDigits == 0 {
+		out = append(out, '0')
+	}
+	out = append(out, digits[start:intDigits]...)
+	if l.Scale > 0 {
+		out = append(out, '.')
+		out = append(out, digits[intDigits:n]...)
+	}
+	return out, nil
+}
+
+// Decimal is a DECIMAL value stored as a two's complement 128-bit unscaled
+// integer (Hi:Lo); the value is Hi:Lo / 10^Scale.
+type Decimal struct {
+	Hi    int64
+	Lo    uint64
+	Scale uint8
+}
+
+// Negative reports whether the value is below zero
+func (d Decimal) Negative() bool { return d.Hi < 0 }
+
+// Int64 returns the unscaled value if it fits in an int64
+func (d Decimal) Int64() (int64, bool) {
+	v := int64(d.Lo)
+	return v, (d.Hi == 0 && v >= 0) || (d.Hi == -1 && v < 0)
+}
+
+// Float64 returns the nearest float64 to the value
+func (d Decimal) Float64() float64 {
+	lo, hi := d.Lo, uint64(d.Hi)
+	if d.Negative() {
+		lo, hi = negate128(lo, hi)
+	}
+	f := float64(hi)*(1<<64) + float64(lo)
+	for s := int(d.Scale); s > 0; s-- {
+		f /= 10
+	}
+	if d.Negative() {
+		return -f
+	}
+	return f
+}
+
+// AppendFormat appends the value in decimal notation with Scale fraction digits
+func (d Decimal) AppendFormat(b []byte) []byte {
+	lo, hi := d.Lo, uint64(d.Hi)
+	if d.Negative() {
+		b = append(b, '-')
+		lo, hi = negate128(lo, hi)
+	}
+
+	// Magnitude < 2^127, so one division by 10^19 leaves a 64-bit quotient
+	var digits [40]byte
+	var n []byte
+	if hi == 0 {
+		n = strconv.AppendUint(digits[:0], lo, 10)
+	} else {
+		const e19 = 10000000000000000000
+		q, r := bits.Div64(hi, lo, e19)
+		n = strconv.AppendUint(digits[:0], q, 10)
+		n = appendPadded(n, r, 19)
+	}
+
+	scale := int(d.Scale)
+	if len(n) <= scale {
+		b = append(b, '0', '.')
+		for i := len(n); i < scale; i++ {
+			b = append(b, '0')
+		}
+		return append(b, n...)
+	}
+	b = append(b, n[:len(n)-scale]...)
+	if scale > 0 {
+		b = append(b, '.')
+		b = append(b, n[len(n)-scale:]...)
+	}
+	return b
+}
+
+func (d Decimal) String() string {
+	var buf [42]byte
+	return string(d.AppendFormat(buf[:0]))
+}
+
+// negate128 returns the two's complement of lo:hi
+func negate128(lo, hi uint64) (uint64, uint64) {
+	lo, c := bits.Add64(^lo, 1, 0)
+	return lo, ^hi + c
+}
@@ -0,0 +1,52 @@
+// decimal_parser.go - Parser for DECIMAL/NUMERIC column types
+package column
+
+import (
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// DecimalParser handles DECIMAL and NUMERIC types.
+// Values with precision up to 38 are returned as Decimal; wider values
+// (MySQL allows 65 digits) are returned as their decimal text.
+type DecimalParser struct {
+	BaseParser
+}
+
+// Parse parses a packed binary decimal value
+func (p *DecimalParser) Parse(input []byte, offset int, col *schema.Column, varLen int) (interface{}, int, error) {
+	switch col.ResolvedCode() {
+	case schema.CodeDecimal, schema.CodeNumeric:
+		layout := DecimalLayoutFor(col.Precision, col.Scale)
+		if layout == nil {
+			return nil, 0, schema.ErrUnsupportedType
+		}
+		if col.Precision > MaxDecimalPrecision {
+			text, err := layout.AppendText(nil, input, offset)
+			if err != nil {
+				return nil, 0, err
+			}
+			return string(text), layout.Size, nil
+		}
+		val, err := layout.Decode(input, offset)
+		if err != nil {
+			return nil, 0, err
+		}
+		return val, layout.Size, nil
+
+	default:
+		return nil, 0, schema.ErrUnsupportedType
+	}
+}
+
+// Skip skips decimal value without parsing
+func (p *DecimalParser) Skip(input []byte, offset int, col *schema.Column, varLen int) (int, error) {
+	switch col.ResolvedCode() {
+	case schema.CodeDecimal, schema.CodeNumeric:
+		if layout := DecimalLayoutFor(col.Precision, col.Scale); layout != nil {
+			return layout.Size, nil
+		}
+		return 0, schema.ErrUnsupportedType
+	default:
+		return 0, schema.ErrUnsupportedType
+	}
+}
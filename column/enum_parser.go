@@ -0,0 +1,77 @@
+// enum_parser.go - Parser for ENUM and SET column types
+package column
+
+import (
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// EnumParser handles ENUM and SET types. Both are stored as unsigned
+// big-endian integers: ENUM as the 1-based member index (0 for the empty
+// error value), SET as a bitmask of members.
+type EnumParser struct {
+	BaseParser
+}
+
+// Parse parses an ENUM (returned as the member string) or SET (returned as Set)
+func (p *EnumParser) Parse(input []byte, offset int, col *schema.Column, varLen int) (interface{}, int, error) {
+	size := col.StorageSize()
+	if offset < 0 || offset+size > len(input) {
+		return nil, 0, format.ErrShortRead
+	}
+	v := readBE(input[offset:], size)
+
+	switch col.ResolvedCode() {
+	case schema.CodeEnum:
+		if v == 0 || int(v) > len(col.EnumValues) {
+			return "", size, nil
+		}
+		return col.EnumValues[v-1], size, nil
+
+	case schema.CodeSet:
+		return Set{Bits: v, Members: col.SetValues}, size, nil
+
+	default:
+		return nil, 0, schema.ErrUnsupportedType
+	}
+}
+
+// Skip skips ENUM/SET value without parsing
+func (p *EnumParser) Skip(input []byte, offset int, col *schema.Column, varLen int) (int, error) {
+	switch col.ResolvedCode() {
+	case schema.CodeEnum, schema.CodeSet:
+		return col.StorageSize(), nil
+	default:
+		return 0, schema.ErrUnsupportedType
+	}
+}
+
+// Set is a SET value: a bitmask over the column's members. Members refers
+// to the column definition and is not copied.
+type Set struct {
+	Bits    uint64
+	Members []string
+}
+
+// Has reports whether the i-th member (0-based) is in the set
+func (s Set) Has(i int) bool { return i < 64 && s.Bits&(1<<uint(i)) != 0 }
+
+// AppendFormat appends the members in the set separated by commas
+func (s Set) AppendFormat(b []byte) []byte {
+	first := true
+	for i, m := range s.Members {
+		if !s.Has(i) {
+			continue
+		}
+		if !first {
+			b = append(b, ',')
+		}
+		b = append(b, m...)
+		first = false
+	}
+	return b
+}
+
+func (s Set) String() string {
+	return string(s.AppendFormat(nil))
+}
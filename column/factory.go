@@ -9,40 +9,62 @@ var (
 	intParser      = &IntParser{}
 	stringParser   = &StringParser{}
 	dateTimeParser = &DateTimeParser{}
+	decimalParser  = &DecimalParser{}
+	floatParser    = &FloatParser{}
+	enumParser     = &EnumParser{}
+	bitParser      = &BitParser{}
+	jsonParser     = &JSONParser{}
 	// Add more parsers as needed
 )
 
-// GetParser returns the appropriate parser for the column type
-func GetParser(col *schema.Column) Parser {
-	switch col.Type {
+// parsers maps each schema.TypeCode to its parser (nil = unsupported)
+var parsers = [schema.NumTypeCodes]Parser{
 	// Integer types
-	case schema.TypeTinyInt, schema.TypeSmallInt, schema.TypeMediumInt,
-		schema.TypeInt, schema.TypeBigInt, schema.TypeYear,
-		schema.TypeBoolean, schema.TypeBool:
-		return intParser
+	schema.CodeTinyInt:   intParser,
+	schema.CodeSmallInt:  intParser,
+	schema.CodeMediumInt: intParser,
+	schema.CodeInt:       intParser,
+	schema.CodeBigInt:    intParser,
+	schema.CodeYear:      intParser,
+	schema.CodeBoolean:   intParser,
+	schema.CodeBool:      intParser,
 
 	// String types
-	case schema.TypeChar, schema.TypeVarchar,
-		schema.TypeText, schema.TypeTinyText, schema.TypeMediumText, schema.TypeLongText,
-		schema.TypeBinary, schema.TypeVarBinary,
-		schema.TypeBlob, schema.TypeTinyBlob, schema.TypeMediumBlob, schema.TypeLongBlob:
-		return stringParser
+	schema.CodeChar:       stringParser,
+	schema.CodeVarchar:    stringParser,
+	schema.CodeText:       stringParser,
+	schema.CodeTinyText:   stringParser,
+	schema.CodeMediumText: stringParser,
+	schema.CodeLongText:   stringParser,
+	schema.CodeBinary:     stringParser,
+	schema.CodeVarBinary:  stringParser,
+	schema.CodeBlob:       stringParser,
+	schema.CodeTinyBlob:   stringParser,
+	schema.CodeMediumBlob: stringParser,
+	schema.CodeLongBlob:   stringParser,
 
 	// Date/time types
-	case schema.TypeDate, schema.TypeTime, schema.TypeDateTime,
-		schema.TypeTimestamp:
-		return dateTimeParser
+	schema.CodeDate:      dateTimeParser,
+	schema.CodeTime:      dateTimeParser,
+	schema.CodeDateTime:  dateTimeParser,
+	schema.CodeTimestamp: dateTimeParser,
 
-	// TODO: Add more parsers for:
-	// - DECIMAL/NUMERIC
-	// - FLOAT/DOUBLE
-	// - ENUM/SET
-	// - BIT
-	// - JSON
+	// Numeric types
+	schema.CodeDecimal: decimalParser,
+	schema.CodeNumeric: decimalParser,
+	schema.CodeFloat:   floatParser,
+	schema.CodeDouble:  floatParser,
 
-	default:
-		return nil
-	}
+	// Other types
+	schema.CodeEnum: enumParser,
+	schema.CodeSet:  enumParser,
+	schema.CodeBit:  bitParser,
+	schema.CodeJSON: jsonParser,
+}
+
+// GetParser returns the appropriate parser for the column type
+func GetParser(col *schema.Column) Parser {
+	return parsers[col.ResolvedCode()]
 }
 
 // ParseColumn parses a column value using the appropriate parser
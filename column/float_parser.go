@@ -0,0 +1,61 @@
+// float_parser.go - Parser for FLOAT/DOUBLE column types
+package column
+
+import (
+	"encoding/binary"
+	"math"
+
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// FloatParser handles FLOAT and DOUBLE types.
+// Unlike integers, InnoDB stores these in little-endian IEEE 754 format
+// (see mach_float_write/mach_double_write).
+type FloatParser struct {
+	BaseParser
+}
+
+// Parse parses a floating point value
+func (p *FloatParser) Parse(input []byte, offset int, col *schema.Column, varLen int) (interface{}, int, error) {
+	switch col.ResolvedCode() {
+	case schema.CodeFloat:
+		val, err := DecodeFloat(input, offset)
+		return val, 4, err
+
+	case schema.CodeDouble:
+		val, err := DecodeDouble(input, offset)
+		return val, 8, err
+
+	default:
+		return nil, 0, schema.ErrUnsupportedType
+	}
+}
+
+// Skip skips floating point value without parsing
+func (p *FloatParser) Skip(input []byte, offset int, col *schema.Column, varLen int) (int, error) {
+	switch col.ResolvedCode() {
+	case schema.CodeFloat:
+		return 4, nil
+	case schema.CodeDouble:
+		return 8, nil
+	default:
+		return 0, schema.ErrUnsupportedType
+	}
+}
+
+// DecodeFloat decodes a 4-byte FLOAT
+func DecodeFloat(input []byte, offset int) (float32, error) {
+	if offset < 0 || offset+4 > len(input) {
+		return 0, format.ErrShortRead
+	}
+	return math.Float32frombits(binary.LittleEndian.Uint32(input[offset:])), nil
+}
+
+// DecodeDouble decodes an 8-byte DOUBLE
+func DecodeDouble(input []byte, offset int) (float64, error) {
+	if offset < 0 || offset+8 > len(input) {
+		return 0, format.ErrShortRead
+	}
+	return math.Float64frombits(binary.LittleEndian.Uint64(input[offset:])), nil
+}
@@ -12,8 +12,8 @@ type IntParser struct {
 
 // Parse parses integer value based on column type
 func (p *IntParser) Parse(input []byte, offset int, col *schema.Column, varLen int) (interface{}, int, error) {
-	switch col.Type {
-	case schema.TypeTinyInt:
+	switch col.ResolvedCode() {
+	case schema.CodeTinyInt:
 		if col.Unsigned {
 			val, err := p.readUint8(input, offset)
 			return val, 1, err
@@ -21,26 +21,26 @@ func (p *IntParser) Parse(input []byte, offset int, col *schema.Column, varLen i
 		val, err := p.readInt8(input, offset)
 		return val, 1, err
 
-	case schema.TypeSmallInt, schema.TypeYear:
+	case schema.CodeSmallInt:
 		if col.Unsigned {
 			val, err := p.readUint16(input, offset)
 			return val, 2, err
 		}
-		if col.Type == schema.TypeYear {
-			// YEAR is stored as unsigned byte, 0 = year 0000, otherwise add 1900
-			val, err := p.readUint8(input, offset)
-			if err != nil {
-				return nil, 0, err
-			}
-			if val == 0 {
-				return uint16(0), 1, nil
-			}
-			return uint16(uint16(val) + 1900), 1, nil
-		}
 		val, err := p.readInt16(input, offset)
 		return val, 2, err
 
-	case schema.TypeMediumInt:
+	case schema.CodeYear:
+		// YEAR is stored as unsigned byte, 0 = year 0000, otherwise add 1900
+		val, err := p.readUint8(input, offset)
+		if err != nil {
+			return nil, 0, err
+		}
+		if val == 0 {
+			return uint16(0), 1, nil
+		}
+		return uint16(uint16(val) + 1900), 1, nil
+
+	case schema.CodeMediumInt:
 		if col.Unsigned {
 			val, err := p.readUnsignedMediumInt(input, offset)
 			return val, 3, err
@@ -48,7 +48,7 @@ func (p *IntParser) Parse(input []byte, offset int, col *schema.Column, varLen i
 		val, err := p.readMediumInt(input, offset)
 		return val, 3, err
 
-	case schema.TypeInt:
+	case schema.CodeInt:
 		if col.Unsigned {
 			val, err := p.readUint32(input, offset)
 			return val, 4, err
@@ -56,7 +56,7 @@ func (p *IntParser) Parse(input []byte, offset int, col *schema.Column, varLen i
 		val, err := p.readInt32(input, offset)
 		return val, 4, err
 
-	case schema.TypeBigInt:
+	case schema.CodeBigInt:
 		if col.Unsigned {
 			val, err := p.readUint64(input, offset)
 			return val, 8, err
@@ -64,34 +64,31 @@ func (p *IntParser) Parse(input []byte, offset int, col *schema.Column, varLen i
 		val, err := p.readInt64(input, offset)
 		return val, 8, err
 
-	default:
-		// For BOOLEAN (stored as TINYINT(1))
-		if col.Type == schema.TypeBoolean || col.Type == schema.TypeBool {
-			val, err := p.readUint8(input, offset)
-			if err != nil {
-				return nil, 0, err
-			}
-			return val != 0, 1, nil
+	case schema.CodeBoolean, schema.CodeBool:
+		// BOOLEAN is stored as TINYINT(1)
+		val, err := p.readUint8(input, offset)
+		if err != nil {
+			return nil, 0, err
 		}
+		return val != 0, 1, nil
 
+	default:
 		return nil, 0, schema.ErrUnsupportedType
 	}
 }
 
 // Skip skips integer value without parsing
 func (p *IntParser) Skip(input []byte, offset int, col *schema.Column, varLen int) (int, error) {
-	switch col.Type {
-	case schema.TypeTinyInt, schema.TypeBoolean, schema.TypeBool:
+	switch col.ResolvedCode() {
+	case schema.CodeTinyInt, schema.CodeBoolean, schema.CodeBool, schema.CodeYear:
 		return 1, nil
-	case schema.TypeSmallInt:
+	case schema.CodeSmallInt:
 		return 2, nil
-	case schema.TypeYear:
-		return 1, nil
-	case schema.TypeMediumInt:
+	case schema.CodeMediumInt:
 		return 3, nil
-	case schema.TypeInt:
+	case schema.CodeInt:
 		return 4, nil
-	case schema.TypeBigInt:
+	case schema.CodeBigInt:
 		return 8, nil
 	default:
 		return 0, schema.ErrUnsupportedType
@@ -0,0 +1,594 @@
+// json.go - Streaming decoder and path extraction for MySQL binary JSON
+package column
+
+import (
+	"encoding/base64"
+	"encoding/binary"
+	"errors"
+	"math"
+	"strconv"
+)
+
+// MySQL stores JSON columns in a binary format (sql/json_binary.h):
+//
+//	doc       ::= type value
+//	object    ::= count size key-entry* value-entry* key* value*
+//	array     ::= count size value-entry* value*
+//	key-entry ::= key-offset key-length(2)
+//	value-entry ::= type offset-or-inlined-value
+//
+// count, size and offsets are 2 bytes in small containers and 4 bytes in
+// large ones, all little-endian, and offsets are relative to the start of
+// the container. Object keys are sorted by length and then bytewise, which
+// lets path lookups binary search them.
+//
+// The decoder writes text straight into a caller-supplied buffer without
+// building an intermediate tree, and path extraction walks only the offset
+// tables on the way to the requested value.
+
+// Binary JSON value types
+const (
+	JSONSmallObject byte = 0x00
+	JSONLargeObject byte = 0x01
+	JSONSmallArray  byte = 0x02
+	JSONLargeArray  byte = 0x03
+	JSONLiteral     byte = 0x04
+	JSONInt16       byte = 0x05
+	JSONUint16      byte = 0x06
+	JSONInt32       byte = 0x07
+	JSONUint32      byte = 0x08
+	JSONInt64       byte = 0x09
+	JSONUint64      byte = 0x0a
+	JSONDouble      byte = 0x0b
+	JSONString      byte = 0x0c
+	JSONOpaque      byte = 0x0f
+)
+
+// Literal values
+const (
+	jsonNull  byte = 0x00
+	jsonTrue  byte = 0x01
+	jsonFalse byte = 0x02
+)
+
+// MySQL field types that appear in opaque values
+const (
+	mysqlTypeTimestamp  = 7
+	mysqlTypeDate       = 10
+	mysqlTypeTime       = 11
+	mysqlTypeDateTime   = 12
+	mysqlTypeNewDecimal = 246
+)
+
+// Errors returned by the JSON decoder
+var (
+	ErrInvalidJSON     = errors.New("invalid binary JSON")
+	ErrInvalidJSONPath = errors.New("invalid or unsupported JSON path")
+)
+
+// maxJSONDepth matches MySQL's JSON_DOCUMENT_MAX_DEPTH
+const maxJSONDepth = 100
+
+// JSON is a binary JSON document as stored in the column (type byte
+// followed by the value). It is usually a View into a page or an off-page
+// buffer; copy it to keep it.
+type JSON []byte
+
+// Value returns the document's top-level value
+func (j JSON) Value() (JSONValue, error) {
+	if len(j) == 0 {
+		return JSONValue{}, ErrInvalidJSON
+	}
+	return JSONValue{Type: j[0], data: j[1:]}, nil
+}
+
+// AppendText appends the document as JSON text
+func (j JSON) AppendText(b []byte) ([]byte, error) {
+	v, err := j.Value()
+	if err != nil {
+		return b, err
+	}
+	return v.AppendText(b)
+}
+
+func (j JSON) String() string {
+	b, err := j.AppendText(nil)
+	if err != nil {
+		return "<" + err.Error() + ">"
+	}
+	return string(b)
+}
+
+// JSONValue is one value inside a binary JSON document. data starts at the
+// value's encoding; for values inlined in a value entry it points into the
+// entry itself.
+type JSONValue struct {
+	Type byte
+	data []byte
+}
+
+func (v JSONValue) isObject() bool { return v.Type == JSONSmallObject || v.Type == JSONLargeObject }
+func (v JSONValue) isArray() bool  { return v.Type == JSONSmallArray || v.Type == JSONLargeArray }
+func (v JSONValue) large() bool    { return v.Type == JSONLargeObject || v.Type == JSONLargeArray }
+
+// IsNull reports whether the value is the JSON null literal
+func (v JSONValue) IsNull() bool {
+	return v.Type == JSONLiteral && len(v.data) > 0 && v.data[0] == jsonNull
+}
+
+// Int64 returns the value of an integer scalar
+func (v JSONValue) Int64() (int64, bool) {
+	switch v.Type {
+	case JSONInt16:
+		if len(v.data) >= 2 {
+			return int64(int16(binary.LittleEndian.Uint16(v.data))), true
+		}
+	case JSONUint16:
+		if len(v.data) >= 2 {
+			return int64(binary.LittleEndian.Uint16(v.data)), true
+		}
+	case JSONInt32:
+		if len(v.data) >= 4 {
+			return int64(int32(binary.LittleEndian.Uint32(v.data))), true
+		}
+	case JSONUint32:
+		if len(v.data) >= 4 {
+			return int64(binary.LittleEndian.Uint32(v.data)), true
+		}
+	case JSONInt64, JSONUint64:
+		if len(v.data) >= 8 {
+			n := binary.LittleEndian.Uint64(v.data)
+			return int64(n), v.Type == JSONInt64 || n <= math.MaxInt64
+		}
+	}
+	return 0, false
+}
+
+// StringBytes returns the raw UTF-8 bytes of a string scalar (no copy)
+func (v JSONValue) StringBytes() ([]byte, bool) {
+	if v.Type != JSONString {
+		return nil, false
+	}
+	s, _, err := jsonString(v.data)
+	return s, err == nil
+}
+
+// containerHeader returns element count, total size and the offset width
+func (v JSONValue) containerHeader() (count, size, offSize int, err error) {
+	if v.large() {
+		if len(v.data) < 8 {
+			return 0, 0, 0, ErrInvalidJSON
+		}
+		count = int(binary.LittleEndian.Uint32(v.data))
+		size = int(binary.LittleEndian.Uint32(v.data[4:]))
+		offSize = 4
+	} else {
+		if len(v.data) < 4 {
+			return 0, 0, 0, ErrInvalidJSON
+		}
+		count = int(binary.LittleEndian.Uint16(v.data))
+		size = int(binary.LittleEndian.Uint16(v.data[2:]))
+		offSize = 2
+	}
+	if size > len(v.data) {
+		return 0, 0, 0, ErrInvalidJSON
+	}
+	return count, size, offSize, nil
+}
+
+// readOffset reads a 2- or 4-byte little-endian offset
+func readOffset(b []byte, off, size int) int {
+	if size == 2 {
+		return int(binary.LittleEndian.Uint16(b[off:]))
+	}
+	return int(binary.LittleEndian.Uint32(b[off:]))
+}
+
+// entry resolves the i-th value entry of a container starting at entryBase
+func (v JSONValue) entry(entryBase, i, offSize, size int) (JSONValue, error) {
+	pos := entryBase + i*(1+offSize)
+	if pos+1+offSize > size {
+		return JSONValue{}, ErrInvalidJSON
+	}
+	t := v.data[pos]
+	switch t {
+	case JSONLiteral, JSONInt16, JSONUint16:
+		return JSONValue{Type: t, data: v.data[pos+1 : pos+1+offSize]}, nil
+	case JSONInt32, JSONUint32:
+		if offSize == 4 {
+			return JSONValue{Type: t, data: v.data[pos+1 : pos+1+offSize]}, nil
+		}
+	}
+	off := readOffset(v.data, pos+1, offSize)
+	if off >= size {
+		return JSONValue{}, ErrInvalidJSON
+	}
+	return JSONValue{Type: t, data: v.data[off:size]}, nil
+}
+
+// key returns the i-th key of an object
+func (v JSONValue) key(i, offSize, size int) ([]byte, error) {
+	pos := 2*offSize + i*(offSize+2)
+	if pos+offSize+2 > size {
+		return nil, ErrInvalidJSON
+	}
+	off := readOffset(v.data, pos, offSize)
+	n := int(binary.LittleEndian.Uint16(v.data[pos+offSize:]))
+	if off+n > size {
+		return nil, ErrInvalidJSON
+	}
+	return v.data[off : off+n], nil
+}
+
+// AppendText appends the value as JSON text, formatted like MySQL does
+func (v JSONValue) AppendText(b []byte) ([]byte, error) {
+	return v.appendText(b, 0)
+}
+
+func (v JSONValue) appendText(b []byte, depth int) ([]byte, error) {
+	if depth > maxJSONDepth {
+		return b, ErrInvalidJSON
+	}
+	switch v.Type {
+	case JSONSmallObject, JSONLargeObject:
+		count, size, offSize, err := v.containerHeader()
+		if err != nil {
+			return b, err
+		}
+		values := 2*offSize + count*(offSize+2)
+		b = append(b, '{')
+		for i := 0; i < count; i++ {
+			if i > 0 {
+				b = append(b, ", "...)
+			}
+			k, err := v.key(i, offSize, size)
+			if err != nil {
+				return b, err
+			}
+			b = appendJSONString(b, k)
+			b = append(b, ": "...)
+			e, err := v.entry(values, i, offSize, size)
+			if err != nil {
+				return b, err
+			}
+			if b, err = e.appendText(b, depth+1); err != nil {
+				return b, err
+			}
+		}
+		return append(b, '}'), nil
+
+	case JSONSmallArray, JSONLargeArray:
+		count, size, offSize, err := v.containerHeader()
+		if err != nil {
+			return b, err
+		}
+		b = append(b, '[')
+		for i := 0; i < count; i++ {
+			if i > 0 {
+				b = append(b, ", "...)
+			}
+			e, err := v.entry(2*offSize, i, offSize, size)
+			if err != nil {
+				return b, err
+			}
+			if b, err = e.appendText(b, depth+1); err != nil {
+				return b, err
+			}
+		}
+		return append(b, ']'), nil
+
+	case JSONLiteral:
+		if len(v.data) < 1 {
+			return b, ErrInvalidJSON
+		}
+		switch v.data[0] {
+		case jsonNull:
+			return append(b, "null"...), nil
+		case jsonTrue:
+			return append(b, "true"...), nil
+		case jsonFalse:
+			return append(b, "false"...), nil
+		}
+		return b, ErrInvalidJSON
+
+	case JSONInt16, JSONUint16, JSONInt32, JSONUint32, JSONInt64:
+		n, ok := v.Int64()
+		if !ok {
+			return b, ErrInvalidJSON
+		}
+		return strconv.AppendInt(b, n, 10), nil
+
+	case JSONUint64:
+		if len(v.data) < 8 {
+			return b, ErrInvalidJSON
+		}
+		return strconv.AppendUint(b, binary.LittleEndian.Uint64(v.data), 10), nil
+
+	case JSONDouble:
+		if len(v.data) < 8 {
+			return b, ErrInvalidJSON
+		}
+		return appendJSONDouble(b, math.Float64frombits(binary.LittleEndian.Uint64(v.data))), nil
+
+	case JSONString:
+		s, _, err := jsonString(v.data)
+		if err != nil {
+			return b, err
+		}
+		return appendJSONString(b, s), nil
+
+	case JSONOpaque:
+		return appendJSONOpaque(b, v.data)
+	}
+	return b, ErrInvalidJSON
+}
+
+// jsonVarLen reads the variable-length integer used for string lengths
+func jsonVarLen(b []byte) (n, used int, err error) {
+	for i := 0; i < 5 && i < len(b); i++ {
+		n |= int(b[i]&0x7F) << (7 * i)
+		if b[i]&0x80 == 0 {
+			return n, i + 1, nil
+		}
+	}
+	return 0, 0, ErrInvalidJSON
+}
+
+// jsonString returns the bytes of a length-prefixed string
+func jsonString(b []byte) ([]byte, int, error) {
+	n, used, err := jsonVarLen(b)
+	if err != nil || used+n > len(b) {
+		return nil, 0, ErrInvalidJSON
+	}
+	return b[used : used+n], used + n, nil
+}
+
+// appendJSONString appends s as a quoted, escaped JSON string
+func appendJSONString(b, s []byte) []byte {
+	b = append(b, '"')
+	start := 0
+	for i := 0; i < len(s); i++ {
+		c := s[i]
+		if c >= 0x20 && c != '"' && c != '\\' {
+			continue
+		}
+		b = append(b, s[start:i]...)
+		switch c {
+		case '"', '\\':
+			b = append(b, '\\', c)
+		case '\n':
+			b = append(b, '\\', 'n')
+		case '\r':
+			b = append(b, '\\', 'r')
+		case '\t':
+			b = append(b, '\\', 't')
+		case '\b':
+			b = append(b, '\\', 'b')
+		case '\f':
+			b = append(b, '\\', 'f')
+		default:
+			const hex = "0123456789abcdef"
+			b = append(b, '\\', 'u', '0', '0', hex[c>>4], hex[c&0xF])
+		}
+		start = i + 1
+	}
+	b = append(b, s[start:]...)
+	return append(b, '"')
+}
+
+// appendJSONDouble appends a double the way MySQL prints it: shortest
+// round-trip digits, with ".0" kept on integral values
+func appendJSONDouble(b []byte, f float64) []byte {
+	start := len(b)
+	b = strconv.AppendFloat(b, f, 'g', -1, 64)
+	for _, c := range b[start:] {
+		if c == '.' || c == 'e' || c == 'n' || c == 'I' {
+			return b
+		}
+	}
+	return append(b, '.', '0')
+}
+
+// appendJSONOpaque appends an opaque value: temporal and DECIMAL values are
+// printed as strings, anything else in MySQL's base64:typeN:... form
+func appendJSONOpaque(b []byte, data []byte) ([]byte, error) {
+	if len(data) < 1 {
+		return b, ErrInvalidJSON
+	}
+	fieldType := data[0]
+	payload, _, err := jsonString(data[1:])
+	if err != nil {
+		return b, err
+	}
+	switch fieldType {
+	case mysqlTypeNewDecimal:
+		if len(payload) < 2 {
+			return b, ErrInvalidJSON
+		}
+		// Precision and scale come from the stored value, so a corrupt
+		// pair must not size the digit groups
+		l := DecimalLayoutFor(int(payload[0]), int(payload[1]))
+		if l == nil || 2+l.Size > len(payload) {
+			return b, ErrInvalidJSON
+		}
+		return l.AppendText(b, payload, 2)
+
+	case mysqlTypeDate, mysqlTypeDateTime, mysqlTypeTimestamp, mysqlTypeTime:
+		if len(payload) < 8 {
+			return b, ErrInvalidJSON
+		}
+		packed := int64(binary.LittleEndian.Uint64(payload))
+		b = append(b, '"')
+		switch fieldType {
+		case mysqlTypeTime:
+			b = Time{Packed: packed, Precision: 6}.AppendFormat(b)
+		case mysqlTypeDate:
+			dt := DateTime{Packed: packed}
+			b = Date(dt.Year()<<9 | dt.Month()<<5 | dt.Day()).AppendFormat(b)
+		default:
+			b = DateTime{Packed: packed, Precision: 6}.AppendFormat(b)
+		}
+		return append(b, '"'), nil
+	}
+
+	b = append(b, `"base64:type`...)
+	b = strconv.AppendInt(b, int64(fieldType), 10)
+	b = append(b, ':')
+	n := len(b)
+	b = append(b, make([]byte, base64.StdEncoding.EncodedLen(len(payload)))...)
+	base64.StdEncoding.Encode(b[n:], payload)
+	return append(b, '"'), nil
+}
+
+// JSONPath is a compiled path such as $.customer.id or $.items[2].sku.
+// Only member and array-index legs are supported (no wildcards).
+type JSONPath struct {
+	legs []jsonPathLeg
+}
+
+type jsonPathLeg struct {
+	key   []byte
+	index int // -1 for member legs
+}
+
+// CompileJSONPath parses a JSON path expression once for repeated use
+func CompileJSONPath(path string) (JSONPath, error) {
+	var p JSONPath
+	if len(path) == 0 || path[0] != '$' {
+		return p, ErrInvalidJSONPath
+	}
+	i := 1
+	for i < len(path) {
+		switch path[i] {
+		case '.':
+			i++
+			if i < len(path) && path[i] == '"' {
+				// Quoted member name
+				j := i + 1
+				var key []byte
+				for ; j < len(path) && path[j] != '"'; j++ {
+					if path[j] == '\\' && j+1 < len(path) {
+						j++
+					}
+					key = append(key, path[j])
+				}
+				if j >= len(path) {
+					return p, ErrInvalidJSONPath
+				}
+				p.legs = append(p.legs, jsonPathLeg{key: key, index: -1})
+				i = j + 1
+				continue
+			}
+			j := i
+			for j < len(path) && path[j] != '.' && path[j] != '[' {
+				j++
+			}
+			if j == i || path[i:j] == "*" {
+				return p, ErrInvalidJSONPath
+			}
+			p.legs = append(p.legs, jsonPathLeg{key: []byte(path[i:j]), index: -1})
+			i = j
+		case '[':
+			j := i + 1
+			for j < len(path) && path[j] != ']' {
+				j++
+			}
+			if j >= len(path) {
+				return p, ErrInvalidJSONPath
+			}
+			n, err := strconv.Atoi(path[i+1 : j])
+			if err != nil || n < 0 {
+				return p, ErrInvalidJSONPath
+			}
+			p.legs = append(p.legs, jsonPathLeg{index: n})
+			i = j + 1
+		case ' ':
+			i++
+		default:
+			return p, ErrInvalidJSONPath
+		}
+	}
+	return p, nil
+}
+
+// Extract returns the value at the path, or false if it does not exist.
+// Only the offset tables along the path are read.
+func (p JSONPath) Extract(doc JSON) (JSONValue, bool, error) {
+	v, err := doc.Value()
+	if err != nil {
+		return JSONValue{}, false, err
+	}
+	for _, leg := range p.legs {
+		var found bool
+		if leg.index >= 0 {
+			v, found, err = v.arrayElement(leg.index)
+		} else {
+			v, found, err = v.member(leg.key)
+		}
+		if err != nil || !found {
+			return JSONValue{}, false, err
+		}
+	}
+	return v, true, nil
+}
+
+// arrayElement returns the i-th element of an array
+func (v JSONValue) arrayElement(i int) (JSONValue, bool, error) {
+	if !v.isArray() {
+		// MySQL treats a scalar as a one-element array for [0]
+		return v, i == 0 && !v.isObject(), nil
+	}
+	count, size, offSize, err := v.containerHeader()
+	if err != nil || i >= count {
+		return JSONValue{}, false, err
+	}
+	e, err := v.entry(2*offSize, i, offSize, size)
+	return e, err == nil, err
+}
+
+// member looks up a key in an object by binary search over the sorted keys
+func (v JSONValue) member(name []byte) (JSONValue, bool, error) {
+	if !v.isObject() {
+		return JSONValue{}, false, nil
+	}
+	count, size, offSize, err := v.containerHeader()
+	if err != nil {
+		return JSONValue{}, false, err
+	}
+	lo, hi := 0, count
+	for lo < hi {
+		mid := int(uint(lo+hi) >> 1)
+		k, err := v.key(mid, offSize, size)
+		if err != nil {
+			return JSONValue{}, false, err
+		}
+		if c := compareJSONKeys(k, name); c == 0 {
+			e, err := v.entry(2*offSize+count*(offSize+2), mid, offSize, size)
+			return e, err == nil, err
+		} else if c < 0 {
+			lo = mid + 1
+		} else {
+			hi = mid
+		}
+	}
+	return JSONValue{}, false, nil
+}
+
+// compareJSONKeys orders keys the way MySQL stores them: by length, then bytes
+func compareJSONKeys(a, b []byte) int {
+	if len(a) != len(b) {
+		if len(a) < len(b) {
+			return -1
+		}
+		return 1
+	}
+	for i := range a {
+		if a[i] != b[i] {
+			if a[i] < b[i] {
+				return -1
+			}
+			return 1
+		}
+	}
+	return 0
+}
@@ -0,0 +1,36 @@
+// json_parser.go - Parser for JSON column type
+package column
+
+import (
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// JSONParser handles JSON columns. Values are returned as JSON, a view of
+// the binary document in the page; convert with AppendText/String or pull
+// single fields with a compiled JSONPath.
+type JSONParser struct {
+	BaseParser
+}
+
+// Parse returns the binary JSON document stored in the record
+func (p *JSONParser) Parse(input []byte, offset int, col *schema.Column, varLen int) (interface{}, int, error) {
+	if col.ResolvedCode() != schema.CodeJSON {
+		return nil, 0, schema.ErrUnsupportedType
+	}
+	if varLen <= 0 {
+		return JSON(nil), 0, nil
+	}
+	data, err := p.readBytes(input, offset, varLen)
+	if err != nil {
+		return nil, 0, err
+	}
+	return JSON(data), varLen, nil
+}
+
+// Skip skips JSON value without parsing
+func (p *JSONParser) Skip(input []byte, offset int, col *schema.Column, varLen int) (int, error) {
+	if col.ResolvedCode() != schema.CodeJSON {
+		return 0, schema.ErrUnsupportedType
+	}
+	return varLen, nil
+}
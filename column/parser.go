@@ -90,17 +90,13 @@ func (p *BaseParser) readInt64(input []byte, offset int) (int64, error) {
 	return int64(val ^ 0x8000000000000000), nil
 }
 
-// readMediumInt reads a 3-byte signed integer with XOR transformation
+// readMediumInt reads a 3-byte signed integer (big-endian) with XOR transformation
 func (p *BaseParser) readMediumInt(input []byte, offset int) (int32, error) {
-	if offset+3 > len(input) {
-		return 0, format.ErrShortRead
+	val, err := p.readUnsignedMediumInt(input, offset)
+	if err != nil {
+		return 0, err
 	}
 
-	// Read 3 bytes as unsigned
-	val := uint32(input[offset]) |
-		(uint32(input[offset+1]) << 8) |
-		(uint32(input[offset+2]) << 16)
-
 	// XOR with sign bit
 	val ^= 0x800000
 
@@ -112,13 +108,13 @@ func (p *BaseParser) readMediumInt(input []byte, offset int) (int32, error) {
 	return int32(val), nil
 }
 
-// readUnsignedMediumInt reads a 3-byte unsigned integer
+// readUnsignedMediumInt reads a 3-byte unsigned integer (big-endian)
 func (p *BaseParser) readUnsignedMediumInt(input []byte, offset int) (uint32, error) {
-	if offset+3 > len(input) {
+	if offset < 0 || offset+3 > len(input) {
 		return 0, format.ErrShortRead
 	}
 
-	return uint32(input[offset]) |
-		(uint32(input[offset+1]) << 8) |
-		(uint32(input[offset+2]) << 16), nil
+	return uint32(input[offset])<<16 |
+		uint32(input[offset+1])<<8 |
+		uint32(input[offset+2]), nil
 }
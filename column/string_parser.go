@@ -3,7 +3,6 @@ package column
 
 import (
 	"github.com/wilhasse/go-innodb/schema"
-	"strings"
 )
 
 // StringParser handles VARCHAR, CHAR, TEXT and other string types
@@ -11,103 +10,40 @@ type StringParser struct {
 	BaseParser
 }
 
-// Parse parses string value based on column type
+// Parse parses string value based on column type.
+// Text types are copied into a Go string; binary types are returned as
+// slices of input. Use ParseView to avoid the copy for text types too.
 func (p *StringParser) Parse(input []byte, offset int, col *schema.Column, varLen int) (interface{}, int, error) {
-	var bytesRead int
-
-	switch col.Type {
-	case schema.TypeChar:
-		// CHAR can be variable length in multi-byte charsets
-		if col.IsVariableLength() && varLen > 0 {
-			// Variable length CHAR
-			data, err := p.readBytes(input, offset, varLen)
-			if err != nil {
-				return nil, 0, err
-			}
-			bytesRead = varLen
-			// Trim trailing spaces for CHAR
-			str := string(data)
-			str = strings.TrimRight(str, " ")
-			return str, bytesRead, nil
-		} else {
-			// Fixed length CHAR
-			length := col.Length
-			if col.Charset == "utf8mb4" {
-				length *= 4 // Maximum bytes per character
-			} else if col.Charset == "utf8" {
-				length *= 3
-			}
-			data, err := p.readBytes(input, offset, length)
-			if err != nil {
-				return nil, 0, err
-			}
-			bytesRead = length
-			// Trim trailing spaces
-			str := string(data)
-			str = strings.TrimRight(str, " ")
-			return str, bytesRead, nil
-		}
-
-	case schema.TypeVarchar, schema.TypeText, schema.TypeTinyText,
-		schema.TypeMediumText, schema.TypeLongText:
-		// Variable length string types use varLen parameter
-		if varLen <= 0 {
-			return "", 0, nil
-		}
-		data, err := p.readBytes(input, offset, varLen)
-		if err != nil {
-			return nil, 0, err
-		}
-		return string(data), varLen, nil
-
-	case schema.TypeBinary:
-		// Fixed length binary
-		length := col.Length
-		data, err := p.readBytes(input, offset, length)
-		if err != nil {
-			return nil, 0, err
-		}
-		return data, length, nil
-
-	case schema.TypeVarBinary, schema.TypeBlob, schema.TypeTinyBlob,
-		schema.TypeMediumBlob, schema.TypeLongBlob:
-		// Variable length binary types
-		if varLen <= 0 {
-			return []byte{}, 0, nil
-		}
-		data, err := p.readBytes(input, offset, varLen)
-		if err != nil {
-			return nil, 0, err
-		}
-		return data, varLen, nil
+	v, bytesRead, err := p.ParseView(input, offset, col, varLen)
+	if err != nil {
+		return nil, 0, err
+	}
 
+	switch col.ResolvedCode() {
+	case schema.CodeChar, schema.CodeVarchar, schema.CodeText, schema.CodeTinyText,
+		schema.CodeMediumText, schema.CodeLongText:
+		return string(v), bytesRead, nil
 	default:
-		return nil, 0, schema.ErrUnsupportedType
+		return []byte(v), bytesRead, nil
 	}
 }
 
 // Skip skips string value without parsing
 func (p *StringParser) Skip(input []byte, offset int, col *schema.Column, varLen int) (int, error) {
-	switch col.Type {
-	case schema.TypeChar:
+	switch col.ResolvedCode() {
+	case schema.CodeChar:
 		if col.IsVariableLength() && varLen > 0 {
 			return varLen, nil
 		}
-		length := col.Length
-		if col.Charset == "utf8mb4" {
-			length *= 4
-		} else if col.Charset == "utf8" {
-			length *= 3
-		}
-		return length, nil
+		return col.Length * col.CharsetMaxLen, nil
 
-	case schema.TypeVarchar, schema.TypeText, schema.TypeTinyText,
-		schema.TypeMediumText, schema.TypeLongText,
-		schema.TypeVarBinary, schema.TypeBlob, schema.TypeTinyBlob,
-		schema.TypeMediumBlob, schema.TypeLongBlob:
+	case schema.CodeVarchar, schema.CodeText, schema.CodeTinyText,
+		schema.CodeMediumText, schema.CodeLongText,
+		schema.CodeVarBinary, schema.CodeBlob, schema.CodeTinyBlob,
+		schema.CodeMediumBlob, schema.CodeLongBlob:
 		return varLen, nil
 
-	case schema.TypeBinary:
+	case schema.CodeBinary:
 		return col.Length, nil
 
 	default:
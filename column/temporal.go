@@ -0,0 +1,334 @@
+// temporal.go - Compact typed values for DATE, DATETIME, TIMESTAMP and TIME columns
+package column
+
+import (
+	"time"
+
+	"github.com/wilhasse/go-innodb/format"
+)
+
+// The temporal types below keep the decoded value in a small packed form and
+// only turn it into text when AppendFormat (or String) is called. Decoding a
+// column therefore never allocates; callers that write many values should use
+// AppendFormat with a reused buffer.
+
+// On-disk offsets subtracted from the big-endian integer parts (see MySQL's
+// my_time.h: DATETIMEF_INT_OFS and TIMEF_INT_OFS).
+const (
+	datetimeIntOfs = 0x8000000000
+	timeIntOfs     = 0x800000
+)
+
+// Date is a DATE value packed as year<<9 | month<<5 | day.
+type Date uint32
+
+// Year returns the year component
+func (d Date) Year() int { return int(d >> 9) }
+
+// Month returns the month component (1-12, 0 for zero dates)
+func (d Date) Month() int { return int(d>>5) & 0x0F }
+
+// Day returns the day component (1-31, 0 for zero dates)
+func (d Date) Day() int { return int(d) & 0x1F }
+
+// AppendFormat appends the value as YYYY-MM-DD
+func (d Date) AppendFormat(b []byte) []byte {
+	b = appendPadded(b, uint64(d.Year()), 4)
+	b = append(b, '-')
+	b = appendPadded(b, uint64(d.Month()), 2)
+	b = append(b, '-')
+	return appendPadded(b, uint64(d.Day()), 2)
+}
+
+func (d Date) String() string {
+	var buf [10]byte
+	return string(d.AppendFormat(buf[:0]))
+}
+
+// DateTime is a DATETIME value in MySQL's packed representation:
+// (ymd<<17 | hms) << 24 | microseconds, together with the column's
+// fractional-second precision.
+type DateTime struct {
+	Packed    int64
+	Precision uint8
+}
+
+func (dt DateTime) ymdhms() int64 { return dt.Packed >> 24 }
+
+// Year returns the year component
+func (dt DateTime) Year() int { return int(dt.ymdhms()>>22) / 13 }
+
+// Month returns the month component
+func (dt DateTime) Month() int { return int(dt.ymdhms()>>22) % 13 }
+
+// Day returns the day component
+func (dt DateTime) Day() int { return int(dt.ymdhms()>>17) & 0x1F }
+
+// Hour returns the hour component
+func (dt DateTime) Hour() int { return int(dt.ymdhms()>>12) & 0x1F }
+
+// Minute returns the minute component
+func (dt DateTime) Minute() int { return int(dt.ymdhms()>>6) & 0x3F }
+
+// Second returns the second component
+func (dt DateTime) Second() int { return int(dt.ymdhms()) & 0x3F }
+
+// Microsecond returns the fractional part in microseconds
+func (dt DateTime) Microsecond() int { return int(dt.Packed & 0xFFFFFF) }
+
+// Time converts the value to a time.Time in UTC
+func (dt DateTime) Time() time.Time {
+	return time.Date(dt.Year(), time.Month(dt.Month()), dt.Day(),
+		dt.Hour(), dt.Minute(), dt.Second(), dt.Microsecond()*1000, time.UTC)
+}
+
+// AppendFormat appends the value as YYYY-MM-DD hh:mm:ss[.fraction]
+func (dt DateTime) AppendFormat(b []byte) []byte {
+	b = appendPadded(b, uint64(dt.Year()), 4)
+	b = append(b, '-')
+	b = appendPadded(b, uint64(dt.Month()), 2)
+	b = append(b, '-')
+	b = appendPadded(b, uint64(dt.Day()), 2)
+	b = append(b, ' ')
+	b = appendClock(b, dt.Hour(), dt.Minute(), dt.Second())
+	return appendFraction(b, dt.Microsecond(), dt.Precision)
+}
+
+func (dt DateTime) String() string {
+	var buf [26]byte
+	return string(dt.AppendFormat(buf[:0]))
+}
+
+// Timestamp is a TIMESTAMP value: seconds since the Unix epoch (UTC) plus
+// microseconds. A zero Sec is MySQL's zero timestamp.
+type Timestamp struct {
+	Sec       uint32
+	Usec      uint32
+	Precision uint8
+}
+
+// Time converts the value to a time.Time in UTC
+func (ts Timestamp) Time() time.Time {
+	return time.Unix(int64(ts.Sec), int64(ts.Usec)*1000).UTC()
+}
+
+// AppendFormat appends the value as YYYY-MM-DD hh:mm:ss[.fraction] in UTC
+func (ts Timestamp) AppendFormat(b []byte) []byte {
+	if ts.Sec == 0 && ts.Usec == 0 {
+		b = append(b, "0000-00-00 00:00:00"...)
+		return appendFraction(b, 0, ts.Precision)
+	}
+	t := time.Unix(int64(ts.Sec), 0).UTC()
+	year, month, day := t.Date()
+	hour, min, sec := t.Clock()
+	b = appendPadded(b, uint64(year), 4)
+	b = append(b, '-')
+	b = appendPadded(b, uint64(month), 2)
+	b = append(b, '-')
+	b = appendPadded(b, uint64(day), 2)
+	b = append(b, ' ')
+	b = appendClock(b, hour, min, sec)
+	return appendFraction(b, int(ts.Usec), ts.Precision)
+}
+
+func (ts Timestamp) String() string {
+	var buf [26]byte
+	return string(ts.AppendFormat(buf[:0]))
+}
+
+// Time is a TIME value in MySQL's packed representation:
+// ±(hms << 24 | microseconds), together with the column's fractional-second
+// precision.
+type Time struct {
+	Packed    int64
+	Precision uint8
+}
+
+func (t Time) abs() int64 {
+	if t.Packed < 0 {
+		return -t.Packed
+	}
+	return t.Packed
+}
+
+// Negative reports whether the value is a negative interval
+func (t Time) Negative() bool { return t.Packed < 0 }
+
+// Hours returns the hour component (0-838)
+func (t Time) Hours() int { return int(t.abs()>>36) & 0x3FF }
+
+// Minutes returns the minute component
+func (t Time) Minutes() int { return int(t.abs()>>30) & 0x3F }
+
+// Seconds returns the second component
+func (t Time) Seconds() int { return int(t.abs()>>24) & 0x3F }
+
+// Microseconds returns the fractional part in microseconds
+func (t Time) Microseconds() int { return int(t.abs() & 0xFFFFFF) }
+
+// Duration converts the value to a time.Duration
+func (t Time) Duration() time.Duration {
+	d := time.Duration(t.Hours())*time.Hour + time.Duration(t.Minutes())*time.Minute +
+		time.Duration(t.Seconds())*time.Second + time.Duration(t.Microseconds())*time.Microsecond
+	if t.Negative() {
+		return -d
+	}
+	return d
+}
+
+// AppendFormat appends the value as [-]hh:mm:ss[.fraction]
+func (t Time) AppendFormat(b []byte) []byte {
+	if t.Negative() {
+		b = append(b, '-')
+	}
+	b = appendClock(b, t.Hours(), t.Minutes(), t.Seconds())
+	return appendFraction(b, t.Microseconds(), t.Precision)
+}
+
+func (t Time) String() string {
+	var buf [18]byte
+	return string(t.AppendFormat(buf[:0]))
+}
+
+// DecodeDate decodes a 3-byte DATE (big-endian, sign bit flipped)
+func DecodeDate(input []byte, offset int) (Date, error) {
+	if offset < 0 || offset+3 > len(input) {
+		return 0, format.ErrShortRead
+	}
+	v := readBE(input[offset:], 3) ^ 0x800000
+	return Date(v), nil
+}
+
+// DecodeDateTime decodes a DATETIME(precision) value and returns it with the
+// number of bytes consumed (5 + fractional bytes).
+func DecodeDateTime(input []byte, offset int, precision int) (DateTime, int, error) {
+	fracBytes := fracSize(precision)
+	n := 5 + fracBytes
+	if offset < 0 || offset+n > len(input) {
+		return DateTime{}, 0, format.ErrShortRead
+	}
+	intPart := int64(readBE(input[offset:], 5)) - datetimeIntOfs
+	frac := fracMicros(input[offset+5:], fracBytes)
+	return DateTime{Packed: intPart<<24 + frac, Precision: uint8(precision)}, n, nil
+}
+
+// DecodeTimestamp decodes a TIMESTAMP(precision) value and returns it with
+// the number of bytes consumed (4 + fractional bytes).
+func DecodeTimestamp(input []byte, offset int, precision int) (Timestamp, int, error) {
+	fracBytes := fracSize(precision)
+	n := 4 + fracBytes
+	if offset < 0 || offset+n > len(input) {
+		return Timestamp{}, 0, format.ErrShortRead
+	}
+	return Timestamp{
+		Sec:       uint32(readBE(input[offset:], 4)),
+		Usec:      uint32(fracMicros(input[offset+4:], fracBytes)),
+		Precision: uint8(precision),
+	}, n, nil
+}
+
+// DecodeTime decodes a TIME(precision) value and returns it with the number
+// of bytes consumed (3 + fractional bytes).
+func DecodeTime(input []byte, offset int, precision int) (Time, int, error) {
+	fracBytes := fracSize(precision)
+	n := 3 + fracBytes
+	if offset < 0 || offset+n > len(input) {
+		return Time{}, 0, format.ErrShortRead
+	}
+	var packed int64
+	switch fracBytes {
+	case 0:
+		packed = (int64(readBE(input[offset:], 3)) - timeIntOfs) << 24
+	case 3:
+		// 6 bytes hold the whole packed value, biased by TIMEF_OFS
+		packed = int64(readBE(input[offset:], 6)) - timeIntOfs<<24
+	default:
+		// The fraction of a negative value is stored as a negative
+		// complement of the integer part (see my_time_packed_from_binary).
+		intPart := int64(readBE(input[offset:], 3)) - timeIntOfs
+		frac := int64(readBE(input[offset+3:], fracBytes))
+		if intPart < 0 && frac != 0 {
+			intPart++
+			frac -= 1 << (8 * fracBytes)
+		}
+		if fracBytes == 1 {
+			frac *= 10000
+		} else {
+			frac *= 100
+		}
+		packed = intPart<<24 + frac
+	}
+	return Time{Packed: packed, Precision: uint8(precision)}, n, nil
+}
+
+// fracSize returns the number of bytes used for fractional seconds
+func fracSize(precision int) int {
+	if precision <= 0 {
+		return 0
+	}
+	return (precision + 1) / 2
+}
+
+// fracMicros reads an unsigned big-endian fraction and scales it to microseconds
+func fracMicros(b []byte, fracBytes int) int64 {
+	switch fracBytes {
+	case 1:
+		return int64(b[0]) * 10000
+	case 2:
+		return int64(readBE(b, 2)) * 100
+	case 3:
+		return int64(readBE(b, 3))
+	}
+	return 0
+}
+
+// readBE reads an n-byte big-endian unsigned integer (n <= 8)
+func readBE(b []byte, n int) uint64 {
+	_ = b[n-1]
+	var v uint64
+	for i := 0; i < n; i++ {
+		v = v<<8 | uint64(b[i])
+	}
+	return v
+}
+
+// appendClock appends hh:mm:ss; hours wider than two digits are kept whole
+func appendClock(b []byte, hour, min, sec int) []byte {
+	b = appendPadded(b, uint64(hour), 2)
+	b = append(b, ':')
+	b = appendPadded(b, uint64(min), 2)
+	b = append(b, ':')
+	return appendPadded(b, uint64(sec), 2)
+}
+
+// appendFraction appends "." and the first precision digits of usec
+func appendFraction(b []byte, usec int, precision uint8) []byte {
+	if precision == 0 {
+		return b
+	}
+	if precision > 6 {
+		precision = 6
+	}
+	var digits [6]byte
+	for i := 5; i >= 0; i-- {
+		digits[i] = byte('0' + usec%10)
+		usec /= 10
+	}
+	b = append(b, '.')
+	return append(b, digits[:precision]...)
+}
+
+// appendPadded appends v in decimal, left-padded with zeros to width digits
+func appendPadded(b []byte, v uint64, width int) []byte {
+	var digits [20]byte
+	i := len(digits)
+	for v >= 10 || width > 1 {
+		i--
+		digits[i] = byte('0' + v%10)
+		v /= 10
+		width--
+	}
+	i--
+	digits[i] = byte('0' + v)
+	return append(b, digits[i:]...)
+}
@@ -0,0 +1,105 @@
+// view.go - Zero-copy string and binary column values
+package column
+
+import (
+	"encoding/binary"
+
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// View is a string or binary column value that references the page buffer
+// it was decoded from instead of copying it. A View is only valid while that
+// buffer is alive and unmodified (for pooled pages: until the page is
+// released); use Clone to keep the value beyond that point.
+type View []byte
+
+// String copies the value into a Go string
+func (v View) String() string { return string(v) }
+
+// Bytes returns the underlying bytes without copying
+func (v View) Bytes() []byte { return v }
+
+// Clone returns a copy of the value that does not reference the page buffer
+func (v View) Clone() View {
+	if v == nil {
+		return nil
+	}
+	return append(View(make([]byte, 0, len(v))), v...)
+}
+
+// AppendTo appends the raw bytes of the value to b
+func (v View) AppendTo(b []byte) []byte { return append(b, v...) }
+
+// ParseView decodes a string or binary column as a View into input.
+// CHAR values have their trailing space padding removed; all other types
+// are returned as stored.
+func (p *StringParser) ParseView(input []byte, offset int, col *schema.Column, varLen int) (View, int, error) {
+	switch col.ResolvedCode() {
+	case schema.CodeChar:
+		// CHAR can be variable length in multi-byte charsets
+		length := varLen
+		if !col.IsVariableLength() || varLen <= 0 {
+			// Fixed length CHAR (Length * maximum bytes per character)
+			length = col.Length * col.CharsetMaxLen
+		}
+		data, err := p.readBytes(input, offset, length)
+		if err != nil {
+			return nil, 0, err
+		}
+		return View(TrimSpacePadding(data)), length, nil
+
+	case schema.CodeBinary:
+		// Fixed length binary
+		data, err := p.readBytes(input, offset, col.Length)
+		if err != nil {
+			return nil, 0, err
+		}
+		return View(data), col.Length, nil
+
+	case schema.CodeVarchar, schema.CodeText, schema.CodeTinyText,
+		schema.CodeMediumText, schema.CodeLongText,
+		schema.CodeVarBinary, schema.CodeBlob, schema.CodeTinyBlob,
+		schema.CodeMediumBlob, schema.CodeLongBlob:
+		// Variable length types use the varLen parameter
+		if varLen <= 0 {
+			return View{}, 0, nil
+		}
+		data, err := p.readBytes(input, offset, varLen)
+		if err != nil {
+			return nil, 0, err
+		}
+		return View(data), varLen, nil
+
+	default:
+		return nil, 0, schema.ErrUnsupportedType
+	}
+}
+
+// ParseColumnView parses a column like ParseColumn, but string and binary
+// columns are returned as Views into input instead of copies.
+func ParseColumnView(input []byte, offset int, col *schema.Column, varLen int) (interface{}, int, error) {
+	parser := GetParser(col)
+	if parser == stringParser {
+		return stringParser.ParseView(input, offset, col, varLen)
+	}
+	if parser == nil {
+		return nil, 0, schema.ErrUnsupportedType
+	}
+	return parser.Parse(input, offset, col, varLen)
+}
+
+const spaces8 = 0x2020202020202020
+
+// TrimSpacePadding removes trailing spaces from b without copying.
+// It compares eight bytes at a time, so long CHAR padding costs one load
+// and compare per word.
+func TrimSpacePadding(b []byte) []byte {
+	n := len(b)
+	for n >= 8 && binary.LittleEndian.Uint64(b[n-8:n]) == spaces8 {
+		n -= 8
+	}
+	for n > 0 && b[n-1] == ' ' {
+		n--
+	}
+	return b[:n]
+}
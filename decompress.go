@@ -18,10 +18,25 @@ package goinnodb
 //     return innodb_get_page_info((const unsigned char*)data, size, info);
 // }
 //
+// static int wrap_innodb_get_pages_info_soa(unsigned char* pages, size_t n, size_t size,
+//         uint32_t* page_number, uint16_t* page_type, uint32_t* space_id, uint64_t* lsn,
+//         uint32_t* prev, uint32_t* next, uint16_t* level, uint64_t* index_id) {
+//     innodb_pages_info_soa_t out = {page_number, page_type, space_id, lsn, prev, next, level, index_id};
+//     return innodb_get_pages_info_soa((const unsigned char*)pages, n, size, &out);
+// }
+//
 // static int wrap_innodb_decompress_page(unsigned char* in, size_t in_size, unsigned char* out, size_t out_size, size_t* written) {
 //     return innodb_decompress_page((const unsigned char*)in, in_size, out, out_size, written);
 // }
 //
+// static int wrap_innodb_decompressor_page(innodb_decompressor_t* h, unsigned char* in, unsigned char* out, size_t* written) {
+//     return innodb_decompressor_page(h, (const unsigned char*)in, out, written);
+// }
+//
+// static int wrap_innodb_decompressor_pages(innodb_decompressor_t* h, unsigned char* in, size_t n, unsigned char* out, size_t* done) {
+//     return innodb_decompressor_pages(h, (const unsigned char*)in, n, out, done);
+// }
+//
 // static int wrap_innodb_process_page(unsigned char* in, size_t in_size, unsigned char* out, size_t out_size, size_t* written) {
 //     return innodb_process_page((const unsigned char*)in, in_size, out, out_size, written);
 // }
@@ -29,6 +44,9 @@ import "C"
 import (
 	"fmt"
 	"unsafe"
+
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/scan"
 )
 
 // Error codes from the C library
@@ -123,66 +141,254 @@ func GetPageInfo(data []byte) (*PageInfo, error) {
 	}, nil
 }
 
+// PagesInfo holds the headers of many pages as parallel arrays, filled by
+// GetPagesInfoSoA. Level and IndexID are meaningful only for INDEX pages;
+// Prev and Next keep the on-disk FIL_NULL (0xFFFFFFFF).
+type PagesInfo struct {
+	PageNumber []uint32
+	PageType   []uint16
+	SpaceID    []uint32
+	LSN        []uint64
+	Prev       []uint32
+	Next       []uint32
+	Level      []uint16
+	IndexID    []uint64
+}
+
+// GetPagesInfoSoA extracts the headers of the consecutive pages in data
+// (for example a whole mmapped extent) in one C call. pageSize is the
+// physical page size. The arrays of info are resized to the page count,
+// reusing their capacity.
+func GetPagesInfoSoA(data []byte, pageSize int, info *PagesInfo) error {
+	if pageSize <= 0 {
+		return newDecompressError(DecompressErrorInvalidSize)
+	}
+	n := len(data) / pageSize
+	info.PageNumber = resizeU32(info.PageNumber, n)
+	info.PageType = resizeU16(info.PageType, n)
+	info.SpaceID = resizeU32(info.SpaceID, n)
+	info.LSN = resizeU64(info.LSN, n)
+	info.Prev = resizeU32(info.Prev, n)
+	info.Next = resizeU32(info.Next, n)
+	info.Level = resizeU16(info.Level, n)
+	info.IndexID = resizeU64(info.IndexID, n)
+	if n == 0 {
+		return nil
+	}
+
+	code := C.wrap_innodb_get_pages_info_soa(
+		(*C.uchar)(unsafe.Pointer(&data[0])), C.size_t(n), C.size_t(pageSize),
+		(*C.uint32_t)(unsafe.Pointer(&info.PageNumber[0])),
+		(*C.uint16_t)(unsafe.Pointer(&info.PageType[0])),
+		(*C.uint32_t)(unsafe.Pointer(&info.SpaceID[0])),
+		(*C.uint64_t)(unsafe.Pointer(&info.LSN[0])),
+		(*C.uint32_t)(unsafe.Pointer(&info.Prev[0])),
+		(*C.uint32_t)(unsafe.Pointer(&info.Next[0])),
+		(*C.uint16_t)(unsafe.Pointer(&info.Level[0])),
+		(*C.uint64_t)(unsafe.Pointer(&info.IndexID[0])),
+	)
+	return newDecompressError(code)
+}
+
+func resizeU16(s []uint16, n int) []uint16 {
+	if cap(s) < n {
+		return make([]uint16, n)
+	}
+	return s[:n]
+}
+
+func resizeU32(s []uint32, n int) []uint32 {
+	if cap(s) < n {
+		return make([]uint32, n)
+	}
+	return s[:n]
+}
+
+func resizeU64(s []uint64, n int) []uint64 {
+	if cap(s) < n {
+		return make([]uint64, n)
+	}
+	return s[:n]
+}
+
 // DecompressPageV2 decompresses a compressed InnoDB page
 // (V2 suffix to avoid conflict with existing DecompressPage in compressed.go)
 func DecompressPageV2(compressedData []byte) ([]byte, error) {
+	output := make([]byte, 16384)
+	n, err := DecompressPageInto(output, compressedData)
+	if err != nil {
+		return nil, err
+	}
+	return output[:n], nil
+}
+
+// DecompressPageInto decompresses a compressed InnoDB page into dst (usually
+// a pooled buffer from page.GetBuffer) and returns the bytes written
+func DecompressPageInto(dst, compressedData []byte) (int, error) {
 	if len(compressedData) == 0 {
-		return nil, fmt.Errorf("empty compressed data")
+		return 0, fmt.Errorf("empty compressed data")
+	}
+	if len(dst) == 0 {
+		return 0, newDecompressError(DecompressErrorBufferSmall)
 	}
 
-	// Allocate output buffer (16KB for decompressed page)
-	outputSize := 16384
-	output := make([]byte, outputSize)
 	var bytesWritten C.size_t
 
 	var inPtr *C.uchar = (*C.uchar)(unsafe.Pointer(&compressedData[0]))
-	var outPtr *C.uchar = (*C.uchar)(unsafe.Pointer(&output[0]))
+	var outPtr *C.uchar = (*C.uchar)(unsafe.Pointer(&dst[0]))
 	code := C.wrap_innodb_decompress_page(
 		inPtr,
 		C.size_t(len(compressedData)),
 		outPtr,
-		C.size_t(outputSize),
+		C.size_t(len(dst)),
 		&bytesWritten,
 	)
 
 	if code != 0 {
-		return nil, newDecompressError(code)
+		return 0, newDecompressError(code)
+	}
+
+	return int(bytesWritten), nil
+}
+
+// Decompressor decompresses the pages of one compressed tablespace. The
+// C library specializes its page paths per KEY_BLOCK_SIZE and page type at
+// compile time; the handle picks the table for its physical size once, so
+// per-page calls skip size validation and detection. It is safe for
+// concurrent use.
+type Decompressor struct {
+	h            *C.innodb_decompressor_t
+	physicalSize int
+}
+
+// NewDecompressor returns a Decompressor for pages of physicalSize bytes
+// (KEY_BLOCK_SIZE 1024, 2048, 4096 or 8192). Call Close when done.
+func NewDecompressor(physicalSize int) (*Decompressor, error) {
+	h := C.innodb_decompressor_new(C.size_t(physicalSize))
+	if h == nil {
+		return nil, newDecompressError(DecompressErrorInvalidSize)
 	}
+	return &Decompressor{h: h, physicalSize: physicalSize}, nil
+}
+
+// PhysicalSize returns the compressed page size of the tablespace
+func (d *Decompressor) PhysicalSize() int { return d.physicalSize }
 
-	// Resize to actual bytes written
-	return output[:bytesWritten], nil
+// Close releases the C handle
+func (d *Decompressor) Close() {
+	if d.h != nil {
+		C.innodb_decompressor_free(d.h)
+		d.h = nil
+	}
+}
+
+// DecompressPageInto decompresses one physical page into dst (at least
+// 16KB) and returns the bytes written: 16KB for INDEX pages, the physical
+// size for page types stored uncompressed.
+func (d *Decompressor) DecompressPageInto(dst, src []byte) (int, error) {
+	if len(src) < d.physicalSize {
+		return 0, newDecompressError(DecompressErrorInvalidSize)
+	}
+	if len(dst) < 16384 {
+		return 0, newDecompressError(DecompressErrorBufferSmall)
+	}
+
+	var bytesWritten C.size_t
+	code := C.wrap_innodb_decompressor_page(d.h,
+		(*C.uchar)(unsafe.Pointer(&src[0])),
+		(*C.uchar)(unsafe.Pointer(&dst[0])),
+		&bytesWritten,
+	)
+	if code != 0 {
+		return 0, newDecompressError(code)
+	}
+	return int(bytesWritten), nil
+}
+
+// DecompressPagesInto decompresses the consecutive physical pages in src
+// with one C call. Page i is written to dst[i*16384:(i+1)*16384], zero-filled
+// past the data of pages stored uncompressed. It returns the number of pages
+// decompressed before the first error.
+func (d *Decompressor) DecompressPagesInto(dst, src []byte) (int, error) {
+	n := len(src) / d.physicalSize
+	if n == 0 {
+		return 0, nil
+	}
+	if len(dst) < n*16384 {
+		return 0, newDecompressError(DecompressErrorBufferSmall)
+	}
+
+	var done C.size_t
+	code := C.wrap_innodb_decompressor_pages(d.h,
+		(*C.uchar)(unsafe.Pointer(&src[0])),
+		C.size_t(n),
+		(*C.uchar)(unsafe.Pointer(&dst[0])),
+		&done,
+	)
+	if code != 0 {
+		return int(done), newDecompressError(code)
+	}
+	return n, nil
+}
+
+// Stage returns the decompress stage of a page pipeline (see
+// scan.RunPipeline, with PipelineOptions.PageSize set to PhysicalSize):
+// the physical pages of each batch are decompressed into 16KB pages with
+// one C call, so later stages see ordinary pages.
+func (d *Decompressor) Stage() scan.Stage {
+	return scan.Stage{Name: "decompress", Run: func(b *scan.Batch) error {
+		n, err := d.DecompressPagesInto(b.Spare(format.PageSize), b.Data)
+		if err != nil {
+			return fmt.Errorf("decompress page %d: %w", b.Pages[n], err)
+		}
+		b.Swap(format.PageSize)
+		return nil
+	}}
 }
 
 // ProcessPage handles both compressed and uncompressed pages
 // It automatically detects if decompression is needed
 func ProcessPage(pageData []byte) ([]byte, error) {
-	if len(pageData) == 0 {
-		return nil, fmt.Errorf("empty page data")
-	}
-
 	// Allocate output buffer
 	outputSize := 16384
 	if len(pageData) > outputSize {
 		outputSize = len(pageData)
 	}
 	output := make([]byte, outputSize)
+	n, err := ProcessPageInto(output, pageData)
+	if err != nil {
+		return nil, err
+	}
+	return output[:n], nil
+}
+
+// ProcessPageInto is ProcessPage writing into dst, which must hold at least
+// 16KB (or len(pageData) if larger). It returns the bytes written.
+func ProcessPageInto(dst, pageData []byte) (int, error) {
+	if len(pageData) == 0 {
+		return 0, fmt.Errorf("empty page data")
+	}
+	if len(dst) == 0 {
+		return 0, newDecompressError(DecompressErrorBufferSmall)
+	}
+
 	var bytesWritten C.size_t
 
 	var inPtr *C.uchar = (*C.uchar)(unsafe.Pointer(&pageData[0]))
-	var outPtr *C.uchar = (*C.uchar)(unsafe.Pointer(&output[0]))
+	var outPtr *C.uchar = (*C.uchar)(unsafe.Pointer(&dst[0]))
 	code := C.wrap_innodb_process_page(
 		inPtr,
 		C.size_t(len(pageData)),
 		outPtr,
-		C.size_t(outputSize),
+		C.size_t(len(dst)),
 		&bytesWritten,
 	)
 
 	if code != 0 {
-		return nil, newDecompressError(code)
+		return 0, newDecompressError(code)
 	}
 
-	return output[:bytesWritten], nil
+	return int(bytesWritten), nil
 }
 
 // GetDecompressVersion returns the version of the decompression library
@@ -0,0 +1,416 @@
+// arrow.go - Arrow IPC stream and file output
+package export
+
+import (
+	"encoding/binary"
+	"io"
+
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// Arrow IPC constants (Schema.fbs, Message.fbs)
+const (
+	arrowMetadataV5 = 4
+
+	arrowHeaderSchema      = 1
+	arrowHeaderRecordBatch = 3
+
+	arrowTypeInt           = 2
+	arrowTypeFloatingPoint = 3
+	arrowTypeBinary        = 4
+	arrowTypeUtf8          = 5
+	arrowTypeDecimal       = 7
+	arrowTypeDate          = 8
+	arrowTypeTimestamp     = 10
+
+	arrowPrecisionSingle = 1
+	arrowPrecisionDouble = 2
+	arrowDateDay         = 0
+	arrowMicrosecond     = 2
+
+	arrowContinuation = 0xFFFFFFFF
+)
+
+var arrowMagic = []byte("ARROW1")
+
+// arrowWriter writes record batches in the Arrow IPC streaming format or,
+// with file set, the IPC file format. Body buffers are not compressed:
+// Arrow only defines LZ4 frame and ZSTD body compression.
+type arrowWriter struct {
+	w      *countingWriter
+	file   bool
+	cols   []*schema.Column
+	kinds  []kind
+	blocks []arrowBlock
+	buf    []byte // body buffer scratch
+}
+
+// arrowBlock locates a record batch message in an Arrow file
+type arrowBlock struct {
+	offset  int64
+	metaLen int
+	bodyLen int64
+}
+
+// arrowBuffer is one body buffer of a record batch
+type arrowBuffer struct {
+	offset, length int64
+}
+
+func newArrowWriter(w *countingWriter, cols []*schema.Column, kinds []kind, file bool) (*arrowWriter, error) {
+	a := &arrowWriter{w: w, file: file, cols: cols, kinds: kinds}
+	if file {
+		// Magic padded to 8 bytes
+		if _, err := w.Write([]byte("ARROW1\x00\x00")); err != nil {
+			return nil, err
+		}
+	}
+	b := newFBBuilder()
+	s := a.buildSchema(b)
+	if _, err := a.writeMessage(b, arrowHeaderSchema, s, 0); err != nil {
+		return nil, err
+	}
+	return a, nil
+}
+
+// buildSchema adds the Schema table to b
+func (a *arrowWriter) buildSchema(b *fbBuilder) int {
+	fields := make([]int, len(a.cols))
+	for i, col := range a.cols {
+		fields[i] = a.buildField(b, col, a.kinds[i])
+	}
+	vec := b.offsetVector(fields)
+	b.startTable(4)
+	b.addUint16(0, 0) // little endian
+	b.addOffset(1, vec)
+	return b.endTable()
+}
+
+// buildField adds the Field table describing col to b
+func (a *arrowWriter) buildField(b *fbBuilder, col *schema.Column, k kind) int {
+	name := b.createString(col.Name)
+	children := b.offsetVector(nil)
+	var typeType uint8
+	var typ int
+	switch k {
+	case kindInt64, kindUint64:
+		typeType = arrowTypeInt
+		b.startTable(2)
+		b.addUint32(0, 64)
+		b.addUint8(1, boolByte(k == kindInt64))
+		typ = b.endTable()
+	case kindFloat32, kindFloat64:
+		typeType = arrowTypeFloatingPoint
+		b.startTable(1)
+		if k == kindFloat32 {
+			b.addUint16(0, arrowPrecisionSingle)
+		} else {
+			b.addUint16(0, arrowPrecisionDouble)
+		}
+		typ = b.endTable()
+	case kindDecimal64:
+		typeType = arrowTypeDecimal
+		b.startTable(3)
+		b.addUint32(0, uint32(col.Precision))
+		b.addUint32(1, uint32(col.Scale))
+		b.addUint32(2, 128)
+		typ = b.endTable()
+	case kindDate32:
+		typeType = arrowTypeDate
+		b.startTable(1)
+		b.addUint16(0, arrowDateDay)
+		typ = b.endTable()
+	case kindTimestamp:
+		typeType = arrowTypeTimestamp
+		// TIMESTAMP is stored in UTC; DATETIME has no time zone
+		tz := 0
+		if col.ResolvedCode() == schema.CodeTimestamp {
+			tz = b.createString("UTC")
+		}
+		b.startTable(2)
+		b.addUint16(0, arrowMicrosecond)
+		if tz != 0 {
+			b.addOffset(1, tz)
+		}
+		typ = b.endTable()
+	case kindBinary:
+		typeType = arrowTypeBinary
+		b.startTable(0)
+		typ = b.endTable()
+	default:
+		typeType = arrowTypeUtf8
+		b.startTable(0)
+		typ = b.endTable()
+	}
+
+	b.startTable(7)
+	b.addOffset(0, name)
+	b.addUint8(1, boolByte(nullable(col, k)))
+	b.addUint8(2, typeType)
+	b.addOffset(3, typ)
+	b.addOffset(5, children)
+	return b.endTable()
+}
+
+// writeMessage frames the Message table with header as an encapsulated IPC
+// message and writes it; the body, bodyLen bytes, is written by the caller.
+// It returns the size of the framed metadata.
+func (a *arrowWriter) writeMessage(b *fbBuilder, headerType uint8, header int, bodyLen int64) (int, error) {
+	b.startTable(5)
+	b.addUint64(3, uint64(bodyLen))
+	b.addOffset(2, header)
+	b.addUint16(0, arrowMetadataV5)
+	b.addUint8(1, headerType)
+	meta := b.finish(b.endTable())
+
+	// Continuation marker, length, metadata padded so the body is 8-aligned
+	n := (len(meta) + 7) &^ 7
+	var prefix [8]byte
+	binary.LittleEndian.PutUint32(prefix[0:], arrowContinuation)
+	binary.LittleEndian.PutUint32(prefix[4:], uint32(n))
+	if _, err := a.w.Write(prefix[:]); err != nil {
+		return 0, err
+	}
+	if _, err := a.w.Write(meta); err != nil {
+		return 0, err
+	}
+	if err := a.pad(n - len(meta)); err != nil {
+		return 0, err
+	}
+	return 8 + n, nil
+}
+
+func (a *arrowWriter) pad(n int) error {
+	var zero [8]byte
+	_, err := a.w.Write(zero[:n])
+	return err
+}
+
+// writeGroup writes the batches of a group as one record batch
+func (a *arrowWriter) writeGroup(group []*columnBatch) error {
+	rows := 0
+	for _, cb := range group {
+		rows += cb.rows
+	}
+
+	// Lay out the body: validity and values (and offsets) per column
+	var (
+		bufs  []arrowBuffer
+		nulls = make([]int, len(a.cols))
+		body  int64
+	)
+	add := func(length int) {
+		bufs = append(bufs, arrowBuffer{body, int64(length)})
+		body += int64(align8(length))
+	}
+	for c := range a.cols {
+		dataLen := 0
+		for _, cb := range group {
+			nulls[c] += cb.vecs[c].nulls
+			dataLen += len(cb.vecs[c].data)
+		}
+		if nulls[c] > 0 {
+			add((rows + 7) / 8)
+		} else {
+			add(0)
+		}
+		switch k := a.kinds[c]; {
+		case k == kindDecimal64:
+			add(16 * rows)
+		case k.fixed():
+			add(k.width() * rows)
+		default:
+			add(4 * (rows + 1))
+			add(dataLen)
+		}
+	}
+
+	b := newFBBuilder()
+	b.startVector(16, len(a.cols), 8)
+	for c := len(a.cols) - 1; c >= 0; c-- {
+		b.prep(8, 16)
+		b.placeUint64(uint64(nulls[c]))
+		b.placeUint64(uint64(rows))
+	}
+	nodes := b.endVector(len(a.cols))
+	b.startVector(16, len(bufs), 8)
+	for i := len(bufs) - 1; i >= 0; i-- {
+		b.prep(8, 16)
+		b.placeUint64(uint64(bufs[i].length))
+		b.placeUint64(uint64(bufs[i].offset))
+	}
+	buffers := b.endVector(len(bufs))
+	b.startTable(5)
+	b.addUint64(0, uint64(rows))
+	b.addOffset(1, nodes)
+	b.addOffset(2, buffers)
+	rb := b.endTable()
+
+	start := a.w.n
+	metaLen, err := a.writeMessage(b, arrowHeaderRecordBatch, rb, body)
+	if err != nil {
+		return err
+	}
+	a.blocks = append(a.blocks, arrowBlock{start, metaLen, body})
+
+	for c := range a.cols {
+		if nulls[c] > 0 {
+			if err := a.writeBuffer(a.validity(group, rows, c)); err != nil {
+				return err
+			}
+		}
+		if err := a.writeValues(group, rows, c); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// writeBuffer writes one body buffer followed by its padding
+func (a *arrowWriter) writeBuffer(p []byte) error {
+	if _, err := a.w.Write(p); err != nil {
+		return err
+	}
+	return a.pad(align8(len(p)) - len(p))
+}
+
+// validity builds the validity bitmap of column c across the group
+func (a *arrowWriter) validity(group []*columnBatch, rows, c int) []byte {
+	a.buf = resizeBytes(a.buf, (rows+7)/8)
+	for i := range a.buf {
+		a.buf[i] = 0
+	}
+	r := 0
+	for _, cb := range group {
+		for _, ok := range cb.vecs[c].valid {
+			if ok {
+				a.buf[r>>3] |= 1 << (r & 7)
+			}
+			r++
+		}
+	}
+	return a.buf
+}
+
+// writeValues writes the value buffers of column c across the group
+func (a *arrowWriter) writeValues(group []*columnBatch, rows, c int) error {
+	k := a.kinds[c]
+	if k.fixed() {
+		w := k.width()
+		if k == kindDecimal64 {
+			w = 16
+		}
+		a.buf = resizeBytes(a.buf, w*rows)
+		p := a.buf
+		for _, cb := range group {
+			for _, v := range cb.vecs[c].fixed {
+				switch w {
+				case 4:
+					binary.LittleEndian.PutUint32(p, uint32(v))
+				case 8:
+					binary.LittleEndian.PutUint64(p, v)
+				case 16:
+					binary.LittleEndian.PutUint64(p, v)
+					binary.LittleEndian.PutUint64(p[8:], uint64(int64(v)>>63))
+				}
+				p = p[w:]
+			}
+		}
+		return a.writeBuffer(a.buf)
+	}
+
+	// Offsets continue from batch to batch; the data is written as is
+	a.buf = resizeBytes(a.buf, 4*(rows+1))
+	p := a.buf[4:]
+	binary.LittleEndian.PutUint32(a.buf, 0)
+	base, dataLen := int32(0), 0
+	for _, cb := range group {
+		vec := &cb.vecs[c]
+		for _, off := range vec.offsets[1:] {
+			binary.LittleEndian.PutUint32(p, uint32(base+off))
+			p = p[4:]
+		}
+		base += int32(len(vec.data))
+		dataLen += len(vec.data)
+	}
+	if err := a.writeBuffer(a.buf); err != nil {
+		return err
+	}
+	for _, cb := range group {
+		if _, err := a.w.Write(cb.vecs[c].data); err != nil {
+			return err
+		}
+	}
+	return a.pad(align8(dataLen) - dataLen)
+}
+
+// close ends the stream and, for the file format, writes the footer
+func (a *arrowWriter) close() error {
+	var eos [8]byte
+	binary.LittleEndian.PutUint32(eos[:], arrowContinuation)
+	if _, err := a.w.Write(eos[:]); err != nil {
+		return err
+	}
+	if !a.file {
+		return nil
+	}
+
+	b := newFBBuilder()
+	s := a.buildSchema(b)
+	dicts := b.offsetVector(nil)
+	b.startVector(24, len(a.blocks), 8)
+	for i := len(a.blocks) - 1; i >= 0; i-- {
+		blk := a.blocks[i]
+		b.prep(8, 24)
+		b.placeUint64(uint64(blk.bodyLen))
+		b.placeUint32(0)
+		b.placeUint32(uint32(blk.metaLen))
+		b.placeUint64(uint64(blk.offset))
+	}
+	blocks := b.endVector(len(a.blocks))
+	b.startTable(5)
+	b.addOffset(1, s)
+	b.addOffset(2, dicts)
+	b.addOffset(3, blocks)
+	b.addUint16(0, arrowMetadataV5)
+	footer := b.finish(b.endTable())
+
+	if _, err := a.w.Write(footer); err != nil {
+		return err
+	}
+	var size [4]byte
+	binary.LittleEndian.PutUint32(size[:], uint32(len(footer)))
+	if _, err := a.w.Write(size[:]); err != nil {
+		return err
+	}
+	_, err := a.w.Write(arrowMagic)
+	return err
+}
+
+func align8(n int) int { return (n + 7) &^ 7 }
+
+func boolByte(b bool) uint8 {
+	if b {
+		return 1
+	}
+	return 0
+}
+
+func resizeBytes(b []byte, n int) []byte {
+	if cap(b) < n {
+		return make([]byte, n)
+	}
+	return b[:n]
+}
+
+// countingWriter counts the bytes written through it
+type countingWriter struct {
+	w io.Writer
+	n int64
+}
+
+func (c *countingWriter) Write(p []byte) (int, error) {
+	n, err := c.w.Write(p)
+	c.n += int64(n)
+	return n, err
+}
@@ -0,0 +1,286 @@
+// btree.go - Leaf level of the exported index, listed from its root
+package export
+
+import (
+	"errors"
+	"fmt"
+	"io"
+	"runtime"
+	"sync"
+	"sync/atomic"
+
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/page"
+	"github.com/wilhasse/go-innodb/record"
+	"github.com/wilhasse/go-innodb/scan"
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// ErrBrokenIndex is returned when the B-tree of the exported index is not
+// intact: its root is missing, a node pointer leads to a page that is not
+// the expected INDEX page, or the pages of a level, the leaves included,
+// are not one chain linked both ways in key order. Leaf chains and their
+// fragments can still be rebuilt from page headers (see scan.LeafChains).
+var ErrBrokenIndex = errors.New("broken index B-tree")
+
+// firstRootPage is the first page that can hold an index root: pages 0-2
+// are the FSP header, insert buffer bitmap and inode pages
+const firstRootPage = 3
+
+// heapStart is the offset of the first user record of a compact page, after
+// the infimum and supremum records
+const heapStart = format.PageDataOff + 2*(format.RecordHeaderSize+format.SystemRecordBytes)
+
+// leafRange is a run of consecutive leaf pages of an index, in key order.
+// prev and next are the leaves around it, scan.FilNull at the ends of the
+// leaf level; the export checks the links of each page against them.
+type leafRange struct {
+	indexID    uint64
+	pages      []uint32
+	prev, next uint32
+}
+
+// part returns pages s to e-1 of lr
+func (lr leafRange) part(s, e int) leafRange {
+	p := leafRange{indexID: lr.indexID, pages: lr.pages[s:e], prev: lr.prev, next: lr.next}
+	if s > 0 {
+		p.prev = lr.pages[s-1]
+	}
+	if e < len(lr.pages) {
+		p.next = lr.pages[e]
+	}
+	return p
+}
+
+// split cuts lr into n contiguous ranges of about equal page counts
+func (lr leafRange) split(n int) []leafRange {
+	ranges := make([]leafRange, n)
+	for i := range ranges {
+		ranges[i] = lr.part(len(lr.pages)*i/n, len(lr.pages)*(i+1)/n)
+	}
+	return ranges
+}
+
+// batches cuts lr into batches of up to batchPages pages
+func (lr leafRange) batches() []scan.Chain {
+	return appendBatches(nil, lr.indexID, lr.pages)
+}
+
+// checkLinks is a stage function failing with ErrBrokenIndex on a page of
+// batch b, one of lr.batches(), that is not a leaf of the index linked to
+// the pages before and after it
+func (lr leafRange) checkLinks(b *scan.Batch) error {
+	for i, pageNo := range b.Pages {
+		k := b.Seq*batchPages + i
+		prev, next := lr.prev, lr.next
+		if k > 0 {
+			prev = lr.pages[k-1]
+		}
+		if k+1 < len(lr.pages) {
+			next = lr.pages[k+1]
+		}
+		if err := checkPage(b.Page(i), pageNo, lr.indexID, 0, prev, next); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// checkPage verifies that page pageNo is a compact INDEX page of index
+// indexID at level, between prev and next on its level
+func checkPage(pageData []byte, pageNo uint32, indexID uint64, level uint16, prev, next uint32) error {
+	v, err := page.NewView(pageData)
+	if err != nil {
+		return fmt.Errorf("page %d: %w", pageNo, err)
+	}
+	if !v.IsIndex() || v.Format() != format.FormatCompact || v.PageNumber() != pageNo {
+		return fmt.Errorf("%w: page %d is not a compact INDEX page", ErrBrokenIndex, pageNo)
+	}
+	if v.IndexID() != indexID || v.PageLevel() != level {
+		return fmt.Errorf("%w: page %d is at level %d of index %d, expected level %d of index %d",
+			ErrBrokenIndex, pageNo, v.PageLevel(), v.IndexID(), level, indexID)
+	}
+	p, _ := v.Prev()
+	n, _ := v.Next()
+	if p != prev || n != next {
+		return fmt.Errorf("%w: page %d links to %s and %s, expected %s and %s (see -chains)",
+			ErrBrokenIndex, pageNo, pageName(p), pageName(n), pageName(prev), pageName(next))
+	}
+	return nil
+}
+
+func pageName(p uint32) string {
+	if p == scan.FilNull {
+		return "NULL"
+	}
+	return fmt.Sprint(p)
+}
+
+// findRoot returns the root page of index indexID, or of the clustered
+// index if it is 0, with its index ID and level. Roots are the INDEX pages
+// without siblings; those of the indexes created with the table are
+// allocated in creation order in the first extent, from page 3 (page 4 in
+// MySQL 8.0, whose page 3 is the root of the SDI), so the clustered index
+// comes first.
+func findRoot(r io.ReaderAt, size int64, indexID uint64) (uint32, uint64, uint16, error) {
+	n := int(size / format.PageSize)
+	if n > scan.ExtentPages {
+		n = scan.ExtentPages
+	}
+	if n <= firstRootPage {
+		return 0, 0, 0, fmt.Errorf("%w: no index root in a %d-page tablespace", ErrBrokenIndex, n)
+	}
+	buf := make([]byte, (n-firstRootPage)*format.PageSize)
+	if _, err := r.ReadAt(buf, firstRootPage*format.PageSize); err != nil && err != io.EOF {
+		return 0, 0, 0, err
+	}
+	for i := 0; i < n-firstRootPage; i++ {
+		v, _ := page.NewView(buf[i*format.PageSize:])
+		_, hasPrev := v.Prev()
+		_, hasNext := v.Next()
+		if !v.IsIndex() || hasPrev || hasNext || v.Format() != format.FormatCompact {
+			continue
+		}
+		if indexID == 0 || v.IndexID() == indexID {
+			return uint32(firstRootPage + i), v.IndexID(), v.PageLevel(), nil
+		}
+	}
+	if indexID == 0 {
+		return 0, 0, 0, fmt.Errorf("%w: no index root in the first extent", ErrBrokenIndex)
+	}
+	return 0, 0, 0, fmt.Errorf("%w: no root of index %d in the first extent", ErrBrokenIndex, indexID)
+}
+
+// leafLevel lists the leaf pages of the clustered index of td (or index
+// opts.IndexID) in key order by descending its B-tree: the node pointers
+// of each level give the pages of the level below, read in parallel with
+// workers goroutines. Only the internal pages are read, and each is
+// checked with checkPage, so freed pages left over from earlier splits
+// and merges are never reached. The leaves themselves are checked as they
+// are exported (see leafRange.checkLinks). As every page of a level must
+// link to its neighbours in the list, from NULL to NULL, a page listed
+// twice always fails these checks, so no visited set is kept. The list,
+// 4 bytes per leaf page, is charged to opts.Budget; the caller releases it.
+func leafLevel(r io.ReaderAt, size int64, td *schema.TableDef, opts Options, workers int) (leafRange, error) {
+	root, indexID, level, err := findRoot(r, size, opts.IndexID)
+	if err != nil {
+		return leafRange{}, err
+	}
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	n := uint32(size / format.PageSize)
+
+	pages := []uint32{root}
+	for ; level > 0; level-- {
+		children := make([][]uint32, len(pages))
+		var (
+			next     int64 = -1
+			wg       sync.WaitGroup
+			errOnce  sync.Once
+			firstErr error
+			failed   atomic.Bool
+		)
+		w := workers
+		if w > len(pages) {
+			w = len(pages)
+		}
+		for ; w > 0; w-- {
+			wg.Add(1)
+			go func() {
+				defer wg.Done()
+				parser := record.NewCompactParser(td)
+				buf := make([]byte, format.PageSize)
+				for !failed.Load() {
+					i := int(atomic.AddInt64(&next, 1))
+					if i >= len(pages) {
+						return
+					}
+					var err error
+					if children[i], err = nodePointers(r, parser, pages, i, indexID, level, buf); err != nil {
+						errOnce.Do(func() { firstErr = err })
+						failed.Store(true)
+					}
+				}
+			}()
+		}
+		wg.Wait()
+		if firstErr != nil {
+			return leafRange{}, firstErr
+		}
+
+		total := 0
+		for _, c := range children {
+			total += len(c)
+		}
+		below := make([]uint32, 0, total)
+		for _, c := range children {
+			for _, p := range c {
+				if p >= n {
+					return leafRange{}, fmt.Errorf("%w: node pointer to page %d at level %d", ErrBrokenIndex, p, level)
+				}
+				below = append(below, p)
+			}
+		}
+		pages = below
+	}
+	opts.Budget.Charge(4 * int64(len(pages)))
+	return leafRange{indexID: indexID, pages: pages, prev: scan.FilNull, next: scan.FilNull}, nil
+}
+
+// nodePointers reads page pages[i] of a level of the index, checks it and
+// returns the child page numbers of its node pointers in key order
+func nodePointers(r io.ReaderAt, parser *record.CompactParser, pages []uint32, i int, indexID uint64, level uint16, buf []byte) ([]uint32, error) {
+	pageNo := pages[i]
+	if _, err := r.ReadAt(buf, int64(pageNo)*format.PageSize); err != nil && err != io.EOF {
+		return nil, fmt.Errorf("read page %d: %w", pageNo, err)
+	}
+	prev, next := uint32(scan.FilNull), uint32(scan.FilNull)
+	if i > 0 {
+		prev = pages[i-1]
+	}
+	if i+1 < len(pages) {
+		next = pages[i+1]
+	}
+	if err := checkPage(buf, pageNo, indexID, level, prev, next); err != nil {
+		return nil, err
+	}
+	v, _ := page.NewView(buf)
+	heapTop := int(v.HeapTop())
+	var (
+		children []uint32
+		recErr   error
+	)
+	err := record.ForEachRecord(buf, true, func(pos int, hdr record.RecordHeader) bool {
+		if hdr.Type != format.RecNodePointer {
+			recErr = fmt.Errorf("record at %d is not a node pointer", pos)
+			return false
+		}
+		// The child page number ends the record. An extent outside the
+		// record heap means the key was misread, so its child cannot be
+		// trusted.
+		start, end, err := parser.RecordExtent(buf, pos, false)
+		if err == nil && (start < heapStart || end > heapTop) {
+			err = fmt.Errorf("node pointer at %d spans %d-%d, outside the record heap %d-%d",
+				pos, start, end, heapStart, heapTop)
+		}
+		if err == nil {
+			var child uint32
+			if child, err = format.Be32(buf, end-4); err == nil {
+				children = append(children, child)
+			}
+		}
+		recErr = err
+		return err == nil
+	})
+	if err == nil {
+		err = recErr
+	}
+	if err == nil && len(children) == 0 {
+		err = fmt.Errorf("no node pointers")
+	}
+	if err != nil {
+		return nil, fmt.Errorf("%w: page %d: %v", ErrBrokenIndex, pageNo, err)
+	}
+	return children, nil
+}
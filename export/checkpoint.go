@@ -0,0 +1,118 @@
+// checkpoint.go - Durable progress of text exports, for resuming
+package export
+
+import (
+	"encoding/json"
+	"errors"
+	"fmt"
+	"os"
+	"path/filepath"
+	"time"
+
+	"github.com/wilhasse/go-innodb/scan"
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// defaultCheckpointEvery is the default of Options.CheckpointEvery
+const defaultCheckpointEvery = 10 * time.Second
+
+// ErrCheckpointMismatch is returned when resuming from a checkpoint taken
+// for another table, format or tablespace
+var ErrCheckpointMismatch = errors.New("checkpoint does not match this export")
+
+// Checkpoint records how far a text export has got. Batches are the runs
+// of 64 leaf pages ExportTable cuts the table into, always in the same way
+// for the same tablespace; the output holds exactly the rows of the first
+// Batches batches, in Bytes bytes. Resuming truncates the output to Bytes
+// and starts at batch Batches, so no row is written twice or lost.
+type Checkpoint struct {
+	Table      string `json:"table"`
+	Format     string `json:"format"`
+	SourceSize int64  `json:"source_size"` // tablespace size in bytes
+
+	Batches  int             `json:"batches"`   // batches fully written
+	Pages    int             `json:"pages"`     // leaf pages fully written
+	LastPage uint32          `json:"last_page"` // last leaf page written
+	NextPage uint32          `json:"next_page"` // first leaf page of the next batch
+	Rows     int64           `json:"rows"`
+	Bytes    int64           `json:"bytes"`    // output offset
+	LastKey  json.RawMessage `json:"last_key"` // primary key of the last row written
+	Done     bool            `json:"done"`     // the export completed
+}
+
+// advance accounts for the written chunk c of batches
+func (cp *Checkpoint) advance(batches []scan.Chain, c *textChunk, bytes int64) {
+	pages := batches[c.seq].Pages
+	cp.Batches++
+	cp.Pages += len(pages)
+	cp.LastPage = pages[len(pages)-1]
+	cp.NextPage = 0
+	if c.seq+1 < len(batches) {
+		cp.NextPage = batches[c.seq+1].Pages[0]
+	}
+	cp.Rows += int64(c.rows)
+	cp.Bytes = bytes
+	if c.lastKey != nil {
+		cp.LastKey = c.lastKey
+	}
+}
+
+// check verifies that cp was taken for this export of batches
+func (cp *Checkpoint) check(td *schema.TableDef, f Format, size int64, batches []scan.Chain) error {
+	if cp.Table != td.Name || cp.Format != f.String() || cp.SourceSize != size {
+		return fmt.Errorf("%w: it is for table %s as %s from a %d-byte tablespace",
+			ErrCheckpointMismatch, cp.Table, cp.Format, cp.SourceSize)
+	}
+	if cp.Batches > len(batches) ||
+		cp.Batches < len(batches) && batches[cp.Batches].Pages[0] != cp.NextPage {
+		return fmt.Errorf("%w: the leaf pages have changed", ErrCheckpointMismatch)
+	}
+	return nil
+}
+
+// Save writes cp to path atomically: to a temporary file that is synced
+// and then renamed over path, so a crash leaves either the old or the new
+// checkpoint
+func (cp *Checkpoint) Save(path string) error {
+	b, err := json.MarshalIndent(cp, "", "  ")
+	if err != nil {
+		return err
+	}
+	tmp := path + ".tmp"
+	f, err := os.Create(tmp)
+	if err != nil {
+		return err
+	}
+	if _, err = f.Write(append(b, '\n')); err == nil {
+		err = f.Sync()
+	}
+	if cerr := f.Close(); err == nil {
+		err = cerr
+	}
+	if err == nil {
+		err = os.Rename(tmp, path)
+	}
+	if err != nil {
+		os.Remove(tmp)
+		return err
+	}
+	// Make the rename itself durable
+	if d, err := os.Open(filepath.Dir(path)); err == nil {
+		d.Sync()
+		d.Close()
+	}
+	return nil
+}
+
+// LoadCheckpoint reads a checkpoint written by Save
+func LoadCheckpoint(path string) (*Checkpoint, error) {
+	b, err := os.ReadFile(path)
+	if err != nil {
+		return nil, err
+	}
+	cp := new(Checkpoint)
+	if err := json.Unmarshal(b, cp); err != nil {
+		return nil, fmt.Errorf("checkpoint %s: %w", path, err)
+	}
+	return cp, nil
+}
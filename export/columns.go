@@ -0,0 +1,452 @@
+// columns.go - Columnar decode batches for Arrow and Parquet output
+package export
+
+import (
+	"fmt"
+	"math"
+
+	"github.com/wilhasse/go-innodb/charset"
+	"github.com/wilhasse/go-innodb/column"
+	"github.com/wilhasse/go-innodb/record"
+	"github.com/wilhasse/go-innodb/scan"
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// kind is the columnar type a column is exported as
+type kind uint8
+
+const (
+	kindInt64     kind = iota // integer types, YEAR, BOOL
+	kindUint64                // BIGINT UNSIGNED
+	kindFloat32               // FLOAT
+	kindFloat64               // DOUBLE
+	kindDecimal64             // DECIMAL with precision <= 18, unscaled
+	kindDate32                // DATE, days since 1970-01-01
+	kindTimestamp             // DATETIME and TIMESTAMP, microseconds since 1970-01-01
+	kindBinary                // BINARY, VARBINARY, BLOB
+	kindString                // text types, and the text form of all others
+)
+
+// columnKind returns the columnar type of col. TIME, ENUM, SET, BIT, JSON
+// and wider DECIMALs are exported as their MySQL text form.
+func columnKind(col *schema.Column) kind {
+	switch col.ResolvedCode() {
+	case schema.CodeBigInt:
+		if col.Unsigned {
+			return kindUint64
+		}
+		return kindInt64
+	case schema.CodeTinyInt, schema.CodeSmallInt, schema.CodeMediumInt, schema.CodeInt,
+		schema.CodeYear, schema.CodeBoolean, schema.CodeBool:
+		return kindInt64
+	case schema.CodeFloat:
+		return kindFloat32
+	case schema.CodeDouble:
+		return kindFloat64
+	case schema.CodeDecimal, schema.CodeNumeric:
+		if col.Precision <= column.MaxDecimal64Precision {
+			return kindDecimal64
+		}
+	case schema.CodeDate:
+		return kindDate32
+	case schema.CodeDateTime, schema.CodeTimestamp:
+		return kindTimestamp
+	case schema.CodeBinary, schema.CodeVarBinary, schema.CodeBlob, schema.CodeTinyBlob,
+		schema.CodeMediumBlob, schema.CodeLongBlob:
+		return kindBinary
+	}
+	return kindString
+}
+
+// nullable reports whether col may hold NULLs in columnar output: zero
+// dates and timestamps are exported as NULL even in NOT NULL columns
+func nullable(col *schema.Column, k kind) bool {
+	return col.Nullable || k == kindDate32 || k == kindTimestamp
+}
+
+// fixed reports whether values of k are stored in vector.fixed
+func (k kind) fixed() bool {
+	return k < kindBinary
+}
+
+// width returns the size of a fixed-width value of k in Arrow and Parquet
+// PLAIN encoding (decimals are widened to 16 bytes for Arrow separately)
+func (k kind) width() int {
+	if k == kindFloat32 || k == kindDate32 {
+		return 4
+	}
+	return 8
+}
+
+// vector holds one column of a batch. Fixed-width values are kept as their
+// bit patterns (two's complement integers, IEEE floats) so encoders handle
+// every fixed kind with the same loops; byte values are concatenated in data
+// with Arrow-style offsets.
+type vector struct {
+	valid   []bool
+	nulls   int
+	fixed   []uint64
+	offsets []int32
+	data    []byte
+}
+
+// columnBatch is the decoded content of a batch of leaf pages
+type columnBatch struct {
+	rows int
+	vecs []vector
+}
+
+func (b *columnBatch) reset(kinds []kind) {
+	if len(b.vecs) != len(kinds) {
+		b.vecs = make([]vector, len(kinds))
+	}
+	b.rows = 0
+	for i := range b.vecs {
+		v := &b.vecs[i]
+		v.valid = v.valid[:0]
+		v.nulls = 0
+		v.fixed = v.fixed[:0]
+		v.offsets = append(v.offsets[:0], 0)
+		v.data = v.data[:0]
+	}
+}
+
+// memBytes returns the approximate size of the decoded values of the batch
+func (b *columnBatch) memBytes() int {
+	n := 0
+	for i := range b.vecs {
+		n += len(b.vecs[i].data) + 8*len(b.vecs[i].fixed)
+	}
+	return n
+}
+
+// columnDecoder decodes leaf pages into a columnBatch. For each record it
+// only locates the fields; fixed-width columns are then decoded for the
+// whole page at once by the column batch kernels. A decoder keeps scratch
+// state and must not be shared between goroutines.
+type columnDecoder struct {
+	parser *record.CompactParser
+	cols   []*schema.Column
+	kinds  []kind
+	enc    Encoder              // text form of string-kind values
+	convs  []*charset.Converter // per column, see convertText
+
+	pos, size []int
+	offs      [][]int   // per column, offsets of the non-NULL values on the page
+	rows      [][]int   // per column, the batch rows of those values
+	ints      []int64   // kernel output scratch
+	f32       []float32 // kernel output scratch
+	f64       []float64 // kernel output scratch
+	values    [][]byte  // convertText scratch
+	convBuf   []byte    // convertText scratch
+	data      []byte    // convertText scratch, swapped with rewritten vectors
+}
+
+func newColumnDecoder(td *schema.TableDef, kinds []kind, enc Encoder, convs []*charset.Converter) *columnDecoder {
+	n := len(td.Columns)
+	d := &columnDecoder{
+		parser: record.NewCompactParser(td),
+		cols:   td.Columns,
+		kinds:  kinds,
+		enc:    enc,
+		convs:  convs,
+		pos:    make([]int, n),
+		size:   make([]int, n),
+		offs:   make([][]int, n),
+		rows:   make([][]int, n),
+	}
+	d.parser.SetZeroCopy(true)
+	return d
+}
+
+// batchKernel reports whether col is decoded by a column batch kernel
+// rather than value by value
+func batchKernel(col *schema.Column, k kind) bool {
+	switch col.ResolvedCode() {
+	case schema.CodeTinyInt, schema.CodeSmallInt, schema.CodeMediumInt, schema.CodeInt,
+		schema.CodeBigInt, schema.CodeFloat, schema.CodeDouble:
+		return true
+	}
+	return k == kindDecimal64
+}
+
+// appendBatch decodes the records listed in pb into b, page by page
+func (d *columnDecoder) appendBatch(b *columnBatch, pb *scan.Batch) (int, error) {
+	n := 0
+	for recs := pb.Records; len(recs) > 0; {
+		e := 1
+		for e < len(recs) && recs[e].Page == recs[0].Page {
+			e++
+		}
+		m, err := d.appendPage(b, pb.Page(recs[0].Page), recs[:e])
+		n += m
+		if err != nil {
+			return n, err
+		}
+		recs = recs[e:]
+	}
+	return n, d.convertText(b)
+}
+
+// convertText converts the text columns of b to UTF-8 a column at a time
+// with charset.Converter.ConvertBatch. Values are appended as stored, so a
+// vector is only rebuilt when some of its values had to be rewritten.
+func (d *columnDecoder) convertText(b *columnBatch) error {
+	for c, conv := range d.convs {
+		if conv == nil {
+			continue
+		}
+		vec := &b.vecs[c]
+		d.values = d.values[:0]
+		for i, ok := range vec.valid {
+			if ok {
+				d.values = append(d.values, vec.bytesAt(i))
+			} else {
+				d.values = append(d.values, nil)
+			}
+		}
+		var err error
+		d.convBuf, err = conv.ConvertBatch(d.values, d.convBuf[:0])
+		if err != nil {
+			return fmt.Errorf("column %s: %w", d.cols[c].Name, err)
+		}
+		if len(d.convBuf) == 0 {
+			continue
+		}
+		data := d.data[:0]
+		for i, v := range d.values {
+			data = append(data, v...)
+			vec.offsets[i+1] = int32(len(data))
+		}
+		vec.data, d.data = data, vec.data
+	}
+	return nil
+}
+
+// appendPage decodes the records recs of one leaf page into b
+func (d *columnDecoder) appendPage(b *columnBatch, pageData []byte, recs []scan.RecordRef) (int, error) {
+	for i := range d.offs {
+		d.offs[i] = d.offs[i][:0]
+		d.rows[i] = d.rows[i][:0]
+	}
+	first := b.rows
+	for _, rec := range recs {
+		if err := d.parser.LocateFields(pageData, rec.Pos, d.pos, d.size); err != nil {
+			return b.rows - first, err
+		}
+		row := b.rows
+		for c, col := range d.cols {
+			if err := d.appendValue(&b.vecs[c], c, col, row, pageData); err != nil {
+				return b.rows - first, fmt.Errorf("column %s: %w", col.Name, err)
+			}
+		}
+		b.rows++
+	}
+	return b.rows - first, d.runKernels(b, pageData)
+}
+
+// appendValue appends the value of column c of the current record. Values
+// decoded by batch kernels get a placeholder, filled in by runKernels.
+func (d *columnDecoder) appendValue(vec *vector, c int, col *schema.Column, row int, pageData []byte) error {
+	k := d.kinds[c]
+	off, size := d.pos[c], d.size[c]
+	if size < 0 {
+		vec.appendNull(k)
+		return nil
+	}
+	if batchKernel(col, k) {
+		d.offs[c] = append(d.offs[c], off)
+		d.rows[c] = append(d.rows[c], row)
+		vec.valid = append(vec.valid, true)
+		vec.fixed = append(vec.fixed, 0)
+		return nil
+	}
+
+	switch col.ResolvedCode() {
+	case schema.CodeDate:
+		dt, err := column.DecodeDate(pageData, off)
+		if err != nil {
+			return err
+		}
+		if dt.Month() == 0 || dt.Day() == 0 {
+			vec.appendNull(k) // zero dates have no calendar day
+			return nil
+		}
+		vec.appendFixed(uint64(uint32(daysFromCivil(dt.Year(), dt.Month(), dt.Day()))))
+		return nil
+	case schema.CodeDateTime:
+		dt, _, err := column.DecodeDateTime(pageData, off, col.Precision)
+		if err != nil {
+			return err
+		}
+		if dt.Month() == 0 || dt.Day() == 0 {
+			vec.appendNull(k)
+			return nil
+		}
+		secs := daysFromCivil(dt.Year(), dt.Month(), dt.Day())*86400 +
+			int64(dt.Hour()*3600+dt.Minute()*60+dt.Second())
+		vec.appendFixed(uint64(secs*1e6 + int64(dt.Microsecond())))
+		return nil
+	case schema.CodeTimestamp:
+		ts, _, err := column.DecodeTimestamp(pageData, off, col.Precision)
+		if err != nil {
+			return err
+		}
+		if ts.Sec == 0 && ts.Usec == 0 {
+			vec.appendNull(k) // 0000-00-00 00:00:00
+			return nil
+		}
+		vec.appendFixed(uint64(int64(ts.Sec)*1e6 + int64(ts.Usec)))
+		return nil
+	case schema.CodeChar:
+		return d.appendBytes(vec, column.TrimSpacePadding(pageData[off:off+size]))
+	case schema.CodeVarchar, schema.CodeText, schema.CodeTinyText, schema.CodeMediumText,
+		schema.CodeLongText, schema.CodeBinary, schema.CodeVarBinary, schema.CodeBlob,
+		schema.CodeTinyBlob, schema.CodeMediumBlob, schema.CodeLongBlob:
+		return d.appendBytes(vec, pageData[off:off+size])
+	}
+
+	// Everything else goes through the row decoder
+	val, _, err := column.ParseColumnView(pageData, off, col, size)
+	if err != nil {
+		return err
+	}
+	if k == kindInt64 {
+		switch x := val.(type) {
+		case uint8:
+			vec.appendFixed(uint64(x))
+		case uint16:
+			vec.appendFixed(uint64(x))
+		case bool:
+			if x {
+				vec.appendFixed(1)
+			} else {
+				vec.appendFixed(0)
+			}
+		default:
+			return fmt.Errorf("unexpected %T value", val)
+		}
+		return nil
+	}
+	vec.data, err = d.enc.AppendValue(vec.data, val)
+	vec.valid = append(vec.valid, true)
+	vec.offsets = append(vec.offsets, int32(len(vec.data)))
+	return err
+}
+
+// appendBytes appends a string or binary value as stored; strings are
+// converted by convertText once the batch is decoded
+func (d *columnDecoder) appendBytes(vec *vector, s []byte) error {
+	vec.data = append(vec.data, s...)
+	vec.valid = append(vec.valid, true)
+	vec.offsets = append(vec.offsets, int32(len(vec.data)))
+	return nil
+}
+
+// runKernels decodes the kernel columns of the page just located
+func (d *columnDecoder) runKernels(b *columnBatch, pageData []byte) error {
+	for c, col := range d.cols {
+		offs := d.offs[c]
+		if len(offs) == 0 {
+			continue
+		}
+		fixed := b.vecs[c].fixed
+		rows := d.rows[c]
+		var err error
+		switch col.ResolvedCode() {
+		case schema.CodeFloat:
+			d.f32 = growFloat32(d.f32, len(offs))
+			err = column.DecodeFloatBatch(pageData, offs, d.f32)
+			for i, r := range rows {
+				fixed[r] = uint64(math.Float32bits(d.f32[i]))
+			}
+		case schema.CodeDouble:
+			d.f64 = growFloat64(d.f64, len(offs))
+			err = column.DecodeDoubleBatch(pageData, offs, d.f64)
+			for i, r := range rows {
+				fixed[r] = math.Float64bits(d.f64[i])
+			}
+		default:
+			d.ints = growInt64(d.ints, len(offs))
+			if d.kinds[c] == kindDecimal64 {
+				err = column.DecodeDecimal64Batch(pageData, offs, col.Precision, col.Scale, d.ints)
+			} else {
+				err = column.DecodeIntBatch(pageData, offs, intSize[col.ResolvedCode()], !col.Unsigned, d.ints)
+			}
+			for i, r := range rows {
+				fixed[r] = uint64(d.ints[i])
+			}
+		}
+		if err != nil {
+			return fmt.Errorf("column %s: %w", col.Name, err)
+		}
+	}
+	return nil
+}
+
+// intSize is the stored size of each integer type
+var intSize = [schema.NumTypeCodes]int{
+	schema.CodeTinyInt:   1,
+	schema.CodeSmallInt:  2,
+	schema.CodeMediumInt: 3,
+	schema.CodeInt:       4,
+	schema.CodeBigInt:    8,
+}
+
+func (v *vector) appendNull(k kind) {
+	v.valid = append(v.valid, false)
+	v.nulls++
+	if k.fixed() {
+		v.fixed = append(v.fixed, 0)
+	} else {
+		v.offsets = append(v.offsets, int32(len(v.data)))
+	}
+}
+
+func (v *vector) appendFixed(bits uint64) {
+	v.valid = append(v.valid, true)
+	v.fixed = append(v.fixed, bits)
+}
+
+// bytesAt returns byte value i
+func (v *vector) bytesAt(i int) []byte {
+	return v.data[v.offsets[i]:v.offsets[i+1]]
+}
+
+// daysFromCivil returns the number of days from 1970-01-01 to the given
+// proleptic Gregorian date
+func daysFromCivil(y, m, d int) int64 {
+	if m <= 2 {
+		y--
+	}
+	era := y
+	if era < 0 {
+		era -= 399
+	}
+	era /= 400
+	yoe := y - era*400
+	doy := (153*((m+9)%12)+2)/5 + d - 1
+	doe := yoe*365 + yoe/4 - yoe/100 + doy
+	return int64(era)*146097 + int64(doe) - 719468
+}
+
+func growInt64(s []int64, n int) []int64 {
+	if cap(s) < n {
+		return make([]int64, n)
+	}
+	return s[:n]
+}
+
+func growFloat32(s []float32, n int) []float32 {
+	if cap(s) < n {
+		return make([]float32, n)
+	}
+	return s[:n]
+}
+
+func growFloat64(s []float64, n int) []float64 {
+	if cap(s) < n {
+		return make([]float64, n)
+	}
+	return s[:n]
+}
@@ -0,0 +1,297 @@
+// compress.go - Parallel block compression of export output
+package export
+
+import (
+	"compress/gzip"
+	"encoding/binary"
+	"fmt"
+	"io"
+	"runtime"
+	"sync"
+
+	"github.com/wilhasse/go-innodb/scan"
+)
+
+// Codec is the compression applied to export output: Parquet compresses
+// its pages, other formats wrap the whole stream in a BlockWriter
+type Codec int
+
+const (
+	Uncompressed Codec = iota
+	Gzip
+)
+
+// ParseCodec returns the Codec named "none" (or "") or "gzip"
+func ParseCodec(name string) (Codec, error) {
+	switch name {
+	case "", "none":
+		return Uncompressed, nil
+	case "gzip":
+		return Gzip, nil
+	}
+	return 0, fmt.Errorf("unknown compression %q (want none or gzip)", name)
+}
+
+// checkLevel validates a gzip level; 0 selects the default
+func checkLevel(level int) (int, error) {
+	if level == 0 {
+		return gzip.DefaultCompression, nil
+	}
+	if level < gzip.HuffmanOnly || level > gzip.BestCompression {
+		return 0, fmt.Errorf("invalid gzip level %d (want %d to %d)", level, gzip.HuffmanOnly, gzip.BestCompression)
+	}
+	return level, nil
+}
+
+// defaultBlockSize is the default of BlockOptions.BlockSize
+const defaultBlockSize = 4 << 20
+
+// BlockOptions configures a BlockWriter
+type BlockOptions struct {
+	// Level is the gzip level (0 means gzip.DefaultCompression)
+	Level int
+	// BlockSize is the number of input bytes per gzip member (default 4MB)
+	BlockSize int
+	// Workers is the number of compressing goroutines (0 means GOMAXPROCS)
+	Workers int
+	// Budget, if set, is charged for the blocks in flight, which are
+	// limited to about a quarter of it
+	Budget *scan.Budget
+}
+
+// BlockIndexEntry locates one gzip member written by a BlockWriter: it
+// starts at byte Compressed of the output and holds the input from byte
+// Uncompressed on
+type BlockIndexEntry struct {
+	Compressed   int64
+	Uncompressed int64
+}
+
+// BlockWriter compresses a stream as a sequence of independent gzip
+// members of BlockSize input bytes each. Members are compressed by a pool
+// of goroutines and written in order, so compression scales with cores
+// while the output stays one valid gzip file (readers concatenate members).
+// Because every member starts a fresh deflate stream, the output can be
+// decompressed from any member boundary; Index lists them. At most two
+// blocks per worker are in flight, bounding memory to about
+// 4 * Workers * BlockSize, or to a quarter of BlockOptions.Budget.
+type BlockWriter struct {
+	w         io.Writer
+	level     int
+	blockSize int
+	budget    *scan.Budget
+
+	jobs    chan compressJob
+	wg      sync.WaitGroup
+	ow      *orderedWriter
+	blocks  sync.Pool
+	cur     *[]byte
+	seq     int
+	closed  bool
+	index   []BlockIndexEntry
+	written int64 // compressed bytes written
+	input   int64 // input bytes written out so far
+}
+
+type compressJob struct {
+	seq int
+	buf *[]byte
+}
+
+// compressedBlock is an encoded member and the input size it covers
+type compressedBlock struct {
+	data []byte
+	raw  int
+}
+
+// NewBlockWriter starts the compressing goroutines. Close must be called
+// to flush the last block and stop them; it does not close w.
+func NewBlockWriter(w io.Writer, opts BlockOptions) (*BlockWriter, error) {
+	level, err := checkLevel(opts.Level)
+	if err != nil {
+		return nil, err
+	}
+	blockSize := opts.BlockSize
+	if blockSize <= 0 {
+		blockSize = defaultBlockSize
+	}
+	workers := opts.Workers
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+
+	// A block in flight holds its input and then its compressed output.
+	// The writer is fed by the stage that drains the export, so it charges
+	// the budget without waiting and bounds its own share instead.
+	window := 2 * workers
+	if limit := opts.Budget.Limit(); limit > 0 {
+		if fit := int(limit / (8 * int64(blockSize))); fit < window {
+			window = fit
+		}
+		if window < 1 {
+			window = 1
+		}
+	}
+
+	b := &BlockWriter{w: w, level: level, blockSize: blockSize, budget: opts.Budget, jobs: make(chan compressJob, workers)}
+	b.blocks.New = func() interface{} {
+		buf := make([]byte, 0, blockSize)
+		return &buf
+	}
+	b.ow = newOrderedWriter(window, func(chunk interface{}) error {
+		cb := chunk.(*compressedBlock)
+		b.index = append(b.index, BlockIndexEntry{Compressed: b.written, Uncompressed: b.input})
+		n, err := b.w.Write(cb.data)
+		b.written += int64(n)
+		b.input += int64(cb.raw)
+		return err
+	})
+	b.ow.budget = opts.Budget
+	b.wg.Add(workers)
+	for i := 0; i < workers; i++ {
+		go b.compressLoop()
+	}
+	return b, nil
+}
+
+// compressLoop compresses blocks until the job channel closes. After a
+// failure it keeps draining jobs so Write and Close never block on it.
+func (b *BlockWriter) compressLoop() {
+	defer b.wg.Done()
+	var (
+		out sliceWriter
+		gz  *gzip.Writer
+	)
+	for j := range b.jobs {
+		out.b = nil
+		if gz == nil {
+			// The level was validated by NewBlockWriter
+			gz, _ = gzip.NewWriterLevel(&out, b.level)
+		} else {
+			gz.Reset(&out)
+		}
+		_, err := gz.Write(*j.buf)
+		if err == nil {
+			err = gz.Close()
+		}
+		raw := len(*j.buf)
+		b.putBlock(j.buf)
+		if err != nil {
+			b.ow.fail(err)
+			continue
+		}
+		// Released by the ordered writer once the block is written
+		b.ow.grow(j.seq, int64(cap(out.b)))
+		b.ow.put(j.seq, &compressedBlock{data: out.b, raw: raw})
+	}
+}
+
+// Write buffers p and hands every full block to the compressors. It blocks
+// while the window of blocks waiting to be written is full.
+func (b *BlockWriter) Write(p []byte) (int, error) {
+	if b.closed {
+		return 0, fmt.Errorf("write to closed BlockWriter")
+	}
+	n := len(p)
+	for len(p) > 0 {
+		if b.cur == nil {
+			b.cur = b.getBlock()
+		}
+		room := b.blockSize - len(*b.cur)
+		if room > len(p) {
+			room = len(p)
+		}
+		*b.cur = append(*b.cur, p[:room]...)
+		p = p[room:]
+		if len(*b.cur) == b.blockSize {
+			if err := b.submit(); err != nil {
+				return n - len(p), err
+			}
+		}
+	}
+	return n, nil
+}
+
+// getBlock takes an input block from the pool and charges it to the budget
+func (b *BlockWriter) getBlock() *[]byte {
+	b.budget.Charge(int64(b.blockSize))
+	buf := b.blocks.Get().(*[]byte)
+	*buf = (*buf)[:0]
+	return buf
+}
+
+func (b *BlockWriter) putBlock(buf *[]byte) {
+	b.blocks.Put(buf)
+	b.budget.Release(int64(b.blockSize))
+}
+
+// submit queues the current block for compression
+func (b *BlockWriter) submit() error {
+	if err := b.ow.acquire(b.seq); err != nil {
+		b.putBlock(b.cur)
+		b.cur = nil
+		return err
+	}
+	b.jobs <- compressJob{seq: b.seq, buf: b.cur}
+	b.cur = nil
+	b.seq++
+	return nil
+}
+
+// Close compresses the last partial block, waits for every block to be
+// written and stops the workers. An empty stream still produces one empty
+// member, so the output is always a valid gzip file.
+func (b *BlockWriter) Close() error {
+	if b.closed {
+		return b.ow.err
+	}
+	b.closed = true
+	var err error
+	if b.cur != nil || b.seq == 0 {
+		if b.cur == nil {
+			b.cur = b.getBlock()
+		}
+		err = b.submit()
+	}
+	close(b.jobs)
+	b.wg.Wait()
+	b.ow.release()
+	if err == nil {
+		err = b.ow.err
+	}
+	return err
+}
+
+// Index returns where each gzip member starts, once Close has returned
+func (b *BlockWriter) Index() []BlockIndexEntry { return b.index }
+
+// CompressedBytes returns the number of bytes written to the underlying
+// writer
+func (b *BlockWriter) CompressedBytes() int64 { return b.written }
+
+// WriteGzipIndex writes idx in the .gzi layout of bgzip: a little-endian
+// uint64 entry count, then a (compressed, uncompressed) uint64 offset pair
+// per member, leaving out the first member which always starts at 0, 0.
+// Tools that seek into block-compressed files with a .gzi index can then
+// start decompressing at the member holding any input offset.
+func WriteGzipIndex(w io.Writer, idx []BlockIndexEntry) error {
+	if len(idx) > 0 && idx[0] == (BlockIndexEntry{}) {
+		idx = idx[1:]
+	}
+	buf := make([]byte, 0, 8+16*len(idx))
+	buf = binary.LittleEndian.AppendUint64(buf, uint64(len(idx)))
+	for _, e := range idx {
+		buf = binary.LittleEndian.AppendUint64(buf, uint64(e.Compressed))
+		buf = binary.LittleEndian.AppendUint64(buf, uint64(e.Uncompressed))
+	}
+	_, err := w.Write(buf)
+	return err
+}
+
+// sliceWriter is an io.Writer appending to a byte slice
+type sliceWriter struct{ b []byte }
+
+func (s *sliceWriter) Write(p []byte) (int, error) {
+	s.b = append(s.b, p...)
+	return len(p), nil
+}
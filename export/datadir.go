@@ -0,0 +1,288 @@
+// datadir.go - Export of many tablespaces on a work-stealing pool
+package export
+
+import (
+	"fmt"
+	"io"
+	"os"
+	"runtime"
+	"sort"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/scan"
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// defaultPartPages is the default of DatadirOptions.PartPages (1GB of leaf
+// pages)
+const defaultPartPages = 1 << 16
+
+// TableSource is a tablespace exported by ExportDatadir
+type TableSource struct {
+	Name string // identifies the table in results, e.g. "db/table"
+	Path string // .ibd file
+	Def  *schema.TableDef
+}
+
+// DatadirOptions configures ExportDatadir
+type DatadirOptions struct {
+	// Options apply to every table; Workers is the size of the pool.
+	// Checkpoints are not supported.
+	Options
+	// PartPages splits tables with more leaf pages into primary key ranges
+	// of about this many pages (default 65536, 1GB), exported by separate
+	// tasks to separate outputs
+	PartPages int
+	// Reader, if set, wraps each opened tablespace, e.g. to throttle reads
+	// (see scan.Throttle.Reader)
+	Reader func(f *os.File) io.ReaderAt
+	// Create opens the output of part part of the parts of table t; it is
+	// called when the part starts, and the output is closed when it ends
+	Create func(t *TableSource, part, parts int) (io.WriteCloser, error)
+	// OnTable, if set, is called for each table as soon as all its parts
+	// are written or it has failed, while other tables are still running.
+	// Calls are never concurrent.
+	OnTable func(res *TableResult)
+}
+
+// TableResult reports the export of one table by ExportDatadir
+type TableResult struct {
+	Table *TableSource
+	// Parts are the key ranges of the table, one per output, in key order;
+	// FirstKey is only set when there are several
+	Parts   []Shard
+	Stats                 // totals of the parts; Stages is not set
+	Tasks   int           // pool tasks the table was split into
+	Elapsed time.Duration // from the start of its first task to its end
+	Err     error
+}
+
+// DatadirStats reports what ExportDatadir did
+type DatadirStats struct {
+	scan.PoolStats
+	Tables int
+	Failed int
+	Rows   int64
+	Bytes  int64
+}
+
+// ExportDatadir exports tables with a work-stealing pool (see scan.RunPool)
+// so that tablespaces of very different sizes keep every worker busy until
+// the end. Each table starts as one task, largest file first, which lists
+// the leaf pages of its clustered index by a descent from the root (see
+// ExportTable), reading only internal pages with the workers the pool can
+// spare, and cuts them into primary key ranges of about opts.PartPages
+// pages. Each range is a
+// task writing its own output through a pipeline (see ExportTable) with
+// the workers the pool can spare. Idle workers steal queued tables and
+// ranges, so the ranges of a huge table are shared by all workers once
+// the small tables are done.
+//
+// A table that fails does not stop the others: its error is reported in
+// its TableResult, and ExportDatadir returns an error once all tables have
+// run if any failed.
+func ExportDatadir(tables []TableSource, opts DatadirOptions) (DatadirStats, error) {
+	if opts.OnCheckpoint != nil || opts.Resume != nil {
+		return DatadirStats{}, fmt.Errorf("checkpoints are not supported for datadir exports")
+	}
+	if opts.Create == nil {
+		return DatadirStats{}, fmt.Errorf("no output for datadir export")
+	}
+	if opts.PartPages <= 0 {
+		opts.PartPages = defaultPartPages
+	}
+	workers := opts.Workers
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	workers = opts.Budget.FitWorkers(workers, workerBytes)
+
+	// Largest first, so the big tables start early and split while the
+	// small ones fill the gaps
+	jobs := make([]*tableJob, len(tables))
+	for i := range tables {
+		jobs[i] = &tableJob{src: &tables[i], opts: &opts}
+		if fi, err := os.Stat(tables[i].Path); err == nil {
+			jobs[i].size = fi.Size()
+		}
+	}
+	sort.SliceStable(jobs, func(i, j int) bool { return jobs[i].size > jobs[j].size })
+
+	var (
+		st   DatadirStats
+		mu   sync.Mutex
+		errs []*TableResult
+	)
+	done := func(res *TableResult) {
+		mu.Lock()
+		defer mu.Unlock()
+		st.Tables++
+		st.Rows += res.Rows
+		st.Bytes += res.Bytes
+		if res.Err != nil {
+			st.Failed++
+			errs = append(errs, res)
+		}
+		if opts.OnTable != nil {
+			opts.OnTable(res)
+		}
+	}
+	tasks := make([]scan.Task, len(jobs))
+	for i, j := range jobs {
+		j.done = done
+		tasks[i] = j.plan
+	}
+	var err error
+	st.PoolStats, err = scan.RunPool(workers, tasks)
+	if err == nil && len(errs) > 0 {
+		err = fmt.Errorf("%d of %d tables failed, first %s: %w", len(errs), len(tables), errs[0].Table.Name, errs[0].Err)
+	}
+	return st, err
+}
+
+// tableJob is the state of one table of ExportDatadir, shared by its tasks
+type tableJob struct {
+	src  *TableSource
+	opts *DatadirOptions
+	done func(res *TableResult)
+	size int64
+
+	f      *os.File
+	r      io.ReaderAt
+	start  time.Time
+	held   int64       // budget held for the list of leaf pages
+	ranges []leafRange // leaf pages of each part
+
+	left     int64 // parts still to run (atomic)
+	tasks    int64 // atomic
+	failed   atomic.Bool
+	errOnce  sync.Once
+	firstErr error
+
+	mu  sync.Mutex
+	res TableResult
+}
+
+// fail records the first error of the table
+func (j *tableJob) fail(err error) {
+	j.errOnce.Do(func() { j.firstErr = err })
+	j.failed.Store(true)
+}
+
+// plan opens the tablespace, lists its leaf pages and splits them
+func (j *tableJob) plan(w *scan.Worker) error {
+	j.start = time.Now()
+	atomic.AddInt64(&j.tasks, 1)
+	var err error
+	if j.f, err = os.Open(j.src.Path); err != nil {
+		j.fail(err)
+		j.finish()
+		return nil
+	}
+	j.r = j.f
+	if j.opts.Reader != nil {
+		j.r = j.opts.Reader(j.f)
+	}
+	fi, err := j.f.Stat()
+	if err != nil {
+		j.fail(err)
+		j.finish()
+		return nil
+	}
+	j.size = fi.Size()
+	lr, err := leafLevel(j.r, j.size, j.src.Def, j.opts.Options, w.Share())
+	if err != nil {
+		j.fail(err)
+		j.finish()
+		return nil
+	}
+	j.held = 4 * int64(len(lr.pages))
+	j.split(w, lr)
+	return nil
+}
+
+// split cuts the leaf level into parts and queues a task per part
+func (j *tableJob) split(w *scan.Worker, lr leafRange) {
+	parts := (len(lr.pages) + j.opts.PartPages - 1) / j.opts.PartPages
+	if parts < 1 {
+		parts = 1
+	}
+	j.ranges = lr.split(parts)
+	j.res.Parts = make([]Shard, parts)
+	for i, pr := range j.ranges {
+		if len(pr.pages) > 0 {
+			j.res.Parts[i].FirstPage, j.res.Parts[i].LastPage = pr.pages[0], pr.pages[len(pr.pages)-1]
+		}
+	}
+	if parts > 1 {
+		buf := make([]byte, format.PageSize)
+		for i, pr := range j.ranges {
+			if len(pr.pages) == 0 {
+				continue
+			}
+			var err error
+			if j.res.Parts[i].FirstKey, err = firstKey(j.r, j.src.Def, pr.pages[0], buf); err != nil {
+				j.fail(fmt.Errorf("part %d: %w", i, err))
+				j.finish()
+				return
+			}
+		}
+	}
+
+	j.left = int64(parts)
+	for i := parts - 1; i >= 0; i-- {
+		i := i
+		w.Spawn(func(w *scan.Worker) error {
+			atomic.AddInt64(&j.tasks, 1)
+			if !j.failed.Load() {
+				if err := j.exportPart(w, i); err != nil {
+					j.fail(fmt.Errorf("part %d: %w", i, err))
+				}
+			}
+			if atomic.AddInt64(&j.left, -1) == 0 {
+				j.finish()
+			}
+			return nil
+		})
+	}
+}
+
+// exportPart writes part i of the table to its output
+func (j *tableJob) exportPart(w *scan.Worker, i int) error {
+	out, err := j.opts.Create(j.src, i, len(j.ranges))
+	if err != nil {
+		return err
+	}
+	st, err := exportBatches(out, j.r, j.src.Def, j.ranges[i], j.opts.Options, w.Share(), j.size)
+	if cerr := out.Close(); err == nil {
+		err = cerr
+	}
+	st.Stages = nil
+	j.mu.Lock()
+	j.res.Parts[i].Stats = st
+	j.mu.Unlock()
+	return err
+}
+
+// finish releases what the table holds and reports it
+func (j *tableJob) finish() {
+	j.opts.Budget.Release(j.held)
+	j.held, j.ranges = 0, nil
+	if j.f != nil {
+		j.f.Close()
+	}
+	res := &j.res
+	res.Table = j.src
+	res.Err = j.firstErr
+	res.Tasks = int(atomic.LoadInt64(&j.tasks))
+	res.Elapsed = time.Since(j.start)
+	for _, p := range res.Parts {
+		res.Pages += p.Pages
+		res.Rows += p.Rows
+		res.Bytes += p.Bytes
+	}
+	j.done(res)
+}
@@ -0,0 +1,149 @@
+// flatbuf.go - Minimal FlatBuffers builder for Arrow IPC metadata
+package export
+
+import "encoding/binary"
+
+// fbBuilder builds a FlatBuffer back to front, like the reference builder:
+// children are written before the tables that point at them, and offsets
+// are counted from the end of the buffer. Only what Arrow metadata needs is
+// supported: tables with scalar, offset and union fields, strings, and
+// vectors of offsets or structs. Vtables are not deduplicated; Arrow
+// messages are small.
+type fbBuilder struct {
+	buf      []byte // content is buf[head:]
+	head     int
+	minAlign int
+	vtable   []int // offsets of the fields of the open table, 0 if absent
+	objEnd   int
+}
+
+func newFBBuilder() *fbBuilder {
+	return &fbBuilder{buf: make([]byte, 1024), head: 1024, minAlign: 1}
+}
+
+// offset returns the number of bytes written so far
+func (b *fbBuilder) offset() int { return len(b.buf) - b.head }
+
+// prep makes room for additional bytes followed by a size-aligned value
+func (b *fbBuilder) prep(size, additional int) {
+	if size > b.minAlign {
+		b.minAlign = size
+	}
+	pad := (-(b.offset() + additional)) & (size - 1)
+	if need := pad + size + additional; b.head < need {
+		old := len(b.buf)
+		grown := make([]byte, 2*old+need)
+		copy(grown[len(grown)-old+b.head:], b.buf[b.head:])
+		b.head += len(grown) - old
+		b.buf = grown
+	}
+	for i := 0; i < pad; i++ {
+		b.head--
+		b.buf[b.head] = 0
+	}
+}
+
+func (b *fbBuilder) placeUint8(v uint8) {
+	b.head--
+	b.buf[b.head] = v
+}
+
+func (b *fbBuilder) placeUint16(v uint16) {
+	b.head -= 2
+	binary.LittleEndian.PutUint16(b.buf[b.head:], v)
+}
+
+func (b *fbBuilder) placeUint32(v uint32) {
+	b.head -= 4
+	binary.LittleEndian.PutUint32(b.buf[b.head:], v)
+}
+
+func (b *fbBuilder) placeUint64(v uint64) {
+	b.head -= 8
+	binary.LittleEndian.PutUint64(b.buf[b.head:], v)
+}
+
+func (b *fbBuilder) prependUint8(v uint8)   { b.prep(1, 0); b.placeUint8(v) }
+func (b *fbBuilder) prependUint16(v uint16) { b.prep(2, 0); b.placeUint16(v) }
+func (b *fbBuilder) prependUint32(v uint32) { b.prep(4, 0); b.placeUint32(v) }
+func (b *fbBuilder) prependUint64(v uint64) { b.prep(8, 0); b.placeUint64(v) }
+
+// prependOffset writes a reference to the object at offset off
+func (b *fbBuilder) prependOffset(off int) {
+	b.prep(4, 0)
+	b.placeUint32(uint32(b.offset() - off + 4))
+}
+
+// createString writes a NUL-terminated string and returns its offset
+func (b *fbBuilder) createString(s string) int {
+	b.prep(4, len(s)+1)
+	b.placeUint8(0)
+	b.head -= len(s)
+	copy(b.buf[b.head:], s)
+	b.placeUint32(uint32(len(s)))
+	return b.offset()
+}
+
+// startVector prepares a vector of n elements of elemSize bytes; the
+// elements are then prepended last to first
+func (b *fbBuilder) startVector(elemSize, n, align int) {
+	b.prep(4, elemSize*n)
+	b.prep(align, elemSize*n)
+}
+
+func (b *fbBuilder) endVector(n int) int {
+	b.placeUint32(uint32(n))
+	return b.offset()
+}
+
+// offsetVector writes a vector of references to objects
+func (b *fbBuilder) offsetVector(offs []int) int {
+	b.startVector(4, len(offs), 4)
+	for i := len(offs) - 1; i >= 0; i-- {
+		b.prependOffset(offs[i])
+	}
+	return b.endVector(len(offs))
+}
+
+func (b *fbBuilder) startTable(numFields int) {
+	b.vtable = b.vtable[:0]
+	for i := 0; i < numFields; i++ {
+		b.vtable = append(b.vtable, 0)
+	}
+	b.objEnd = b.offset()
+}
+
+func (b *fbBuilder) slot(i int) { b.vtable[i] = b.offset() }
+
+// Table fields are always written, even when equal to the schema default
+func (b *fbBuilder) addUint8(i int, v uint8)   { b.prependUint8(v); b.slot(i) }
+func (b *fbBuilder) addUint16(i int, v uint16) { b.prependUint16(v); b.slot(i) }
+func (b *fbBuilder) addUint32(i int, v uint32) { b.prependUint32(v); b.slot(i) }
+func (b *fbBuilder) addUint64(i int, v uint64) { b.prependUint64(v); b.slot(i) }
+func (b *fbBuilder) addOffset(i int, off int)  { b.prependOffset(off); b.slot(i) }
+
+// endTable writes the vtable of the open table right before it and returns
+// the table's offset
+func (b *fbBuilder) endTable() int {
+	b.prependUint32(0) // vtable reference, patched below
+	obj := b.offset()
+	for i := len(b.vtable) - 1; i >= 0; i-- {
+		var off uint16
+		if b.vtable[i] != 0 {
+			off = uint16(obj - b.vtable[i])
+		}
+		b.prependUint16(off)
+	}
+	b.prependUint16(uint16(obj - b.objEnd))
+	b.prependUint16(uint16((len(b.vtable) + 2) * 2))
+	// The vtable sits before the table: table - vtable = its size
+	binary.LittleEndian.PutUint32(b.buf[len(b.buf)-obj:], uint32(b.offset()-obj))
+	return obj
+}
+
+// finish writes the root table reference and returns the buffer
+func (b *fbBuilder) finish(root int) []byte {
+	b.prep(b.minAlign, 4)
+	b.prependOffset(root)
+	return b.buf[b.head:]
+}
@@ -0,0 +1,335 @@
+// format.go - Output formats and delimited text formatting of column values
+package export
+
+import (
+	"fmt"
+	"math"
+	"strconv"
+
+	"github.com/wilhasse/go-innodb/charset"
+	"github.com/wilhasse/go-innodb/column"
+	"github.com/wilhasse/go-innodb/record"
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// Format is an export output format
+type Format int
+
+const (
+	// CSV follows RFC 4180: fields containing the delimiter, a quote, CR or
+	// LF are quoted and inner quotes doubled. NULL is an empty field.
+	CSV Format = iota
+	// TSV follows MySQL's SELECT ... INTO OUTFILE defaults: tab, newline,
+	// backslash, CR and NUL are backslash-escaped. NULL is \N.
+	TSV
+	// NDJSON writes one JSON object per line, keyed by column name. NULL is
+	// null; numbers are bare and everything else is a string, except JSON
+	// columns which are embedded as documents. There is no header line.
+	NDJSON
+	// ArrowStream is the Arrow IPC streaming format (.arrows), one record
+	// batch per row group
+	ArrowStream
+	// ArrowFile is the Arrow IPC file format (.arrow, Feather v2): the
+	// stream framed by magic bytes and a footer indexing the record batches
+	ArrowFile
+	// Parquet writes one row group per RowGroupRows rows, with dictionary
+	// encoded column chunks where the dictionary pays off
+	Parquet
+
+	// rawText writes values unescaped; it formats the values of string
+	// columns in columnar output
+	rawText Format = -1
+)
+
+// ParseFormat returns the Format named "csv", "tsv", "ndjson", "arrows"
+// (Arrow stream), "arrow" (Arrow file) or "parquet"
+func ParseFormat(name string) (Format, error) {
+	switch name {
+	case "csv":
+		return CSV, nil
+	case "tsv":
+		return TSV, nil
+	case "ndjson":
+		return NDJSON, nil
+	case "arrows":
+		return ArrowStream, nil
+	case "arrow":
+		return ArrowFile, nil
+	case "parquet":
+		return Parquet, nil
+	}
+	return 0, fmt.Errorf("unknown export format %q (want csv, tsv, ndjson, arrow, arrows or parquet)", name)
+}
+
+// String returns the name of f as accepted by ParseFormat
+func (f Format) String() string {
+	switch f {
+	case CSV:
+		return "csv"
+	case TSV:
+		return "tsv"
+	case NDJSON:
+		return "ndjson"
+	case ArrowStream:
+		return "arrows"
+	case ArrowFile:
+		return "arrow"
+	case Parquet:
+		return "parquet"
+	}
+	return fmt.Sprintf("Format(%d)", int(f))
+}
+
+// Columnar reports whether f is a binary columnar format
+func (f Format) Columnar() bool {
+	return f >= ArrowStream
+}
+
+// Delimiter returns the field separator of f
+func (f Format) Delimiter() byte {
+	if f == TSV {
+		return '\t'
+	}
+	return ','
+}
+
+// needsQuote marks the bytes that force RFC 4180 quoting
+var needsQuote = [256]bool{',': true, '"': true, '\r': true, '\n': true}
+
+// tsvEscape maps bytes escaped in TSV output to their escape letter
+var tsvEscape = [256]byte{'\t': 't', '\n': 'n', '\r': 'r', '\\': '\\', 0: '0'}
+
+// appendField appends raw string/binary content escaped for f. The common
+// case of a field with nothing to escape is one table scan and one copy.
+func (f Format) appendField(dst, s []byte) []byte {
+	if f == rawText {
+		return append(dst, s...)
+	}
+	if f == NDJSON {
+		return AppendJSONString(dst, s)
+	}
+	if f == TSV {
+		start := 0
+		for i, c := range s {
+			if e := tsvEscape[c]; e != 0 {
+				dst = append(dst, s[start:i]...)
+				dst = append(dst, '\\', e)
+				start = i + 1
+			}
+		}
+		return append(dst, s[start:]...)
+	}
+
+	quote := false
+	for _, c := range s {
+		if needsQuote[c] {
+			quote = true
+			break
+		}
+	}
+	if !quote {
+		return append(dst, s...)
+	}
+	dst = append(dst, '"')
+	start := 0
+	for i, c := range s {
+		if c == '"' {
+			dst = append(dst, s[start:i+1]...)
+			dst = append(dst, '"')
+			start = i + 1
+		}
+	}
+	dst = append(dst, s[start:]...)
+	return append(dst, '"')
+}
+
+// appendNull appends the NULL marker of f
+func (f Format) appendNull(dst []byte) []byte {
+	switch f {
+	case TSV:
+		return append(dst, '\\', 'N')
+	case NDJSON:
+		return append(dst, "null"...)
+	}
+	return dst
+}
+
+// Encoder formats rows as delimited text into caller-provided buffers.
+// It keeps scratch space between calls, so one Encoder must not be used
+// concurrently.
+type Encoder struct {
+	Format Format
+	// Conv converts string and binary values to UTF-8; nil writes them as
+	// stored
+	Conv *charset.Converter
+	// Convs, if set, replaces Conv in AppendRecord and AppendObject with a
+	// converter per column of cols, nil for those written as stored (see
+	// Converters)
+	Convs []*charset.Converter
+
+	scratch []byte
+	// NDJSON object keys, escaped once per column list (see jsonKeys)
+	keyCols []*schema.Column
+	keys    [][]byte
+}
+
+// AppendHeader appends the column names as a header line. NDJSON has no
+// header; its objects carry the names.
+func (e *Encoder) AppendHeader(dst []byte, cols []*schema.Column) []byte {
+	if e.Format == NDJSON {
+		return dst
+	}
+	for i, col := range cols {
+		if i > 0 {
+			dst = append(dst, e.Format.Delimiter())
+		}
+		dst = e.Format.appendField(dst, []byte(col.Name))
+	}
+	return append(dst, '\n')
+}
+
+// AppendRecord appends the values of cols in rec as one line
+func (e *Encoder) AppendRecord(dst []byte, cols []*schema.Column, rec *record.GenericRecord) ([]byte, error) {
+	if e.Format == NDJSON {
+		dst, err := e.AppendObject(dst, cols, rec)
+		return append(dst, '\n'), err
+	}
+	var err error
+	for i, col := range cols {
+		if i > 0 {
+			dst = append(dst, e.Format.Delimiter())
+		}
+		if dst, err = e.appendValue(dst, rec.Values[col.Name], e.conv(i)); err != nil {
+			return dst, fmt.Errorf("column %s: %w", col.Name, err)
+		}
+	}
+	return append(dst, '\n'), nil
+}
+
+// AppendValue appends one column value, as stored in GenericRecord.Values,
+// formatted and escaped for the output format
+func (e *Encoder) AppendValue(dst []byte, v interface{}) ([]byte, error) {
+	if e.Format == NDJSON {
+		return e.appendJSONValue(dst, v, e.Conv)
+	}
+	return e.appendValue(dst, v, e.Conv)
+}
+
+// conv returns the converter of column i of a record
+func (e *Encoder) conv(i int) *charset.Converter {
+	if e.Convs != nil {
+		return e.Convs[i]
+	}
+	return e.Conv
+}
+
+// Converters returns a converter per column of cols for Encoder.Convs.
+// Text columns (CHAR, VARCHAR, TEXT) are converted by conv when it is set;
+// otherwise those declared utf8mb4, utf8mb3 or utf8 are validated under
+// policy and latin1 ones converted. Binary strings and other types get
+// nil and are written as stored.
+func Converters(cols []*schema.Column, conv *charset.Converter, policy charset.Policy) []*charset.Converter {
+	convs := make([]*charset.Converter, len(cols))
+	byName := make(map[string]*charset.Converter)
+	for i, col := range cols {
+		switch col.ResolvedCode() {
+		case schema.CodeChar, schema.CodeVarchar, schema.CodeText, schema.CodeTinyText,
+			schema.CodeMediumText, schema.CodeLongText:
+		default:
+			continue
+		}
+		if conv != nil {
+			convs[i] = conv
+			continue
+		}
+		switch col.Charset {
+		case "utf8mb4", "utf8mb3", "utf8", "latin1":
+			if byName[col.Charset] == nil {
+				byName[col.Charset] = charset.NewConverter(col.Charset, policy)
+			}
+			convs[i] = byName[col.Charset]
+		}
+	}
+	return convs
+}
+
+func (e *Encoder) appendValue(dst []byte, v interface{}, conv *charset.Converter) ([]byte, error) {
+	f := e.Format
+	switch x := v.(type) {
+	case nil:
+		return f.appendNull(dst), nil
+	case column.View:
+		return e.appendText(dst, x, conv)
+	case []byte:
+		return e.appendText(dst, x, conv)
+	case string:
+		return e.appendText(dst, []byte(x), conv)
+	case int8:
+		return strconv.AppendInt(dst, int64(x), 10), nil
+	case int16:
+		return strconv.AppendInt(dst, int64(x), 10), nil
+	case int32:
+		return strconv.AppendInt(dst, int64(x), 10), nil
+	case int64:
+		return strconv.AppendInt(dst, x, 10), nil
+	case int:
+		return strconv.AppendInt(dst, int64(x), 10), nil
+	case uint8:
+		return strconv.AppendUint(dst, uint64(x), 10), nil
+	case uint16:
+		return strconv.AppendUint(dst, uint64(x), 10), nil
+	case uint32:
+		return strconv.AppendUint(dst, uint64(x), 10), nil
+	case uint64:
+		return strconv.AppendUint(dst, x, 10), nil
+	case float32:
+		return appendFloat(dst, float64(x), 32), nil
+	case float64:
+		return appendFloat(dst, x, 64), nil
+	case column.Date:
+		return x.AppendFormat(dst), nil
+	case column.DateTime:
+		return x.AppendFormat(dst), nil
+	case column.Timestamp:
+		return x.AppendFormat(dst), nil
+	case column.Time:
+		return x.AppendFormat(dst), nil
+	case column.Decimal:
+		return x.AppendFormat(dst), nil
+	case column.Set:
+		// Members are comma separated, so the value may need quoting
+		e.scratch = x.AppendFormat(e.scratch[:0])
+		return f.appendField(dst, e.scratch), nil
+	case column.JSON:
+		text, err := x.AppendText(e.scratch[:0])
+		if err != nil {
+			return dst, err
+		}
+		e.scratch = text
+		return f.appendField(dst, text), nil
+	case fmt.Stringer:
+		return f.appendField(dst, []byte(x.String())), nil
+	}
+	return f.appendField(dst, []byte(fmt.Sprint(v))), nil
+}
+
+// appendText converts s to UTF-8 with conv through the scratch buffer when
+// needed, then escapes it into dst
+func (e *Encoder) appendText(dst, s []byte, conv *charset.Converter) ([]byte, error) {
+	if conv == nil || charset.IsASCII(s) {
+		return e.Format.appendField(dst, s), nil
+	}
+	out, err := conv.Append(e.scratch[:0], s)
+	if err != nil {
+		return dst, err
+	}
+	e.scratch = out
+	return e.Format.appendField(dst, out), nil
+}
+
+func appendFloat(dst []byte, v float64, bits int) []byte {
+	if math.IsInf(v, 0) || math.IsNaN(v) {
+		return dst
+	}
+	return strconv.AppendFloat(dst, v, 'g', -1, bits)
+}
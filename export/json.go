@@ -0,0 +1,147 @@
+// json.go - Newline-delimited JSON formatting of rows
+package export
+
+import (
+	"fmt"
+	"math"
+	"strconv"
+	"unicode/utf8"
+
+	"github.com/wilhasse/go-innodb/charset"
+	"github.com/wilhasse/go-innodb/column"
+	"github.com/wilhasse/go-innodb/record"
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// jsonSafe marks the bytes copied into a JSON string as they are: printable
+// ASCII other than the quote and backslash. Everything else takes the slow
+// path in AppendJSONString.
+var jsonSafe = func() (t [256]bool) {
+	for c := 0x20; c < utf8.RuneSelf; c++ {
+		t[c] = c != '"' && c != '\\'
+	}
+	return t
+}()
+
+// AppendJSONString appends s as a quoted JSON string. Control characters,
+// the quote and backslash are escaped; invalid UTF-8 sequences (binary
+// columns, or text written without a charset conversion) are replaced by
+// U+FFFD like encoding/json does, so the output is always valid JSON.
+func AppendJSONString(dst, s []byte) []byte {
+	dst = append(dst, '"')
+	start := 0
+	for i := 0; i < len(s); {
+		c := s[i]
+		if jsonSafe[c] {
+			i++
+			continue
+		}
+		if c >= utf8.RuneSelf {
+			r, n := utf8.DecodeRune(s[i:])
+			if r != utf8.RuneError || n != 1 {
+				i += n
+				continue
+			}
+			dst = append(dst, s[start:i]...)
+			dst = append(dst, "\uFFFD"...)
+			i++
+			start = i
+			continue
+		}
+		dst = append(dst, s[start:i]...)
+		switch c {
+		case '"', '\\':
+			dst = append(dst, '\\', c)
+		case '\n':
+			dst = append(dst, '\\', 'n')
+		case '\r':
+			dst = append(dst, '\\', 'r')
+		case '\t':
+			dst = append(dst, '\\', 't')
+		default:
+			const hex = "0123456789abcdef"
+			dst = append(dst, '\\', 'u', '0', '0', hex[c>>4], hex[c&0xF])
+		}
+		i++
+		start = i
+	}
+	dst = append(dst, s[start:]...)
+	return append(dst, '"')
+}
+
+// jsonKeys returns the `"name":` prefix of every column, escaped once and
+// cached for as long as the encoder is given the same columns
+func (e *Encoder) jsonKeys(cols []*schema.Column) [][]byte {
+	same := len(e.keyCols) == len(cols)
+	for i := 0; same && i < len(cols); i++ {
+		same = e.keyCols[i] == cols[i]
+	}
+	if !same {
+		e.keyCols = append(e.keyCols[:0], cols...)
+		e.keys = e.keys[:0]
+		for i, col := range cols {
+			var k []byte
+			if i > 0 {
+				k = append(k, ',')
+			}
+			k = AppendJSONString(k, []byte(col.Name))
+			e.keys = append(e.keys, append(k, ':'))
+		}
+	}
+	return e.keys
+}
+
+// AppendObject appends the values of cols in rec as one JSON object, keyed
+// by column name in column order
+func (e *Encoder) AppendObject(dst []byte, cols []*schema.Column, rec *record.GenericRecord) ([]byte, error) {
+	keys := e.jsonKeys(cols)
+	dst = append(dst, '{')
+	var err error
+	for i, col := range cols {
+		dst = append(dst, keys[i]...)
+		if dst, err = e.appendJSONValue(dst, rec.Values[col.Name], e.conv(i)); err != nil {
+			return dst, fmt.Errorf("column %s: %w", col.Name, err)
+		}
+	}
+	return append(dst, '}'), nil
+}
+
+// appendJSONValue appends one column value as a JSON value. Numbers are
+// written bare (DECIMAL too, with all its digits); temporal values, SET and
+// text are strings; JSON columns are embedded as documents.
+func (e *Encoder) appendJSONValue(dst []byte, v interface{}, conv *charset.Converter) ([]byte, error) {
+	switch x := v.(type) {
+	case nil:
+		return append(dst, "null"...), nil
+	case float32:
+		return appendJSONFloat(dst, float64(x), 32), nil
+	case float64:
+		return appendJSONFloat(dst, x, 64), nil
+	case column.Date:
+		dst = append(dst, '"')
+		return append(x.AppendFormat(dst), '"'), nil
+	case column.DateTime:
+		dst = append(dst, '"')
+		return append(x.AppendFormat(dst), '"'), nil
+	case column.Timestamp:
+		dst = append(dst, '"')
+		return append(x.AppendFormat(dst), '"'), nil
+	case column.Time:
+		dst = append(dst, '"')
+		return append(x.AppendFormat(dst), '"'), nil
+	case column.JSON:
+		return x.AppendText(dst)
+	}
+	// Integers and DECIMAL format as numbers; the rest go through
+	// appendField, which quotes for NDJSON
+	return e.appendValue(dst, v, conv)
+}
+
+// appendJSONFloat writes NaN and infinities, which JSON cannot represent,
+// as null
+func appendJSONFloat(dst []byte, v float64, bits int) []byte {
+	if math.IsInf(v, 0) || math.IsNaN(v) {
+		return append(dst, "null"...)
+	}
+	return strconv.AppendFloat(dst, v, 'g', -1, bits)
+}
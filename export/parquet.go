@@ -0,0 +1,525 @@
+// parquet.go - Parquet output with dictionary and RLE encoded column chunks
+package export
+
+import (
+	"bytes"
+	"compress/gzip"
+	"encoding/binary"
+	"fmt"
+	"math/bits"
+	"sync"
+	"sync/atomic"
+
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// Parquet constants (parquet.thrift)
+const (
+	pqInt32     = 1
+	pqInt64     = 2
+	pqFloat     = 4
+	pqDouble    = 5
+	pqByteArray = 6
+
+	pqRequired = 0
+	pqOptional = 1
+
+	pqUTF8            = 0
+	pqDecimal         = 5
+	pqDate            = 6
+	pqTimestampMicros = 10
+	pqUint64          = 14
+
+	pqPlain          = 0
+	pqRLE            = 3
+	pqRLEDictionary  = 8
+	pqDataPage       = 0
+	pqDictionaryPage = 2
+)
+
+// Dictionary limits per column chunk: past either, the chunk falls back to
+// PLAIN encoding
+const (
+	maxDictEntries = 1 << 16
+	maxDictBytes   = 1 << 20
+)
+
+var parquetMagic = []byte("PAR1")
+
+// parquetCodec is the CompressionCodec of c in parquet.thrift
+func (c Codec) parquetCodec() int32 {
+	if c == Gzip {
+		return 2
+	}
+	return 0
+}
+
+// parquetWriter writes one row group per group of batches. The column
+// chunks of a row group are encoded and compressed in parallel, then written
+// one after the other; the footer is written by close.
+type parquetWriter struct {
+	w       *countingWriter
+	cols    []*schema.Column
+	kinds   []kind
+	codec   Codec
+	level   int
+	workers int
+	groups  []pqRowGroup
+	rows    int64
+}
+
+// pqChunk is an encoded column chunk
+type pqChunk struct {
+	data         []byte // page headers and pages
+	values       int64
+	uncompressed int64
+	compressed   int64
+	dictPage     int64 // offset of the dictionary page in data, -1 if none
+	dataPage     int64 // offset of the first data page in data
+	encodings    []int32
+	offset       int64 // offset of the chunk in the file, once written
+}
+
+type pqRowGroup struct {
+	chunks []pqChunk
+	rows   int64
+	bytes  int64
+}
+
+func newParquetWriter(w *countingWriter, cols []*schema.Column, kinds []kind, codec Codec, level, workers int) (*parquetWriter, error) {
+	level, err := checkLevel(level)
+	if err != nil {
+		return nil, err
+	}
+	if _, err := w.Write(parquetMagic); err != nil {
+		return nil, err
+	}
+	return &parquetWriter{w: w, cols: cols, kinds: kinds, codec: codec, level: level, workers: workers}, nil
+}
+
+// physical returns the Parquet physical and converted type of a column
+// (converted type -1 for none)
+func physical(col *schema.Column, k kind) (int32, int32) {
+	switch k {
+	case kindInt64:
+		return pqInt64, -1
+	case kindUint64:
+		return pqInt64, pqUint64
+	case kindFloat32:
+		return pqFloat, -1
+	case kindFloat64:
+		return pqDouble, -1
+	case kindDecimal64:
+		return pqInt64, pqDecimal
+	case kindDate32:
+		return pqInt32, pqDate
+	case kindTimestamp:
+		return pqInt64, pqTimestampMicros
+	case kindBinary:
+		return pqByteArray, -1
+	}
+	return pqByteArray, pqUTF8
+}
+
+// writeGroup encodes the batches of a group as one row group
+func (p *parquetWriter) writeGroup(group []*columnBatch) error {
+	rg := pqRowGroup{chunks: make([]pqChunk, len(p.cols))}
+	for _, cb := range group {
+		rg.rows += int64(cb.rows)
+	}
+
+	workers := p.workers
+	if workers > len(p.cols) {
+		workers = len(p.cols)
+	}
+	var (
+		next     int64 = -1
+		wg       sync.WaitGroup
+		errOnce  sync.Once
+		firstErr error
+	)
+	for i := 0; i < workers; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			e := chunkEncoder{codec: p.codec, level: p.level}
+			for {
+				c := int(atomic.AddInt64(&next, 1))
+				if c >= len(p.cols) {
+					return
+				}
+				chunk, err := e.encode(group, c, p.cols[c], p.kinds[c])
+				if err != nil {
+					errOnce.Do(func() { firstErr = fmt.Errorf("column %s: %w", p.cols[c].Name, err) })
+					return
+				}
+				rg.chunks[c] = chunk
+			}
+		}()
+	}
+	wg.Wait()
+	if firstErr != nil {
+		return firstErr
+	}
+
+	for c := range rg.chunks {
+		ch := &rg.chunks[c]
+		ch.offset = p.w.n
+		ch.compressed = int64(len(ch.data))
+		if _, err := p.w.Write(ch.data); err != nil {
+			return err
+		}
+		ch.data = nil
+		rg.bytes += ch.uncompressed
+	}
+	p.groups = append(p.groups, rg)
+	p.rows += rg.rows
+	return nil
+}
+
+// close writes the file metadata and the footer
+func (p *parquetWriter) close() error {
+	t := thriftWriter{}
+	t.begin()
+	t.i32(1, 1)
+	t.list(2, thriftStruct, len(p.cols)+1)
+	t.begin()
+	t.string(4, "schema")
+	t.i32(5, int32(len(p.cols)))
+	t.end()
+	for i, col := range p.cols {
+		k := p.kinds[i]
+		phys, conv := physical(col, k)
+		t.begin()
+		t.i32(1, phys)
+		if nullable(col, k) {
+			t.i32(3, pqOptional)
+		} else {
+			t.i32(3, pqRequired)
+		}
+		t.string(4, col.Name)
+		if conv >= 0 {
+			t.i32(6, conv)
+		}
+		if k == kindDecimal64 {
+			t.i32(7, int32(col.Scale))
+			t.i32(8, int32(col.Precision))
+		}
+		t.end()
+	}
+	t.i64(3, p.rows)
+	t.list(4, thriftStruct, len(p.groups))
+	for _, rg := range p.groups {
+		t.begin()
+		t.list(1, thriftStruct, len(rg.chunks))
+		for c, ch := range rg.chunks {
+			phys, _ := physical(p.cols[c], p.kinds[c])
+			t.begin()
+			t.i64(2, ch.offset)
+			t.beginField(3)
+			t.i32(1, phys)
+			t.listI32(2, ch.encodings)
+			t.listString(3, []string{p.cols[c].Name})
+			t.i32(4, p.codec.parquetCodec())
+			t.i64(5, ch.values)
+			t.i64(6, ch.uncompressed)
+			t.i64(7, ch.compressed)
+			t.i64(9, ch.offset+ch.dataPage)
+			if ch.dictPage >= 0 {
+				t.i64(11, ch.offset+ch.dictPage)
+			}
+			t.end()
+			t.end()
+		}
+		t.i64(2, rg.bytes)
+		t.i64(3, rg.rows)
+		t.end()
+	}
+	t.string(6, "go-innodb")
+	t.end()
+
+	var size [4]byte
+	binary.LittleEndian.PutUint32(size[:], uint32(len(t.buf)))
+	for _, b := range [][]byte{t.buf, size[:], parquetMagic} {
+		if _, err := p.w.Write(b); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// chunkEncoder encodes column chunks; each encoding goroutine has its own
+type chunkEncoder struct {
+	codec  Codec
+	level  int
+	gz     *gzip.Writer
+	zbuf   bytes.Buffer
+	hdr    thriftWriter
+	page   []byte
+	levels []int32
+	idx    []int32 // dictionary indices of the non-NULL values of the chunk
+
+	fixedDict map[uint64]int32
+	bytesDict map[string]int32
+	dictVals  []uint64 // fixed-width dictionary values
+	dictData  []byte   // PLAIN encoded byte array dictionary values
+	dictLen   int
+}
+
+// encode encodes column c of the group: an optional dictionary page, then
+// one data page per batch
+func (e *chunkEncoder) encode(group []*columnBatch, c int, col *schema.Column, k kind) (pqChunk, error) {
+	ch := pqChunk{dictPage: -1}
+	opt := nullable(col, k)
+	useDict := e.buildDict(group, c, k)
+
+	var out []byte
+	if useDict {
+		ch.encodings = []int32{pqPlain, pqRLE, pqRLEDictionary}
+		ch.dictPage = 0
+		var page []byte
+		if k.fixed() {
+			for _, v := range e.dictVals {
+				page = appendPlainFixed(page, v, k.width())
+			}
+		} else {
+			page = e.dictData
+		}
+		var err error
+		if out, err = e.appendPage(out, &ch, pqDictionaryPage, e.dictLen, page); err != nil {
+			return ch, err
+		}
+	} else {
+		ch.encodings = []int32{pqPlain, pqRLE}
+	}
+	ch.dataPage = int64(len(out))
+
+	width := uint(bits.Len(uint(e.dictLen - 1)))
+	if width == 0 {
+		width = 1
+	}
+	idx := e.idx
+	for _, cb := range group {
+		vec := &cb.vecs[c]
+		page := e.page[:0]
+		if opt {
+			e.levels = e.levels[:0]
+			for _, ok := range vec.valid {
+				if ok {
+					e.levels = append(e.levels, 1)
+				} else {
+					e.levels = append(e.levels, 0)
+				}
+			}
+			page = append(page, 0, 0, 0, 0)
+			page = appendHybrid(page, e.levels, 1)
+			binary.LittleEndian.PutUint32(page, uint32(len(page)-4))
+		}
+		n := cb.rows - vec.nulls
+		if useDict {
+			page = append(page, byte(width))
+			page = appendHybrid(page, idx[:n], width)
+			idx = idx[n:]
+		} else {
+			page = appendPlain(page, vec, k)
+		}
+		e.page = page
+		var err error
+		if out, err = e.appendPage(out, &ch, pqDataPage, cb.rows, page); err != nil {
+			return ch, err
+		}
+		ch.values += int64(cb.rows)
+	}
+	ch.data = out
+	return ch, nil
+}
+
+// appendPage compresses a page and appends it with its header to out
+func (e *chunkEncoder) appendPage(out []byte, ch *pqChunk, typ int32, values int, page []byte) ([]byte, error) {
+	body := page
+	if e.codec == Gzip {
+		e.zbuf.Reset()
+		if e.gz == nil {
+			// The level was validated by newParquetWriter
+			e.gz, _ = gzip.NewWriterLevel(&e.zbuf, e.level)
+		} else {
+			e.gz.Reset(&e.zbuf)
+		}
+		if _, err := e.gz.Write(page); err != nil {
+			return out, err
+		}
+		if err := e.gz.Close(); err != nil {
+			return out, err
+		}
+		body = e.zbuf.Bytes()
+	}
+
+	t := &e.hdr
+	t.buf = t.buf[:0]
+	t.begin()
+	t.i32(1, typ)
+	t.i32(2, int32(len(page)))
+	t.i32(3, int32(len(body)))
+	if typ == pqDataPage {
+		enc := int32(pqPlain)
+		if ch.dictPage >= 0 {
+			enc = pqRLEDictionary
+		}
+		t.beginField(5)
+		t.i32(1, int32(values))
+		t.i32(2, enc)
+		t.i32(3, pqRLE)
+		t.i32(4, pqRLE)
+		t.end()
+	} else {
+		t.beginField(7)
+		t.i32(1, int32(values))
+		t.i32(2, pqPlain)
+		t.end()
+	}
+	t.end()
+
+	ch.uncompressed += int64(len(t.buf) + len(page))
+	out = append(out, t.buf...)
+	return append(out, body...), nil
+}
+
+// buildDict maps the non-NULL values of column c to dictionary indices in
+// e.idx. It reports false, and the chunk is PLAIN encoded, when the
+// dictionary grows past its limits or values repeat too little for it to
+// pay off.
+func (e *chunkEncoder) buildDict(group []*columnBatch, c int, k kind) bool {
+	e.idx = e.idx[:0]
+	e.dictVals = e.dictVals[:0]
+	e.dictData = e.dictData[:0]
+	e.dictLen = 0
+	if k.fixed() {
+		if e.fixedDict == nil {
+			e.fixedDict = make(map[uint64]int32)
+		}
+		for key := range e.fixedDict {
+			delete(e.fixedDict, key)
+		}
+	} else {
+		if e.bytesDict == nil {
+			e.bytesDict = make(map[string]int32)
+		}
+		for key := range e.bytesDict {
+			delete(e.bytesDict, key)
+		}
+	}
+
+	for _, cb := range group {
+		vec := &cb.vecs[c]
+		for i, ok := range vec.valid {
+			if !ok {
+				continue
+			}
+			var id int32
+			var found bool
+			if k.fixed() {
+				v := vec.fixed[i]
+				if id, found = e.fixedDict[v]; !found {
+					id = int32(e.dictLen)
+					e.fixedDict[v] = id
+					e.dictVals = append(e.dictVals, v)
+				}
+			} else {
+				s := vec.bytesAt(i)
+				if id, found = e.bytesDict[string(s)]; !found {
+					id = int32(e.dictLen)
+					e.bytesDict[string(s)] = id
+					e.dictData = binary.LittleEndian.AppendUint32(e.dictData, uint32(len(s)))
+					e.dictData = append(e.dictData, s...)
+				}
+			}
+			if !found {
+				e.dictLen++
+				if e.dictLen > maxDictEntries || len(e.dictData)+8*len(e.dictVals) > maxDictBytes {
+					return false
+				}
+			}
+			e.idx = append(e.idx, id)
+		}
+	}
+	return e.dictLen > 0 && 2*e.dictLen <= len(e.idx)
+}
+
+// appendPlain appends the non-NULL values of vec in PLAIN encoding
+func appendPlain(dst []byte, vec *vector, k kind) []byte {
+	for i, ok := range vec.valid {
+		if !ok {
+			continue
+		}
+		if k.fixed() {
+			dst = appendPlainFixed(dst, vec.fixed[i], k.width())
+		} else {
+			s := vec.bytesAt(i)
+			dst = binary.LittleEndian.AppendUint32(dst, uint32(len(s)))
+			dst = append(dst, s...)
+		}
+	}
+	return dst
+}
+
+func appendPlainFixed(dst []byte, v uint64, width int) []byte {
+	if width == 4 {
+		return binary.LittleEndian.AppendUint32(dst, uint32(v))
+	}
+	return binary.LittleEndian.AppendUint64(dst, v)
+}
+
+// appendHybrid appends vals in the RLE/bit-packing hybrid encoding with the
+// given bit width: runs of 8 or more equal values are run-length encoded,
+// everything else is bit-packed in groups of 8.
+func appendHybrid(dst []byte, vals []int32, width uint) []byte {
+	byteWidth := int(width+7) / 8
+	for i := 0; i < len(vals); {
+		if run := runLength(vals, i, len(vals)); run >= 8 {
+			dst = binary.AppendUvarint(dst, uint64(run)<<1)
+			for b := 0; b < byteWidth; b++ {
+				dst = append(dst, byte(uint32(vals[i])>>(8*b)))
+			}
+			i += run
+			continue
+		}
+
+		// Bit-pack groups of 8 until a run starts on a group boundary. Only
+		// the last group of the page may be padded.
+		start := i
+		i += 8
+		for i < len(vals) && runLength(vals, i, 8) < 8 {
+			i += 8
+		}
+		end := i
+		if end > len(vals) {
+			end = len(vals)
+		}
+		groups := (i - start) / 8
+		dst = binary.AppendUvarint(dst, uint64(groups)<<1|1)
+		var acc uint64
+		var n uint
+		for j := start; j < start+8*groups; j++ {
+			if j < end {
+				acc |= uint64(uint32(vals[j])) << n
+			}
+			n += width
+			for n >= 8 {
+				dst = append(dst, byte(acc))
+				acc >>= 8
+				n -= 8
+			}
+		}
+	}
+	return dst
+}
+
+// runLength returns the number of values equal to vals[i] starting at i,
+// counting at most max
+func runLength(vals []int32, i, max int) int {
+	n := 1
+	for i+n < len(vals) && n < max && vals[i+n] == vals[i] {
+		n++
+	}
+	return n
+}
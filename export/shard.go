@@ -0,0 +1,140 @@
+// shard.go - Export of a table as primary key range shards
+package export
+
+import (
+	"fmt"
+	"io"
+	"runtime"
+	"sync"
+	"sync/atomic"
+
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/page"
+	"github.com/wilhasse/go-innodb/record"
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// Shard reports one primary key range written by ExportShards
+type Shard struct {
+	Stats
+	FirstPage uint32 // first leaf page of the range, in key order
+	LastPage  uint32 // last leaf page of the range
+	// FirstKey is the primary key of the first record of the range as a
+	// JSON object (see Encoder.AppendObject), nil for an empty shard. A
+	// shard holds the keys from its FirstKey up to the next shard's.
+	FirstKey []byte
+}
+
+// ExportShards splits the table in r into len(ws) contiguous primary key
+// ranges and writes range i to ws[i] in opts.Format, all ranges at the
+// same time. Each output is complete on its own (header, Parquet footer)
+// and sorted by primary key.
+//
+// The ranges are cut from the leaf pages of the clustered index, listed in
+// key order by a descent from its root (see ExportTable), into runs of
+// equal page counts. Only the internal pages are read to plan them, so
+// shards hold about the same number of rows as long as their pages are
+// about as full. The workers are divided between the shards. A failing
+// shard, or a page that breaks the leaf chain (ErrBrokenIndex), stops the
+// others.
+func ExportShards(ws []io.Writer, r io.ReaderAt, size int64, td *schema.TableDef, opts Options) ([]Shard, error) {
+	if len(ws) == 0 {
+		return nil, fmt.Errorf("no shard outputs")
+	}
+	if opts.OnCheckpoint != nil || opts.Resume != nil {
+		return nil, fmt.Errorf("checkpoints are not supported for sharded exports")
+	}
+	workers := opts.Workers
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	workers = opts.Budget.FitWorkers(workers, workerBytes)
+	lr, err := leafLevel(r, size, td, opts, workers)
+	if err != nil {
+		return nil, err
+	}
+	defer opts.Budget.Release(4 * int64(len(lr.pages)))
+	ranges := lr.split(len(ws))
+
+	shards := make([]Shard, len(ws))
+	buf := make([]byte, format.PageSize)
+	for i, pr := range ranges {
+		if len(pr.pages) == 0 {
+			continue
+		}
+		shards[i].FirstPage, shards[i].LastPage = pr.pages[0], pr.pages[len(pr.pages)-1]
+		if shards[i].FirstKey, err = firstKey(r, td, pr.pages[0], buf); err != nil {
+			return shards, fmt.Errorf("shard %d: %w", i, err)
+		}
+	}
+
+	perShard := workers / len(ws)
+	if perShard < 1 {
+		perShard = 1
+	}
+	sr := &stoppableReader{r: r}
+	var (
+		wg       sync.WaitGroup
+		errOnce  sync.Once
+		firstErr error
+	)
+	for i := range ws {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			st, err := exportBatches(ws[i], sr, td, ranges[i], opts, perShard, size)
+			shards[i].Stats = st
+			if err != nil {
+				sr.stop.Store(true)
+				errOnce.Do(func() { firstErr = fmt.Errorf("shard %d: %w", i, err) })
+			}
+		}(i)
+	}
+	wg.Wait()
+	return shards, firstErr
+}
+
+// firstKey returns the primary key of the first user record of leaf page
+// pageNo as a JSON object, or nil if the page has no records
+func firstKey(r io.ReaderAt, td *schema.TableDef, pageNo uint32, buf []byte) ([]byte, error) {
+	if _, err := r.ReadAt(buf, int64(pageNo)*format.PageSize); err != nil {
+		return nil, err
+	}
+	v, err := page.NewView(buf)
+	if err != nil {
+		return nil, err
+	}
+	var (
+		rec    record.GenericRecord
+		recErr error
+		found  bool
+	)
+	parser := record.NewCompactParser(td)
+	err = v.ForEachRecord(true, func(pos int, hdr record.RecordHeader) bool {
+		recErr = parser.ParseRecordInto(&rec, buf, pos, true)
+		found = true
+		return false
+	})
+	if err == nil {
+		err = recErr
+	}
+	if err != nil || !found {
+		return nil, err
+	}
+	enc := Encoder{Format: NDJSON}
+	return enc.AppendObject(nil, td.PrimaryKeyColumns(), &rec)
+}
+
+// stoppableReader fails every read once stop is set, so the shards still
+// running wind down after one of them fails
+type stoppableReader struct {
+	r    io.ReaderAt
+	stop atomic.Bool
+}
+
+func (s *stoppableReader) ReadAt(p []byte, off int64) (int, error) {
+	if s.stop.Load() {
+		return 0, errAborted
+	}
+	return s.r.ReadAt(p, off)
+}
@@ -0,0 +1,597 @@
+// table.go - Parallel, ordered export of a whole table
+package export
+
+import (
+	"errors"
+	"fmt"
+	"io"
+	"runtime"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"github.com/wilhasse/go-innodb/charset"
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/record"
+	"github.com/wilhasse/go-innodb/scan"
+	"github.com/wilhasse/go-innodb/schema"
+)
+
+// batchPages is the number of leaf pages formatted into one output chunk
+const batchPages = 64
+
+// workerBytes is the memory each export worker holds, the page buffers of
+// two batches, used to fit the workers to Options.Budget
+const workerBytes = 2 * batchPages * format.PageSize
+
+// Options configures ExportTable
+type Options struct {
+	Format Format
+	Header bool // write a header line with the column names
+	// Conv converts the values of text columns to UTF-8 from its charset.
+	// When nil, those declared utf8mb4 or utf8 are validated and latin1
+	// ones converted (see Converters).
+	Conv *charset.Converter
+	// CharsetPolicy decides what happens to invalid UTF-8 in text columns
+	// validated without Conv: replaced by U+FFFD (the default) or failing
+	// the export
+	CharsetPolicy charset.Policy
+	// Workers is the number of formatting goroutines (0 means GOMAXPROCS)
+	Workers int
+	// IncludeDeleted also exports delete-marked records
+	IncludeDeleted bool
+	// IndexID selects the clustered index by its root in the first extent;
+	// 0 means the first root, which is the clustered index of file-per-table
+	// spaces
+	IndexID uint64
+	// RowGroupRows is the number of rows per Parquet row group or Arrow
+	// record batch (default 1M). Groups end on batch boundaries, so they
+	// can be a few thousand rows longer.
+	RowGroupRows int
+	// Codec compresses Parquet pages; column chunks are compressed in
+	// parallel. Other formats are compressed by wrapping w in a BlockWriter.
+	Codec Codec
+	// Level is the gzip level of Codec (0 means the default)
+	Level int
+	// OnCheckpoint, if set, is called with the progress of a text export
+	// after a batch has been written to w, at most every CheckpointEvery
+	// (default 10s) and once more at the end. It runs while no other write
+	// is in progress and should make the output durable before recording
+	// cp (see Checkpoint.Save); an error stops the export.
+	OnCheckpoint    func(cp *Checkpoint) error
+	CheckpointEvery time.Duration
+	// Resume continues a text export from a checkpoint: the batches it
+	// covers are skipped and no header is written. w must continue the
+	// output at byte cp.Bytes.
+	Resume *Checkpoint
+	// Budget, if set, bounds the memory of the export: the list of leaf
+	// pages, read buffers, batches in flight and row groups are charged to it,
+	// and workers wait while it is spent. Workers are reduced so that
+	// their read buffers take at most a quarter of it. The BlockWriter
+	// wrapping w should share it (see BlockOptions.Budget).
+	Budget *scan.Budget
+	// VerifyChecksums adds a stage failing the export on the first leaf
+	// page whose checksum does not match
+	VerifyChecksums bool
+	// StageWorkers fixes the goroutines of pipeline stages by name (read,
+	// checksum, parse, filter, encode or decode); the others share Workers
+	// and are tuned from their timings (see scan.RunPipeline)
+	StageWorkers map[string]int
+}
+
+// defaultRowGroupRows is the default of Options.RowGroupRows
+const defaultRowGroupRows = 1 << 20
+
+// maxGroupBytes ends a row group early when its decoded values grow past
+// it, bounding memory and keeping Arrow's 32-bit offsets in range
+const maxGroupBytes = 256 << 20
+
+// Stats reports what ExportTable wrote
+type Stats struct {
+	Pages  int
+	Rows   int64
+	Bytes  int64
+	Stages []scan.StageStats // time spent in each pipeline stage
+}
+
+// ExportTable writes every row of the table in r in opts.Format, in primary
+// key order. The leaf pages of the clustered index are listed by a descent
+// from its root and cut into batches of 64 pages. Batches go through a
+// pipeline of stages (read, checksum, parse, filter, encode; see
+// scan.RunPipeline)
+// that format them into large pooled buffers in parallel, and an ordered
+// writer emits the buffers in batch order. At most 4 batches per worker
+// are in flight, fewer when opts.Budget is spent. Columnar formats decode
+// batches into columns instead and write them in row groups.
+//
+// The export fails with ErrBrokenIndex on a page that does not belong
+// where the B-tree puts it, leaves included, rather than skip or guess
+// rows.
+func ExportTable(w io.Writer, r io.ReaderAt, size int64, td *schema.TableDef, opts Options) (Stats, error) {
+	workers := opts.Workers
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	workers = opts.Budget.FitWorkers(workers, workerBytes)
+
+	if (opts.OnCheckpoint != nil || opts.Resume != nil) && opts.Format.Columnar() {
+		return Stats{}, fmt.Errorf("checkpoints are not supported for %s output", opts.Format)
+	}
+
+	lr, err := leafLevel(r, size, td, opts, workers)
+	if err != nil {
+		return Stats{}, err
+	}
+	defer opts.Budget.Release(4 * int64(len(lr.pages)))
+	if cp := opts.Resume; cp != nil {
+		if err := cp.check(td, opts.Format, size, lr.batches()); err != nil {
+			return Stats{}, err
+		}
+		lr = lr.part(cp.Batches*batchPages, len(lr.pages))
+	}
+	return exportBatches(w, r, td, lr, opts, workers, size)
+}
+
+// runStages passes the batches of lr through the export pipeline: read,
+// checksum (with opts.VerifyChecksums), parse, which also checks the links
+// of the leaves, filter (unless opts.IncludeDeleted) and last, which
+// formats a batch into b.Value for ow. Batches are admitted in order
+// through the window and budget of ow.
+func runStages(r io.ReaderAt, lr leafRange, batches []scan.Chain, opts Options, workers int, ow *orderedWriter, last scan.Stage) ([]scan.StageStats, error) {
+	var stages []scan.Stage
+	if opts.VerifyChecksums {
+		stages = append(stages, scan.Stage{Name: "checksum", Run: scan.VerifyChecksums})
+	}
+	stages = append(stages, scan.Stage{Name: "parse", Run: func(b *scan.Batch) error {
+		if err := lr.checkLinks(b); err != nil {
+			return err
+		}
+		return scan.ParseRecords(b)
+	}})
+	if !opts.IncludeDeleted {
+		stages = append(stages, scan.Stage{Name: "filter", Run: scan.FilterDeleted})
+	}
+	stages = append(stages, last)
+	for i := range stages {
+		stages[i].Workers = opts.StageWorkers[stages[i].Name]
+	}
+
+	return scan.RunPipeline(r, batches, stages, scan.PipelineOptions{
+		ReadWorkers: opts.StageWorkers["read"],
+		Workers:     workers,
+		Budget:      opts.Budget,
+		Admit: func(seq int) error {
+			if err := ow.acquire(seq); err != nil {
+				return err
+			}
+			return ow.reserve(seq, batchBytes(batches[seq]))
+		},
+		OnError: ow.fail,
+	}, func(b *scan.Batch) error {
+		return ow.put(b.Seq, b.Value)
+	})
+}
+
+// exportBatches writes the rows of the leaves of lr, in order, in
+// opts.Format (size is the tablespace size, recorded in checkpoints)
+func exportBatches(w io.Writer, r io.ReaderAt, td *schema.TableDef, lr leafRange, opts Options, workers int, size int64) (Stats, error) {
+	st := Stats{Pages: len(lr.pages)}
+	batches := lr.batches()
+	if opts.Format.Columnar() {
+		return exportColumnar(w, r, td, lr, batches, opts, workers, st)
+	}
+
+	// cp tracks what has been written; it is only touched by emit, which
+	// is never called concurrently
+	cp := &Checkpoint{Table: td.Name, Format: opts.Format.String(), SourceSize: size}
+	if opts.Resume != nil {
+		*cp = *opts.Resume
+		st.Pages += cp.Pages
+	}
+	every := opts.CheckpointEvery
+	if every <= 0 {
+		every = defaultCheckpointEvery
+	}
+	lastCheckpoint := time.Now()
+
+	cw := &countingWriter{w: w, n: cp.Bytes}
+	ow := newOrderedWriter(4*workers, func(chunk interface{}) error {
+		c := chunk.(*textChunk)
+		_, err := cw.Write(*c.buf)
+		bufferPool.Put(c.buf)
+		if err != nil {
+			return err
+		}
+		cp.advance(batches, c, cw.n)
+		if opts.OnCheckpoint != nil && time.Since(lastCheckpoint) >= every {
+			lastCheckpoint = time.Now()
+			return opts.OnCheckpoint(cp)
+		}
+		return nil
+	})
+	ow.budget = opts.Budget
+	defer ow.release()
+	if opts.Header && opts.Resume == nil {
+		enc := Encoder{Format: opts.Format}
+		if _, err := cw.Write(enc.AppendHeader(nil, td.Columns)); err != nil {
+			return st, err
+		}
+	}
+
+	convs := Converters(td.Columns, opts.Conv, opts.CharsetPolicy)
+	kits := sync.Pool{New: func() interface{} {
+		k := &kit{parser: record.NewCompactParser(td)}
+		k.parser.SetZeroCopy(true)
+		k.enc = Encoder{Format: opts.Format, Convs: convs}
+		if opts.OnCheckpoint != nil {
+			k.keyCols = td.PrimaryKeyColumns()
+			k.keyEnc = Encoder{Format: NDJSON}
+		}
+		return k
+	}}
+	var rows int64
+	encode := func(b *scan.Batch) error {
+		k := kits.Get().(*kit)
+		defer kits.Put(k)
+		k.buf = getBuffer()
+		err := k.appendRecords(b, td.Columns)
+		atomic.AddInt64(&rows, int64(k.rows))
+		if err != nil {
+			bufferPool.Put(k.buf)
+			k.buf, k.rows = nil, 0
+			return err
+		}
+		c := k.finish(b.Seq)
+		// Account for a buffer that grew past the reservation
+		ow.grow(b.Seq, int64(cap(*c.buf))-batchBytes(batches[b.Seq]))
+		b.Value = c
+		return nil
+	}
+
+	var err error
+	st.Stages, err = runStages(r, lr, batches, opts, workers, ow, scan.Stage{Name: "encode", Run: encode})
+	st.Rows = atomic.LoadInt64(&rows)
+	st.Bytes = cw.n
+	if opts.Resume != nil {
+		st.Rows += opts.Resume.Rows
+	}
+	if err == nil {
+		err = ow.err
+	}
+	if err == nil && opts.OnCheckpoint != nil {
+		cp.Done = true
+		err = opts.OnCheckpoint(cp)
+	}
+	return st, err
+}
+
+// exportColumnar is ExportTable for the columnar formats
+func exportColumnar(w io.Writer, r io.ReaderAt, td *schema.TableDef, lr leafRange, batches []scan.Chain, opts Options, workers int, st Stats) (Stats, error) {
+	kinds := make([]kind, len(td.Columns))
+	for i, col := range td.Columns {
+		kinds[i] = columnKind(col)
+	}
+	cw := &countingWriter{w: w}
+	var (
+		sink columnSink
+		err  error
+	)
+	if opts.Format == Parquet {
+		sink, err = newParquetWriter(cw, td.Columns, kinds, opts.Codec, opts.Level, workers)
+	} else {
+		sink, err = newArrowWriter(cw, td.Columns, kinds, opts.Format == ArrowFile)
+	}
+	if err != nil {
+		return st, err
+	}
+	groupRows := opts.RowGroupRows
+	if groupRows <= 0 {
+		groupRows = defaultRowGroupRows
+	}
+	// A row group is held until written, and encoding it takes about as
+	// much again, so groups are kept to an eighth of the budget
+	groupBytes := maxGroupBytes
+	if limit := opts.Budget.Limit(); limit > 0 && limit/8 < int64(groupBytes) {
+		groupBytes = int(limit / 8)
+	}
+
+	// Batches arrive in order and collect into the current row group
+	var (
+		group     []*columnBatch
+		rowsIn    int
+		bytesIn   int
+		batchPool = sync.Pool{New: func() interface{} { return new(columnBatch) }}
+	)
+	flush := func() error {
+		if len(group) == 0 {
+			return nil
+		}
+		opts.Budget.Charge(int64(bytesIn))
+		err := sink.writeGroup(group)
+		opts.Budget.Release(2 * int64(bytesIn))
+		for _, cb := range group {
+			batchPool.Put(cb)
+		}
+		group, rowsIn, bytesIn = group[:0], 0, 0
+		return err
+	}
+	ow := newOrderedWriter(4*workers, func(chunk interface{}) error {
+		cb := chunk.(*columnBatch)
+		if cb.rows == 0 {
+			batchPool.Put(cb)
+			return nil
+		}
+		// The batch's reservation is released once emit returns; the row
+		// group holds its decoded size instead until it is written
+		group = append(group, cb)
+		rowsIn += cb.rows
+		bytesIn += cb.memBytes()
+		opts.Budget.Charge(int64(cb.memBytes()))
+		if rowsIn >= groupRows || bytesIn >= groupBytes {
+			return flush()
+		}
+		return nil
+	})
+	ow.budget = opts.Budget
+	defer ow.release()
+	// A failed export drops the row group it was collecting
+	defer func() { opts.Budget.Release(int64(bytesIn)) }()
+
+	convs := Converters(td.Columns, opts.Conv, opts.CharsetPolicy)
+	decoders := sync.Pool{New: func() interface{} {
+		return newColumnDecoder(td, kinds, Encoder{Format: rawText}, convs)
+	}}
+	var rows int64
+	decode := func(b *scan.Batch) error {
+		dec := decoders.Get().(*columnDecoder)
+		defer decoders.Put(dec)
+		cb := batchPool.Get().(*columnBatch)
+		cb.reset(kinds)
+		n, err := dec.appendBatch(cb, b)
+		atomic.AddInt64(&rows, int64(n))
+		if err != nil {
+			batchPool.Put(cb)
+			return err
+		}
+		b.Value = cb
+		return nil
+	}
+
+	st.Stages, err = runStages(r, lr, batches, opts, workers, ow, scan.Stage{Name: "decode", Run: decode})
+	if err == nil {
+		err = ow.err
+	}
+	if err == nil {
+		err = flush()
+	}
+	if err == nil {
+		err = sink.close()
+	}
+	st.Rows = atomic.LoadInt64(&rows)
+	st.Bytes = cw.n
+	return st, err
+}
+
+// columnSink writes the row groups of a columnar export
+type columnSink interface {
+	writeGroup(group []*columnBatch) error
+	close() error
+}
+
+// appendBatches cuts pages into batches of up to batchPages pages
+func appendBatches(batches []scan.Chain, indexID uint64, pages []uint32) []scan.Chain {
+	for s := 0; s < len(pages); s += batchPages {
+		e := s + batchPages
+		if e > len(pages) {
+			e = len(pages)
+		}
+		batches = append(batches, scan.Chain{IndexID: indexID, Pages: pages[s:e]})
+	}
+	return batches
+}
+
+// batchBytes is the memory reserved for the output of a batch: formatted
+// text and decoded columns are about the size of the pages they come from
+func batchBytes(b scan.Chain) int64 {
+	return int64(len(b.Pages)) * format.PageSize
+}
+
+// kit is the per-batch decoding state, recycled between batches
+type kit struct {
+	parser *record.CompactParser
+	enc    Encoder
+	rec    record.GenericRecord
+	buf    *[]byte
+	rows   int
+
+	// With checkpoints, the primary key of the batch's last row is kept
+	keyCols []*schema.Column
+	keyEnc  Encoder
+}
+
+// textChunk is the formatted output of one batch
+type textChunk struct {
+	seq     int
+	buf     *[]byte
+	rows    int
+	lastKey []byte // JSON primary key of the last row, nil if not kept
+}
+
+// finish hands over the output of batch seq. It runs on the batch's last
+// page, while k.rec still refers to valid page data.
+func (k *kit) finish(seq int) *textChunk {
+	c := &textChunk{seq: seq, buf: k.buf, rows: k.rows}
+	if k.keyCols != nil && k.rows > 0 {
+		c.lastKey, _ = k.keyEnc.AppendObject(nil, k.keyCols, &k.rec)
+	}
+	k.buf, k.rows = nil, 0
+	return c
+}
+
+// appendRecords formats the records listed in b into k.buf
+func (k *kit) appendRecords(b *scan.Batch, cols []*schema.Column) error {
+	for _, ref := range b.Records {
+		if err := k.parser.ParseRecordInto(&k.rec, b.Page(ref.Page), ref.Pos, true); err != nil {
+			return err
+		}
+		var err error
+		if *k.buf, err = k.enc.AppendRecord(*k.buf, cols, &k.rec); err != nil {
+			return err
+		}
+		k.rows++
+	}
+	return nil
+}
+
+// bufferPool recycles output chunks; each grows to the size of a batch
+var bufferPool = sync.Pool{New: func() interface{} {
+	b := make([]byte, 0, 1<<20)
+	return &b
+}}
+
+func getBuffer() *[]byte {
+	b := bufferPool.Get().(*[]byte)
+	*b = (*b)[:0]
+	return b
+}
+
+var errAborted = errors.New("export aborted")
+
+// orderedWriter emits chunks numbered 0, 1, 2, ... in order, whatever the
+// order they complete in. The goroutine that completes the next chunk emits
+// it (and any chunks queued behind it) while others keep formatting; emit is
+// never called concurrently.
+//
+// With a budget, chunks also reserve memory before they are produced. The
+// reservation of a chunk is released once it has been emitted, so only the
+// chunk to be written next may go over the budget: waiting for it would
+// wait for memory only its emission can free.
+type orderedWriter struct {
+	emit    func(chunk interface{}) error
+	window  int
+	mu      sync.Mutex
+	cond    *sync.Cond
+	next    int
+	pending map[int]interface{}
+	writing bool
+	err     error
+
+	budget *scan.Budget
+	held   map[int]int64 // bytes reserved by unemitted chunks
+}
+
+func newOrderedWriter(window int, emit func(chunk interface{}) error) *orderedWriter {
+	o := &orderedWriter{emit: emit, window: window, pending: map[int]interface{}{}, held: map[int]int64{}}
+	o.cond = sync.NewCond(&o.mu)
+	return o
+}
+
+// acquire blocks until chunk seq is within the window of unwritten chunks,
+// bounding the memory held by chunks waiting for their turn
+func (o *orderedWriter) acquire(seq int) error {
+	o.mu.Lock()
+	defer o.mu.Unlock()
+	for seq >= o.next+o.window && o.err == nil {
+		o.cond.Wait()
+	}
+	return o.err
+}
+
+// reserve acquires n bytes of the budget for chunk seq, waiting while it
+// is spent unless seq is the next chunk to be written
+func (o *orderedWriter) reserve(seq int, n int64) error {
+	if o.budget == nil {
+		return nil
+	}
+	// The budget calls this with its lock held; the writer never holds its
+	// own lock while calling the budget
+	o.budget.Acquire(n, func() bool {
+		o.mu.Lock()
+		defer o.mu.Unlock()
+		return seq <= o.next || o.err != nil
+	})
+	o.mu.Lock()
+	o.held[seq] += n
+	err := o.err
+	o.mu.Unlock()
+	return err
+}
+
+// grow charges n more bytes to chunk seq without waiting, for memory that
+// has already been allocated
+func (o *orderedWriter) grow(seq int, n int64) {
+	if o.budget == nil || n <= 0 {
+		return
+	}
+	o.budget.Charge(n)
+	o.mu.Lock()
+	o.held[seq] += n
+	o.mu.Unlock()
+}
+
+// release returns the reservations of chunks that were never emitted
+func (o *orderedWriter) release() {
+	var n int64
+	o.mu.Lock()
+	for seq, h := range o.held {
+		n += h
+		delete(o.held, seq)
+	}
+	o.mu.Unlock()
+	if n > 0 {
+		o.budget.Release(n)
+	}
+}
+
+// put queues chunk seq and emits every chunk that is now in order
+func (o *orderedWriter) put(seq int, chunk interface{}) error {
+	o.mu.Lock()
+	o.pending[seq] = chunk
+	if o.writing {
+		err := o.err
+		o.mu.Unlock()
+		return err
+	}
+	o.writing = true
+	for o.err == nil {
+		b, ok := o.pending[o.next]
+		if !ok {
+			break
+		}
+		delete(o.pending, o.next)
+		o.mu.Unlock()
+		err := o.emit(b)
+		o.mu.Lock()
+		if err != nil {
+			o.err = err
+		}
+		held := o.held[o.next]
+		delete(o.held, o.next)
+		o.next++
+		o.cond.Broadcast()
+		if o.budget != nil {
+			// Also lets the chunk that is now next stop waiting
+			o.mu.Unlock()
+			o.budget.Release(held)
+			o.mu.Lock()
+		}
+	}
+	o.writing = false
+	err := o.err
+	o.mu.Unlock()
+	return err
+}
+
+// fail stops the writer; waiting and later calls return err
+func (o *orderedWriter) fail(err error) {
+	if err == nil {
+		err = errAborted
+	}
+	o.mu.Lock()
+	if o.err == nil {
+		o.err = err
+	}
+	o.cond.Broadcast()
+	o.mu.Unlock()
+	o.budget.Wake()
+}
@@ -42,6 +42,7 @@ type (
 	FilHeader  = page.FilHeader
 	FilTrailer = page.FilTrailer
 	FsegHeader = page.FsegHeader
+	PageView   = page.View
 )
 
 // Re-export functions from page package
@@ -51,6 +52,7 @@ var (
 	ParseFilHeader  = page.ParseFilHeader
 	ParseFilTrailer = page.ParseFilTrailer
 	ParseFsegHeader = page.ParseFsegHeader
+	NewPageView     = page.NewView
 )
 
 // Re-export types from record package
@@ -58,14 +60,19 @@ type (
 	RecordHeader  = record.RecordHeader
 	IndexHeader   = record.IndexHeader
 	GenericRecord = record.GenericRecord
+	Cursor        = record.Cursor
 )
 
 // Re-export functions from record package
 var (
 	ParseRecordHeader = record.ParseRecordHeader
 	ParseIndexHeader  = record.ParseIndexHeader
+	ForEachRecord     = record.ForEachRecord
 )
 
+// ErrCorruptRecordChain is returned when a page's record chain is invalid
+var ErrCorruptRecordChain = record.ErrCorruptRecordChain
+
 // WalkRecords is a convenience function to walk records on an IndexPage
 func WalkRecords(p *IndexPage, max int, skipSystem bool) ([]record.GenericRecord, error) {
 	return p.WalkRecords(max, skipSystem)
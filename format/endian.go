@@ -24,3 +24,37 @@ func Be64(b []byte, off int) (uint64, error) {
 	}
 	return binary.BigEndian.Uint64(b[off : off+8]), nil
 }
+
+// Unchecked readers for buffers whose size has already been validated, e.g.
+// a page checked once against PageSize or a header sliced to its exact size.
+// They return no error and are small enough to inline, so reads at constant
+// offsets of a validated slice or page array compile to plain loads with no
+// bounds checks. An out-of-range offset panics instead of failing softly.
+
+// U16 reads a big-endian uint16 at off
+func U16(b []byte, off int) uint16 { return binary.BigEndian.Uint16(b[off:]) }
+
+// U32 reads a big-endian uint32 at off
+func U32(b []byte, off int) uint32 { return binary.BigEndian.Uint32(b[off:]) }
+
+// U64 reads a big-endian uint64 at off
+func U64(b []byte, off int) uint64 { return binary.BigEndian.Uint64(b[off:]) }
+
+// PageArray validates the size of a page buffer once and returns it as a
+// fixed-size array, on which constant-offset reads need no bounds checks.
+func PageArray(b []byte) (*[PageSize]byte, error) {
+	if len(b) < PageSize {
+		return nil, ErrShortRead
+	}
+	return (*[PageSize]byte)(b[:PageSize]), nil
+}
+
+// UN reads an n-byte (1-8) big-endian unsigned integer at off
+func UN(b []byte, off, n int) uint64 {
+	b = b[off : off+n]
+	var v uint64
+	for _, c := range b {
+		v = v<<8 | uint64(c)
+	}
+	return v
+}
@@ -10,13 +10,19 @@
 #include "innodb_decompress.h"
 
 // Version string
-#define INNODB_DECOMPRESS_VERSION "3.0.0"
+#define INNODB_DECOMPRESS_VERSION "3.1.0"
 
 // InnoDB page constants (from fil0fil.h)
 #define FIL_PAGE_OFFSET 4
+#define FIL_PAGE_PREV 8
+#define FIL_PAGE_NEXT 12
+#define FIL_PAGE_LSN 16
 #define FIL_PAGE_TYPE 24
 #define FIL_PAGE_DATA 38
 #define FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID 34
+#define PAGE_HEADER FIL_PAGE_DATA
+#define PAGE_LEVEL 26
+#define PAGE_INDEX_ID 28
 #define FIL_PAGE_INDEX 17855
 #define FIL_PAGE_COMPRESSED 14
 #define FIL_PAGE_COMPRESSED_AND_ENCRYPTED 16
@@ -58,34 +64,144 @@ static inline uint32_t mach_read_from_4(const unsigned char* ptr) {
     return (uint32_t)(ptr[0] << 24 | ptr[1] << 16 | ptr[2] << 8 | ptr[3]);
 }
 
+// Fixed-width big-endian loads for the bulk header pass: one unaligned load
+// plus a byte swap, with no per-byte shifts
+template <typename T> static inline T load_be(const unsigned char* ptr);
+template <> inline uint16_t load_be<uint16_t>(const unsigned char* ptr) {
+    uint16_t v; memcpy(&v, ptr, sizeof(v)); return __builtin_bswap16(v);
+}
+template <> inline uint32_t load_be<uint32_t>(const unsigned char* ptr) {
+    uint32_t v; memcpy(&v, ptr, sizeof(v)); return __builtin_bswap32(v);
+}
+template <> inline uint64_t load_be<uint64_t>(const unsigned char* ptr) {
+    uint64_t v; memcpy(&v, ptr, sizeof(v)); return __builtin_bswap64(v);
+}
+
 // Initialize page_zip_des_t structure
 static void page_zip_des_init(page_zip_des_t* page_zip) {
     memset(page_zip, 0, sizeof(page_zip_des_t));
 }
 
-// Convert page size to shift size (ssize)
+// Static helper: Validate that compressed size is valid
+static bool is_valid_compressed_size(size_t size) {
+    return (size == 1024 || size == 2048 || size == 4096 || size == 8192);
+}
+
+// Per-KEY_BLOCK_SIZE traits: shift size (ssize) of each physical page size
 // Based on percona-parser's working implementation
-static uint8_t page_size_to_ssize(size_t physical_size) {
-    switch(physical_size) {
-        case 1024:  return 1;  // 2^10 = 1KB
-        case 2048:  return 2;  // 2^11 = 2KB
-        case 4096:  return 3;  // 2^12 = 4KB
-        case 8192:  return 4;  // 2^13 = 8KB
-        case 16384: return 0;  // Uncompressed
-        default:    return 0;
+template <size_t PhysicalSize> struct zip_traits;
+template <> struct zip_traits<1024> { static const uint8_t ssize = 1; };  // 2^10 = 1KB
+template <> struct zip_traits<2048> { static const uint8_t ssize = 2; };  // 2^11 = 2KB
+template <> struct zip_traits<4096> { static const uint8_t ssize = 3; };  // 2^12 = 4KB
+template <> struct zip_traits<8192> { static const uint8_t ssize = 4; };  // 2^13 = 8KB
+
+// Scratch page for page_zip_decompress_low, which needs a page-aligned
+// destination. One per thread, so no allocation happens per page.
+alignas(UNIV_PAGE_SIZE) static thread_local unsigned char tls_scratch[UNIV_PAGE_SIZE];
+
+// A page path specialized on physical size and page type. Sizes are
+// compile-time constants, so the copies and fills below are fixed-length.
+typedef int (*page_fn)(const unsigned char* in, unsigned char* scratch,
+                       unsigned char* out, size_t* bytes_written);
+
+// INDEX pages: inflate into the aligned scratch page, then copy out 16KB
+template <size_t PhysicalSize>
+static int decompress_index_page(const unsigned char* in, unsigned char* scratch,
+                                 unsigned char* out, size_t* bytes_written) {
+    memset(scratch, 0, UNIV_PAGE_SIZE);
+
+    // Setup page_zip descriptor (following percona-parser exactly)
+    page_zip_des_t page_zip;
+    page_zip_des_init(&page_zip);
+    page_zip.data = reinterpret_cast<page_zip_t*>(const_cast<unsigned char*>(in));
+    page_zip.ssize = zip_traits<PhysicalSize>::ssize;
+
+    if (!page_zip_decompress_low(&page_zip, scratch, true)) {
+        return INNODB_DECOMPRESS_ERROR_DECOMPRESS_FAILED;
     }
+
+    memcpy(out, scratch, UNIV_PAGE_SIZE);
+    *bytes_written = UNIV_PAGE_SIZE;
+    return INNODB_DECOMPRESS_SUCCESS;
 }
 
-// Align pointer to boundary
-static inline void* ut_align(void* ptr, size_t align) {
-    return (void*)(((uintptr_t)ptr + (align - 1)) & ~(align - 1));
+// Other page types are stored uncompressed: copy the physical page as is
+template <size_t PhysicalSize>
+static int copy_page(const unsigned char* in, unsigned char*,
+                     unsigned char* out, size_t* bytes_written) {
+    memcpy(out, in, PhysicalSize);
+    *bytes_written = PhysicalSize;
+    return INNODB_DECOMPRESS_SUCCESS;
 }
 
-// Static helper: Validate that compressed size is valid
-static bool is_valid_compressed_size(size_t size) {
-    return (size == 1024 || size == 2048 || size == 4096 || size == 8192);
+// Dispatch table for one physical page size, indexed by "is INDEX page"
+struct zip_dispatch {
+    size_t  physical_size;
+    page_fn by_type[2];
+};
+
+static const zip_dispatch zip_dispatch_table[] = {
+    {1024, {copy_page<1024>, decompress_index_page<1024>}},
+    {2048, {copy_page<2048>, decompress_index_page<2048>}},
+    {4096, {copy_page<4096>, decompress_index_page<4096>}},
+    {8192, {copy_page<8192>, decompress_index_page<8192>}},
+};
+
+// Select the dispatch table for a physical page size, NULL if not a valid
+// KEY_BLOCK_SIZE
+static const zip_dispatch* zip_dispatch_for(size_t physical_size) {
+    for (size_t i = 0; i < sizeof(zip_dispatch_table) / sizeof(zip_dispatch_table[0]); i++) {
+        if (zip_dispatch_table[i].physical_size == physical_size) {
+            return &zip_dispatch_table[i];
+        }
+    }
+    return NULL;
+}
+
+static inline int dispatch_page(const zip_dispatch* d, const unsigned char* in,
+                                unsigned char* scratch, unsigned char* out,
+                                size_t* bytes_written) {
+    bool is_index = mach_read_from_2(in + FIL_PAGE_TYPE) == FIL_PAGE_INDEX;
+    return d->by_type[is_index](in, scratch, out, bytes_written);
+}
+
+// Store one header field of a page if its column was requested
+template <size_t Offset, typename T>
+static inline void store_field(const unsigned char* page, T* __restrict out, size_t i) {
+    if (out) {
+        out[i] = load_be<T>(page + Offset);
+    }
+}
+
+// Header columns of pages of one physical size. The pages are walked once
+// with a compile-time stride and all fields of a page are taken while its
+// first cache lines are resident; the next headers are prefetched ahead.
+template <size_t Stride>
+static void extract_pages_info(const unsigned char* pages, size_t n_pages,
+                               const innodb_pages_info_soa_t* out) {
+    const size_t prefetch_distance = 8;
+    const unsigned char* p = pages;
+    for (size_t i = 0; i < n_pages; i++, p += Stride) {
+        if (i + prefetch_distance < n_pages) {
+            __builtin_prefetch(p + prefetch_distance * Stride);
+            __builtin_prefetch(p + prefetch_distance * Stride + 64);
+        }
+        store_field<FIL_PAGE_OFFSET>(p, out->page_number, i);
+        store_field<FIL_PAGE_TYPE>(p, out->page_type, i);
+        store_field<FIL_PAGE_ARCH_LOG_NO_OR_SPACE_ID>(p, out->space_id, i);
+        store_field<FIL_PAGE_LSN>(p, out->lsn, i);
+        store_field<FIL_PAGE_PREV>(p, out->prev, i);
+        store_field<FIL_PAGE_NEXT>(p, out->next, i);
+        store_field<PAGE_HEADER + PAGE_LEVEL>(p, out->level, i);
+        store_field<PAGE_HEADER + PAGE_INDEX_ID>(p, out->index_id, i);
+    }
 }
 
+// Tablespace handle: the dispatch table is chosen once, at creation
+struct innodb_decompressor {
+    const zip_dispatch* dispatch;
+};
+
 // Static helper: Detect if page is likely compressed
 static bool detect_compressed_page(const unsigned char* data, size_t size) {
     // If size is less than 16KB, it's likely compressed
@@ -132,6 +248,23 @@ extern "C" int innodb_get_page_info(const unsigned char* page_data, size_t page_
     return INNODB_DECOMPRESS_SUCCESS;
 }
 
+extern "C" int innodb_get_pages_info_soa(const unsigned char* pages, size_t n_pages,
+                                         size_t page_size, innodb_pages_info_soa_t* out) {
+    if (!pages || !out) {
+        return INNODB_DECOMPRESS_ERROR_INVALID_SIZE;
+    }
+    
+    switch (page_size) {
+        case 1024:  extract_pages_info<1024>(pages, n_pages, out); break;
+        case 2048:  extract_pages_info<2048>(pages, n_pages, out); break;
+        case 4096:  extract_pages_info<4096>(pages, n_pages, out); break;
+        case 8192:  extract_pages_info<8192>(pages, n_pages, out); break;
+        case 16384: extract_pages_info<16384>(pages, n_pages, out); break;
+        default:    return INNODB_DECOMPRESS_ERROR_INVALID_SIZE;
+    }
+    return INNODB_DECOMPRESS_SUCCESS;
+}
+
 extern "C" int innodb_decompress_page(
     const unsigned char* compressed_data,
     size_t compressed_size,
@@ -147,59 +280,12 @@ extern "C" int innodb_decompress_page(
         return INNODB_DECOMPRESS_ERROR_BUFFER_TOO_SMALL;
     }
     
-    if (!is_valid_compressed_size(compressed_size)) {
+    const zip_dispatch* d = zip_dispatch_for(compressed_size);
+    if (!d) {
         return INNODB_DECOMPRESS_ERROR_INVALID_SIZE;
     }
     
-    if (compressed_size < FIL_PAGE_TYPE + 2) {
-        return INNODB_DECOMPRESS_ERROR_INVALID_PAGE;
-    }
-    
-    uint16_t page_type = mach_read_from_2(compressed_data + FIL_PAGE_TYPE);
-    
-    // Only INDEX pages use zip decompression
-    if (page_type != FIL_PAGE_INDEX) {
-        // For non-index pages, just copy
-        size_t copy_size = std::min(compressed_size, output_size);
-        memcpy(output_buffer, compressed_data, copy_size);
-        *bytes_written = copy_size;
-        return INNODB_DECOMPRESS_SUCCESS;
-    }
-    
-    // Allocate aligned temporary buffer (following percona-parser pattern)
-    size_t alloc_size = 2 * UNIV_PAGE_SIZE;
-    unsigned char* temp = (unsigned char*)malloc(alloc_size);
-    if (!temp) {
-        return INNODB_DECOMPRESS_ERROR_BUFFER_TOO_SMALL;
-    }
-    
-    unsigned char* aligned_temp = (unsigned char*)ut_align(temp, UNIV_PAGE_SIZE);
-    memset(aligned_temp, 0, UNIV_PAGE_SIZE);
-    
-    // Setup page_zip descriptor (following percona-parser exactly)
-    page_zip_des_t page_zip;
-    page_zip_des_init(&page_zip);
-    
-    // Set compressed data pointer (cast as in percona-parser)
-    page_zip.data = reinterpret_cast<page_zip_t*>(const_cast<unsigned char*>(compressed_data));
-    
-    // Set the shift size (critical for decompression to work)
-    page_zip.ssize = page_size_to_ssize(compressed_size);
-    
-    // Attempt decompression
-    bool success = page_zip_decompress_low(&page_zip, aligned_temp, true);
-    
-    if (!success) {
-        free(temp);
-        return INNODB_DECOMPRESS_ERROR_DECOMPRESS_FAILED;
-    }
-    
-    // Copy decompressed data to output
-    memcpy(output_buffer, aligned_temp, UNIV_PAGE_SIZE);
-    *bytes_written = UNIV_PAGE_SIZE;
-    
-    free(temp);
-    return INNODB_DECOMPRESS_SUCCESS;
+    return dispatch_page(d, compressed_data, tls_scratch, output_buffer, bytes_written);
 }
 
 extern "C" int innodb_process_page(
@@ -230,6 +316,64 @@ extern "C" int innodb_process_page(
                                   output_size, bytes_written);
 }
 
+extern "C" innodb_decompressor_t* innodb_decompressor_new(size_t physical_size) {
+    const zip_dispatch* d = zip_dispatch_for(physical_size);
+    if (!d) {
+        return NULL;
+    }
+    innodb_decompressor_t* h = (innodb_decompressor_t*)malloc(sizeof(innodb_decompressor_t));
+    if (h) {
+        h->dispatch = d;
+    }
+    return h;
+}
+
+extern "C" void innodb_decompressor_free(innodb_decompressor_t* h) {
+    free(h);
+}
+
+extern "C" int innodb_decompressor_page(
+    innodb_decompressor_t* h,
+    const unsigned char* compressed_data,
+    unsigned char* output_buffer,
+    size_t* bytes_written)
+{
+    if (!h || !compressed_data || !output_buffer || !bytes_written) {
+        return INNODB_DECOMPRESS_ERROR_INVALID_SIZE;
+    }
+    return dispatch_page(h->dispatch, compressed_data, tls_scratch, output_buffer, bytes_written);
+}
+
+extern "C" int innodb_decompressor_pages(
+    innodb_decompressor_t* h,
+    const unsigned char* compressed_data,
+    size_t n_pages,
+    unsigned char* output_buffer,
+    size_t* pages_done)
+{
+    if (!h || !compressed_data || !output_buffer || !pages_done) {
+        return INNODB_DECOMPRESS_ERROR_INVALID_SIZE;
+    }
+    
+    const zip_dispatch* d = h->dispatch;
+    const size_t physical_size = d->physical_size;
+    unsigned char* scratch = tls_scratch;
+    
+    *pages_done = 0;
+    for (size_t i = 0; i < n_pages; i++) {
+        unsigned char* out = output_buffer + i * UNIV_PAGE_SIZE;
+        size_t written = 0;
+        int rc = dispatch_page(d, compressed_data + i * physical_size, scratch, out, &written);
+        if (rc != INNODB_DECOMPRESS_SUCCESS) {
+            return rc;
+        }
+        // Every output slot is a full page: zero the tail of copied pages
+        memset(out + written, 0, UNIV_PAGE_SIZE - written);
+        *pages_done = i + 1;
+    }
+    return INNODB_DECOMPRESS_SUCCESS;
+}
+
 extern "C" const char* innodb_decompress_error_string(int error_code) {
     switch (error_code) {
         case INNODB_DECOMPRESS_SUCCESS:
@@ -0,0 +1,37 @@
+// checksum.go - Page checksum verification
+package page
+
+import (
+	"hash/crc32"
+
+	"github.com/wilhasse/go-innodb/format"
+)
+
+// checksumNone is stored in both checksum fields when
+// innodb_checksum_algorithm=none
+const checksumNone = 0xDEADBEEF
+
+var castagnoli = crc32.MakeTable(crc32.Castagnoli)
+
+// ChecksumCRC32C returns the crc32 page checksum (innodb_checksum_algorithm
+// crc32, the MySQL 5.7+ default): CRC-32C of the FIL header after the
+// checksum field up to FLUSH_LSN, xored with that of the body before the
+// trailer
+func (v View) ChecksumCRC32C() uint32 {
+	return crc32.Checksum(v.b[4:26], castagnoli) ^
+		crc32.Checksum(v.b[format.FilHeaderSize:trailerOff], castagnoli)
+}
+
+// ChecksumValid reports whether the stored checksums match the crc32
+// algorithm or the "none" marker. Pages written with the legacy innodb
+// algorithm are reported as invalid.
+func (v View) ChecksumValid() bool {
+	stored, trailer := v.Checksum(), v.TrailerChecksum()
+	if stored == checksumNone && trailer == checksumNone {
+		return true
+	}
+	if stored != trailer {
+		return false
+	}
+	return stored == v.ChecksumCRC32C()
+}
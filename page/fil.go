@@ -20,28 +20,38 @@ type FilHeader struct {
 }
 
 func ParseFilHeader(p []byte) (FilHeader, error) {
-	if len(p) < format.PageSize {
-		return FilHeader{}, fmt.Errorf("short page: %d", len(p))
+	var fh FilHeader
+	if err := parseFilHeader(p, &fh, new(uint32), new(uint32)); err != nil {
+		return FilHeader{}, err
 	}
-	chk, _ := format.Be32(p, 0)
-	pg, _ := format.Be32(p, 4)
-	prev, _ := format.Be32(p, 8)
-	next, _ := format.Be32(p, 12)
-	lsn, _ := format.Be64(p, 16)
-	pt, _ := format.Be16(p, 24)
-	flush, _ := format.Be64(p, 26)
-	space, _ := format.Be32(p, 34)
-	var prevPtr, nextPtr *uint32
-	if prev != filNull {
-		prevPtr = &prev
+	return fh, nil
+}
+
+// parseFilHeader parses into fh, storing the Prev/Next values in the
+// caller-provided prev and next
+func parseFilHeader(p []byte, fh *FilHeader, prev, next *uint32) error {
+	pa, err := format.PageArray(p)
+	if err != nil {
+		return fmt.Errorf("short page: %d", len(p))
+	}
+	h := pa[:format.FilHeaderSize]
+	*prev = format.U32(h, 8)
+	*next = format.U32(h, 12)
+	*fh = FilHeader{
+		Checksum:   format.U32(h, 0),
+		PageNumber: format.U32(h, 4),
+		LastModLSN: format.U64(h, 16),
+		PageType:   format.PageType(format.U16(h, 24)),
+		FlushLSN:   format.U64(h, 26),
+		SpaceID:    format.U32(h, 34),
+	}
+	if *prev != filNull {
+		fh.Prev = prev
 	}
-	if next != filNull {
-		nextPtr = &next
+	if *next != filNull {
+		fh.Next = next
 	}
-	return FilHeader{
-		Checksum: chk, PageNumber: pg, Prev: prevPtr, Next: nextPtr,
-		LastModLSN: lsn, PageType: format.PageType(pt), FlushLSN: flush, SpaceID: space,
-	}, nil
+	return nil
 }
 
 type FilTrailer struct {
@@ -50,11 +60,12 @@ type FilTrailer struct {
 }
 
 func ParseFilTrailer(p []byte) (FilTrailer, error) {
-	if len(p) < format.FilTrailerSize {
+	pa, err := format.PageArray(p)
+	if err != nil {
 		return FilTrailer{}, fmt.Errorf("short trailer")
 	}
-	off := format.PageSize - format.FilTrailerSize
-	chk, _ := format.Be32(p, off+0)
-	lsn, _ := format.Be32(p, off+4)
+	t := pa[format.PageSize-format.FilTrailerSize:]
+	chk := format.U32(t, 0)
+	lsn := format.U32(t, 4)
 	return FilTrailer{Checksum: chk, Low32LSN: lsn}, nil
 }
@@ -17,15 +17,16 @@ type FsegHeader struct {
 }
 
 func ParseFsegHeader(p []byte, off int) (FsegHeader, error) {
-	if off+20 > len(p) {
+	if off < 0 || off+20 > len(p) {
 		return FsegHeader{}, fmt.Errorf("short fseg header")
 	}
-	lsp, _ := format.Be32(p, off+0)
-	lpg, _ := format.Be32(p, off+4)
-	lof, _ := format.Be16(p, off+8)
-	nsp, _ := format.Be32(p, off+10)
-	npg, _ := format.Be32(p, off+14)
-	nof, _ := format.Be16(p, off+18)
+	h := p[off:][:20]
+	lsp := format.U32(h, 0)
+	lpg := format.U32(h, 4)
+	lof := format.U16(h, 8)
+	nsp := format.U32(h, 10)
+	npg := format.U32(h, 14)
+	nof := format.U16(h, 18)
 	return FsegHeader{
 		LeafInodeSpace: lsp, LeafInodePage: lpg, LeafInodeOff: lof,
 		NonLeafInodeSpace: nsp, NonLeafInodePage: npg, NonLeafInodeOff: nof,
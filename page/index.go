@@ -20,22 +20,33 @@ type IndexPage struct {
 	Infimum  record.GenericRecord
 	Supremum record.GenericRecord
 	DirSlots []uint16 // dirSlots[0] is the first slot (reversed from end of page)
+
+	pooled bool
 }
 
 func ParseIndexPage(ip *InnerPage) (*IndexPage, error) {
+	p := &IndexPage{}
+	if err := p.parse(ip); err != nil {
+		return nil, err
+	}
+	return p, nil
+}
+
+// parse fills p from ip, reusing the capacity of p.DirSlots
+func (p *IndexPage) parse(ip *InnerPage) error {
 	if ip.FIL.PageType != format.PageTypeIndex {
-		return nil, fmt.Errorf("not an INDEX page: type=%d", ip.FIL.PageType)
+		return fmt.Errorf("not an INDEX page: type=%d", ip.FIL.PageType)
 	}
 	hdr, err := record.ParseIndexHeader(ip.Data, format.FilHeaderSize)
 	if err != nil {
-		return nil, err
+		return err
 	}
 	if hdr.Format != format.FormatCompact {
-		return nil, fmt.Errorf("only compact pages supported (format=%d)", hdr.Format)
+		return fmt.Errorf("only compact pages supported (format=%d)", hdr.Format)
 	}
 	fseg, err := ParseFsegHeader(ip.Data, format.FilHeaderSize+36)
 	if err != nil {
-		return nil, err
+		return err
 	}
 
 	cur := format.FilHeaderSize + format.PageHeaderSize
@@ -43,11 +54,11 @@ func ParseIndexPage(ip *InnerPage) (*IndexPage, error) {
 	// INFIMUM
 	infHdr, err := record.ParseRecordHeader(ip.Data, cur)
 	if err != nil {
-		return nil, err
+		return err
 	}
 	cur += format.RecordHeaderSize
 	if !bytes.Equal(ip.Data[cur:cur+format.SystemRecordBytes], LitInfimum) {
-		return nil, fmt.Errorf("INFIMUM literal mismatch at %d", cur)
+		return fmt.Errorf("INFIMUM literal mismatch at %d", cur)
 	}
 	inf := record.GenericRecord{PageNumber: ip.PageNo, Header: infHdr, PrimaryKeyPos: cur, Data: ip.Data[cur : cur+format.SystemRecordBytes]}
 	cur += format.SystemRecordBytes
@@ -55,11 +66,11 @@ func ParseIndexPage(ip *InnerPage) (*IndexPage, error) {
 	// SUPREMUM
 	supHdr, err := record.ParseRecordHeader(ip.Data, cur)
 	if err != nil {
-		return nil, err
+		return err
 	}
 	cur += format.RecordHeaderSize
 	if !bytes.Equal(ip.Data[cur:cur+format.SystemRecordBytes], LitSupremum) {
-		return nil, fmt.Errorf("SUPREMUM literal mismatch at %d", cur)
+		return fmt.Errorf("SUPREMUM literal mismatch at %d", cur)
 	}
 	sup := record.GenericRecord{PageNumber: ip.PageNo, Header: supHdr, PrimaryKeyPos: cur, Data: ip.Data[cur : cur+format.SystemRecordBytes]}
 	cur += format.SystemRecordBytes
@@ -67,17 +78,25 @@ func ParseIndexPage(ip *InnerPage) (*IndexPage, error) {
 
 	// Directory slots read from the end of page and reversed
 	n := int(hdr.NumDirSlots)
-	dir := make([]uint16, n)
 	start := format.PageSize - format.FilTrailerSize - n*format.PageDirSlotSize
+	if start < format.PageDataOff {
+		return fmt.Errorf("too many directory slots: %d", n)
+	}
+	dir := p.DirSlots[:0]
+	if cap(dir) < n {
+		dir = make([]uint16, n)
+	}
+	dir = dir[:n]
+	slots := ip.Data[start : format.PageSize-format.FilTrailerSize]
 	for i := 0; i < n; i++ {
-		val, _ := format.Be16(ip.Data, start+i*2)
-		dir[n-i-1] = val
+		dir[n-i-1] = format.U16(slots, i*2)
 	}
 
-	return &IndexPage{
+	*p = IndexPage{
 		Inner: ip, Hdr: hdr, Fseg: fseg,
 		Infimum: inf, Supremum: sup, DirSlots: dir,
-	}, nil
+	}
+	return nil
 }
 
 func (p *IndexPage) IsLeaf() bool { return p.Hdr.PageLevel == 0 }
@@ -97,3 +116,20 @@ func (p *IndexPage) WalkRecords(max int, skipSystem bool) ([]record.GenericRecor
 	}
 	return record.WalkRecordsFromData(p.Inner.PageNo, p.Inner.Data, p.Infimum, max, skipSystem)
 }
+
+// WalkRecordsInto is WalkRecords appending into a reusable record.Batch
+func (p *IndexPage) WalkRecordsInto(b *record.Batch, max int, skipSystem bool) error {
+	if p.Hdr.Format != format.FormatCompact {
+		return fmt.Errorf("only compact format supported in WalkRecords")
+	}
+	return record.WalkRecordsInto(b, p.Inner.PageNo, p.Inner.Data, p.Infimum, max, skipSystem)
+}
+
+// ForEachRecord calls fn with the content position and header of each record
+// on the page, in key order, until fn returns false. It does not allocate.
+func (p *IndexPage) ForEachRecord(skipSystem bool, fn func(pos int, hdr record.RecordHeader) bool) error {
+	if p.Hdr.Format != format.FormatCompact {
+		return fmt.Errorf("only compact format supported in ForEachRecord")
+	}
+	return record.ForEachRecord(p.Inner.Data, skipSystem, fn)
+}
@@ -12,24 +12,38 @@ type InnerPage struct {
 	FIL     FilHeader
 	Trailer FilTrailer
 	Data    []byte // full 16KiB page bytes
+
+	// Storage for FIL.Prev/FIL.Next, so parsing the header does not
+	// allocate them separately
+	prev, next uint32
+	pooled     bool
 }
 
 func NewInnerPage(pageNo uint32, page []byte) (*InnerPage, error) {
+	ip := &InnerPage{}
+	if err := ip.init(pageNo, page); err != nil {
+		return nil, err
+	}
+	return ip, nil
+}
+
+// init parses the FIL header and trailer of page into ip
+func (ip *InnerPage) init(pageNo uint32, page []byte) error {
 	if len(page) != format.PageSize {
-		return nil, fmt.Errorf("expected %dB page, got %d", format.PageSize, len(page))
+		return fmt.Errorf("expected %dB page, got %d", format.PageSize, len(page))
 	}
-	h, err := ParseFilHeader(page)
-	if err != nil {
-		return nil, err
+	if err := parseFilHeader(page, &ip.FIL, &ip.prev, &ip.next); err != nil {
+		return err
 	}
 	t, err := ParseFilTrailer(page)
 	if err != nil {
-		return nil, err
+		return err
 	}
-	if uint32(h.LastModLSN&0xffffffff) != t.Low32LSN {
-		return nil, fmt.Errorf("low32 LSN mismatch: hdr=%#x trl=%#x", uint32(h.LastModLSN), t.Low32LSN)
+	if uint32(ip.FIL.LastModLSN&0xffffffff) != t.Low32LSN {
+		return fmt.Errorf("low32 LSN mismatch: hdr=%#x trl=%#x", uint32(ip.FIL.LastModLSN), t.Low32LSN)
 	}
-	return &InnerPage{PageNo: pageNo, FIL: h, Trailer: t, Data: page}, nil
+	ip.PageNo, ip.Trailer, ip.Data = pageNo, t, page
+	return nil
 }
 
 func (ip *InnerPage) PageType() format.PageType { return ip.FIL.PageType }
@@ -0,0 +1,91 @@
+// pool.go - Pooled page buffers and page structs
+package page
+
+import (
+	"sync"
+
+	"github.com/wilhasse/go-innodb/format"
+)
+
+// Scans that touch millions of pages recycle their 16 KiB buffers and page
+// structs through these pools instead of allocating per page. The lifecycle
+// is explicit: Acquire*, use, Release. After Release the page, its buffer
+// and anything referencing the buffer (Views, records parsed in zero-copy
+// mode) must no longer be used.
+
+var (
+	bufPool       = sync.Pool{New: func() interface{} { return new([format.PageSize]byte) }}
+	innerPagePool = sync.Pool{New: func() interface{} { return new(InnerPage) }}
+	indexPagePool = sync.Pool{New: func() interface{} { return new(IndexPage) }}
+)
+
+// GetBuffer returns a PageSize buffer from the pool. Its contents are
+// undefined.
+func GetBuffer() []byte {
+	return bufPool.Get().(*[format.PageSize]byte)[:]
+}
+
+// PutBuffer returns a buffer to the pool. Buffers shorter than PageSize are
+// dropped.
+func PutBuffer(b []byte) {
+	if cap(b) < format.PageSize {
+		return
+	}
+	bufPool.Put((*[format.PageSize]byte)(b[:format.PageSize]))
+}
+
+// AcquireInnerPage is NewInnerPage backed by the pools: the returned page
+// takes ownership of buf (usually from GetBuffer) and returns both to the
+// pools on Release. On error buf is not taken.
+func AcquireInnerPage(pageNo uint32, buf []byte) (*InnerPage, error) {
+	ip := innerPagePool.Get().(*InnerPage)
+	if err := ip.init(pageNo, buf); err != nil {
+		*ip = InnerPage{}
+		innerPagePool.Put(ip)
+		return nil, err
+	}
+	ip.pooled = true
+	return ip, nil
+}
+
+// Release returns a page from AcquireInnerPage and its buffer to the pools.
+// It is a no-op for pages built with NewInnerPage.
+func (ip *InnerPage) Release() {
+	if ip == nil || !ip.pooled {
+		return
+	}
+	PutBuffer(ip.Data)
+	*ip = InnerPage{}
+	innerPagePool.Put(ip)
+}
+
+// AcquireIndexPage is ParseIndexPage backed by the pool; the directory slot
+// slice is reused between pages. Release the IndexPage before (or together
+// with) the InnerPage it wraps.
+func AcquireIndexPage(ip *InnerPage) (*IndexPage, error) {
+	p := indexPagePool.Get().(*IndexPage)
+	if err := p.parse(ip); err != nil {
+		p.reset()
+		indexPagePool.Put(p)
+		return nil, err
+	}
+	p.pooled = true
+	return p, nil
+}
+
+// Release returns an IndexPage from AcquireIndexPage to the pool. It does
+// not release the underlying InnerPage. It is a no-op for pages built with
+// ParseIndexPage.
+func (p *IndexPage) Release() {
+	if p == nil || !p.pooled {
+		return
+	}
+	p.reset()
+	indexPagePool.Put(p)
+}
+
+// reset clears p but keeps the directory slot capacity
+func (p *IndexPage) reset() {
+	dir := p.DirSlots[:0]
+	*p = IndexPage{DirSlots: dir}
+}
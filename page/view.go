@@ -0,0 +1,120 @@
+// view.go - Lazy, allocation-free view over raw page bytes
+package page
+
+import (
+	"fmt"
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/record"
+)
+
+// Field offsets within a page
+const (
+	indexHdrOff = format.FilHeaderSize
+	fsegHdrOff  = format.FilHeaderSize + 36
+	trailerOff  = format.PageSize - format.FilTrailerSize
+)
+
+// View is a read-only view of a 16 KiB page that decodes header fields on
+// demand straight from the page bytes. Creating one validates the size once
+// and allocates nothing; every accessor is a fixed-offset load. Use it for
+// scans that only need a few fields per page (type, LSN, record count,
+// level); use NewInnerPage/ParseIndexPage when the parsed structs are needed.
+//
+// A View references the buffer it was created from and is only valid while
+// that buffer is.
+type View struct {
+	b *[format.PageSize]byte
+}
+
+// NewView returns a view of the first PageSize bytes of b
+func NewView(b []byte) (View, error) {
+	pa, err := format.PageArray(b)
+	if err != nil {
+		return View{}, err
+	}
+	return View{b: pa}, nil
+}
+
+// View returns a lazy view of the page bytes
+func (ip *InnerPage) View() View {
+	return View{b: (*[format.PageSize]byte)(ip.Data)}
+}
+
+// Bytes returns the underlying page bytes
+func (v View) Bytes() []byte { return v.b[:] }
+
+// FIL header
+
+func (v View) Checksum() uint32              { return format.U32(v.b[:], 0) }
+func (v View) PageNumber() uint32            { return format.U32(v.b[:], 4) }
+func (v View) LastModLSN() uint64            { return format.U64(v.b[:], 16) }
+func (v View) PageType() format.PageType     { return format.PageType(format.U16(v.b[:], 24)) }
+func (v View) FlushLSN() uint64              { return format.U64(v.b[:], 26) }
+func (v View) SpaceID() uint32               { return format.U32(v.b[:], 34) }
+func (v View) TrailerChecksum() uint32       { return format.U32(v.b[:], trailerOff) }
+func (v View) TrailerLow32LSN() uint32       { return format.U32(v.b[:], trailerOff+4) }
+func (v View) IsIndex() bool                 { return v.PageType() == format.PageTypeIndex }
+func (v View) LSNConsistent() bool           { return uint32(v.LastModLSN()) == v.TrailerLow32LSN() }
+func (v View) FilHeader() (FilHeader, error) { return ParseFilHeader(v.b[:]) }
+
+// Prev returns the previous page number, if any
+func (v View) Prev() (uint32, bool) {
+	n := format.U32(v.b[:], 8)
+	return n, n != filNull
+}
+
+// Next returns the next page number, if any
+func (v View) Next() (uint32, bool) {
+	n := format.U32(v.b[:], 12)
+	return n, n != filNull
+}
+
+// Index header; only meaningful when IsIndex()
+
+func (v View) NumDirSlots() uint16  { return format.U16(v.b[:], indexHdrOff+0) }
+func (v View) HeapTop() uint16      { return format.U16(v.b[:], indexHdrOff+2) }
+func (v View) NumHeapRecs() uint16  { return format.U16(v.b[:], indexHdrOff+4) & 0x7fff }
+func (v View) GarbageSpace() uint16 { return format.U16(v.b[:], indexHdrOff+8) }
+func (v View) NumUserRecs() uint16  { return format.U16(v.b[:], indexHdrOff+16) }
+func (v View) MaxTrxID() uint64     { return format.U64(v.b[:], indexHdrOff+18) }
+func (v View) PageLevel() uint16    { return format.U16(v.b[:], indexHdrOff+26) }
+func (v View) IndexID() uint64      { return format.U64(v.b[:], indexHdrOff+28) }
+func (v View) IsLeaf() bool         { return v.PageLevel() == 0 }
+
+// Format returns the record format from the high bit of the heap count
+func (v View) Format() format.PageFormat {
+	if format.U16(v.b[:], indexHdrOff+4)&0x8000 != 0 {
+		return format.FormatCompact
+	}
+	return format.FormatRedundant
+}
+
+// IndexHeader decodes the full index header
+func (v View) IndexHeader() record.IndexHeader {
+	h, _ := record.ParseIndexHeader(v.b[:], indexHdrOff)
+	return h
+}
+
+// Fseg decodes the file segment header
+func (v View) Fseg() FsegHeader {
+	h, _ := ParseFsegHeader(v.b[:], fsegHdrOff)
+	return h
+}
+
+// DirSlot returns directory slot i (0 is the INFIMUM slot), or 0 when i is
+// out of range
+func (v View) DirSlot(i int) uint16 {
+	off := trailerOff - (i+1)*format.PageDirSlotSize
+	if i < 0 || i >= int(v.NumDirSlots()) || off < format.PageDataOff {
+		return 0
+	}
+	return format.U16(v.b[:], off)
+}
+
+// ForEachRecord walks the page's record chain like IndexPage.ForEachRecord
+func (v View) ForEachRecord(skipSystem bool, fn func(pos int, hdr record.RecordHeader) bool) error {
+	if v.Format() != format.FormatCompact {
+		return fmt.Errorf("only compact format supported in ForEachRecord")
+	}
+	return record.ForEachRecord(v.b[:], skipSystem, fn)
+}
@@ -22,3 +22,36 @@ func (pr *PageReader) ReadPage(pageNo uint32) (*page.InnerPage, error) {
 	}
 	return page.NewInnerPage(pageNo, buf)
 }
+
+// AcquirePage reads a page into a pooled buffer and returns a pooled
+// InnerPage. Call Release on it when done; the page, its Data and anything
+// referencing Data must not be used afterwards.
+func (pr *PageReader) AcquirePage(pageNo uint32) (*page.InnerPage, error) {
+	buf := page.GetBuffer()
+	off := int64(pageNo) * int64(format.PageSize)
+	if _, err := pr.r.ReadAt(buf, off); err != nil {
+		page.PutBuffer(buf)
+		return nil, fmt.Errorf("read page %d: %w", pageNo, err)
+	}
+	ip, err := page.AcquireInnerPage(pageNo, buf)
+	if err != nil {
+		page.PutBuffer(buf)
+		return nil, err
+	}
+	return ip, nil
+}
+
+// ReadView reads a page into buf (at least PageSize bytes) and returns a lazy
+// view of it. Nothing is allocated, so header-only scans can reuse one
+// buffer for every page; the view is only valid until buf is reused.
+func (pr *PageReader) ReadView(pageNo uint32, buf []byte) (page.View, error) {
+	if len(buf) < format.PageSize {
+		return page.View{}, format.ErrShortRead
+	}
+	buf = buf[:format.PageSize]
+	off := int64(pageNo) * int64(format.PageSize)
+	if _, err := pr.r.ReadAt(buf, off); err != nil {
+		return page.View{}, fmt.Errorf("read page %d: %w", pageNo, err)
+	}
+	return page.NewView(buf)
+}
@@ -0,0 +1,57 @@
+// batch.go - Pooled, reusable record batches
+package record
+
+import "sync"
+
+// Batch is a reusable slice of records. Records handed out by Next keep
+// their Values map from earlier use, so parsing page after page into the same
+// batch (with CompactParser.ParseRecordInto) allocates no new records or
+// maps once the batch has grown to size.
+type Batch struct {
+	Records []GenericRecord
+}
+
+var batchPool = sync.Pool{New: func() interface{} { return new(Batch) }}
+
+// AcquireBatch returns an empty batch from the pool
+func AcquireBatch() *Batch {
+	return batchPool.Get().(*Batch)
+}
+
+// Next appends a cleared record slot to the batch and returns it. The
+// slot keeps its (emptied) Values map from an earlier use.
+func (b *Batch) Next() *GenericRecord {
+	n := len(b.Records)
+	if n < cap(b.Records) {
+		b.Records = b.Records[:n+1]
+		r := &b.Records[n]
+		for k := range r.Values {
+			delete(r.Values, k)
+		}
+		*r = GenericRecord{Values: r.Values}
+		return r
+	}
+	b.Records = append(b.Records, GenericRecord{})
+	return &b.Records[n]
+}
+
+// Len returns the number of records in the batch
+func (b *Batch) Len() int { return len(b.Records) }
+
+// Reset empties the batch, keeping its storage
+func (b *Batch) Reset() { b.Records = b.Records[:0] }
+
+// Release clears the batch and returns it to the pool. Values are dropped so
+// pooled batches do not keep page buffers alive.
+func (b *Batch) Release() {
+	all := b.Records[:cap(b.Records)]
+	for i := range all {
+		r := &all[i]
+		for k := range r.Values {
+			delete(r.Values, k)
+		}
+		*r = GenericRecord{Values: r.Values}
+	}
+	b.Reset()
+	batchPool.Put(b)
+}
@@ -9,283 +9,350 @@ import (
 	"github.com/wilhasse/go-innodb/schema"
 )
 
-// CompactParser parses records in InnoDB compact format
+// sysColumnsSize is the size of DB_TRX_ID (6) and DB_ROLL_PTR (7), stored
+// after the primary key in clustered index leaf records
+const sysColumnsSize = 13
+
+// childPageSize is the size of the child page number ending a node pointer
+const childPageSize = 4
+
+// CompactParser parses records in InnoDB compact format. It keeps scratch
+// state between records, so a parser must not be shared between goroutines.
 type CompactParser struct {
 	tableDef *schema.TableDef
+	zeroCopy bool
+
+	// Decode plan, computed once from tableDef: columns in physical field
+	// order (primary key first) and the variable-length ones among them,
+	// which is the order of their length headers.
+	fields     []*schema.Column
+	numPK      int
+	varFields  []*schema.Column
+	varPKCount int
+
+	// Per-record layout scratch, reused by every record
+	nullBitmap []bool
+	varLengths []int
 }
 
-// NewCompactParser creates a new compact record parser
+// NewCompactParser creates a new compact record parser. The table
+// definition must be complete; the decode plan is derived from it here.
 func NewCompactParser(tableDef *schema.TableDef) *CompactParser {
-	return &CompactParser{
-		tableDef: tableDef,
+	p := &CompactParser{
+		tableDef:   tableDef,
+		nullBitmap: make([]bool, tableDef.NullableColumnCount()),
 	}
+	p.fields = append(p.fields, tableDef.PrimaryKeyColumns()...)
+	p.numPK = len(p.fields)
+	for _, col := range tableDef.Columns {
+		if !col.IsPrimaryKey {
+			p.fields = append(p.fields, col)
+		}
+	}
+	for i, col := range p.fields {
+		if col.IsVariableLength() {
+			p.varFields = append(p.varFields, col)
+			if i < p.numPK {
+				p.varPKCount++
+			}
+		}
+	}
+	p.varLengths = make([]int, 0, len(p.varFields))
+	return p
 }
 
-// ParseRecord parses a record from raw page data
-func (p *CompactParser) ParseRecord(pageData []byte, recordPos int, isLeafPage bool) (*GenericRecord, error) {
-	// The actual record content starts at recordPos
-	// But we need to read backwards to get variable length headers and NULL bitmap
-
-	// First, read the record header (5 bytes before recordPos)
-	headerPos := recordPos - format.RecordHeaderSize
-	if headerPos < 0 {
-		return nil, fmt.Errorf("invalid record position")
-	}
+// SetZeroCopy enables or disables zero-copy mode. In zero-copy mode string
+// and binary columns are stored in Values as column.View slices of the page
+// data instead of copies; they are only valid while the page buffer is, and
+// must be Clone()d to be retained longer.
+func (p *CompactParser) SetZeroCopy(enabled bool) {
+	p.zeroCopy = enabled
+}
 
-	header, err := ParseRecordHeader(pageData, headerPos)
-	if err != nil {
-		return nil, fmt.Errorf("parse record header: %w", err)
+// parseColumn decodes one column honoring the zero-copy setting
+func (p *CompactParser) parseColumn(pageData []byte, pos int, col *schema.Column, varLen int) (interface{}, int, error) {
+	if p.zeroCopy {
+		return column.ParseColumnView(pageData, pos, col, varLen)
 	}
+	return column.ParseColumn(pageData, pos, col, varLen)
+}
 
-	// Create the record
-	record := &GenericRecord{
-		Header:        header,
-		PrimaryKeyPos: recordPos,
-		Values:        make(map[string]interface{}),
+// readLayout reads the NULL bitmap and variable-length headers stored before
+// the record header at headerPos into p.nullBitmap and p.varLengths (one
+// entry per field in p.varFields order, 0 for NULL). It returns the number
+// of bytes they occupy.
+func (p *CompactParser) readLayout(pageData []byte, headerPos int, isLeafPage bool) (int, error) {
+	for i := range p.nullBitmap {
+		p.nullBitmap[i] = false
 	}
+	p.varLengths = p.varLengths[:0]
 
-	// Handle special records (INFIMUM/SUPREMUM)
-	if header.Type == format.RecInfimum || header.Type == format.RecSupremum {
-		record.Data = pageData[recordPos : recordPos+format.SystemRecordBytes]
-		return record, nil
+	// Step 1: Parse NULL bitmap. Node pointers reserve one of the same size
+	// as leaf records, but their key columns are NOT NULL: it is skipped.
+	nullBitmapSize := p.tableDef.NullBitmapSize()
+	if headerPos-nullBitmapSize < 0 {
+		return 0, fmt.Errorf("invalid NULL bitmap position")
 	}
-
-	// For user records, we need to parse the variable-length headers and NULL bitmap
-
-	// Step 1: Parse NULL bitmap (only for leaf pages with nullable columns)
-	nullBitmap := make([]bool, p.tableDef.NullableColumnCount())
-	nullBitmapSize := 0
-
-	if isLeafPage && p.tableDef.HasNullableColumn() {
-		nullBitmapSize = p.tableDef.NullBitmapSize()
-		nullBitmapPos := headerPos - nullBitmapSize
-
-		if nullBitmapPos < 0 {
-			return nil, fmt.Errorf("invalid NULL bitmap position")
-		}
-
-		// Read NULL bitmap
-		nullBytes := pageData[nullBitmapPos:headerPos]
-		nullIdx := 0
-		for range p.tableDef.NullableColumns() {
-			byteIdx := nullIdx / 8
-			bitIdx := nullIdx % 8
-			if byteIdx < len(nullBytes) {
-				nullBitmap[nullIdx] = (nullBytes[byteIdx] & (1 << bitIdx)) != 0
-			}
-			nullIdx++
+	if isLeafPage {
+		// Bits are numbered from the byte nearest the header backwards
+		for i := range p.nullBitmap {
+			b := pageData[headerPos-1-i/8]
+			p.nullBitmap[i] = b&(1<<(i%8)) != 0
 		}
 	}
 
 	// Step 2: Parse variable-length field headers
-	// Headers are stored right-to-left before the NULL bitmap.
-	// Because we iterate from the last varlen column to the first, we must
-	// PREPEND each decoded length to keep varLengths in column order.
-	varLengths := make([]int, 0, len(p.tableDef.VariableLengthColumns()))
-	varLenHeaderSize := 0
-
-	if p.tableDef.HasVariableLengthColumn() {
-		// Start at the byte just before the NULL bitmap
-		varHeaderPos := headerPos - nullBitmapSize
-		// Decide which varlen columns are present in the record.
-		// - Leaf records (clustered or secondary) carry headers for ALL
-		//   variable-length user columns present in the record.
-		// - Internal (node-pointer) records carry only key columns.
-		// (We rely on the provided TableDef to reflect the clustered index.)
-		var varColumns []*schema.Column
-		if isLeafPage {
-			varColumns = p.tableDef.VariableLengthColumns()
-		} else {
-			varColumns = p.tableDef.GetPrimaryKeyVarLenColumns()
+	// Headers are stored right-to-left before the NULL bitmap: the byte
+	// nearest the bitmap belongs to the first variable-length field.
+	// Internal (node-pointer) records carry only the key columns.
+	varFields := p.varFields
+	if !isLeafPage {
+		varFields = varFields[:p.varPKCount]
+	}
+	varHeaderPos := headerPos - nullBitmapSize
+	for _, col := range varFields {
+		if col.NullIndex >= 0 && p.nullBitmap[col.NullIndex] {
+			p.varLengths = append(p.varLengths, 0)
+			continue
 		}
 
-		// Variable-length headers are stored in reverse column order.
-		// We read backwards through memory, but the rightmost header
-		// corresponds to the FIRST variable column, not the last.
-		for i := 0; i < len(varColumns); i++ {
-			col := varColumns[i]
-
-			// Check if this column is NULL
-			isNull := false
-			if col.Nullable {
-				// Find column's index in nullable columns
-				for idx, nullCol := range p.tableDef.NullableColumns() {
-					if nullCol.Name == col.Name && nullBitmap[idx] {
-						isNull = true
-						break
-					}
-				}
-			}
-
-			if isNull {
-				varLengths = append([]int{0}, varLengths...) // Prepend 0 for NULL column
-				continue
-			}
+		// Read variable length header (1 or 2 bytes)
+		varHeaderPos--
+		if varHeaderPos < 0 {
+			return 0, fmt.Errorf("invalid variable header position")
+		}
+		length := int(pageData[varHeaderPos])
 
-			// Read variable length header (1 or 2 bytes)
+		// Check if it's a 2-byte length
+		if p.needsTwoByteLength(col, length) {
 			varHeaderPos--
 			if varHeaderPos < 0 {
-				return nil, fmt.Errorf("invalid variable header position")
+				return 0, fmt.Errorf("invalid variable header position")
 			}
 
-			length := int(pageData[varHeaderPos])
-			varLenHeaderSize++
+			// High byte is in the first byte read, with overflow flag in bit 6
+			overflowFlag := (length & 0x40) != 0
+			length = ((length & 0x3F) << 8) | int(pageData[varHeaderPos])
 
-			// Check if it's a 2-byte length
-			if p.needsTwoByteLength(col, length) {
-				varHeaderPos--
-				if varHeaderPos < 0 {
-					return nil, fmt.Errorf("invalid variable header position")
-				}
+			if overflowFlag {
+				// TODO: Handle overflow pages
+				return 0, fmt.Errorf("overflow pages not yet supported")
+			}
+		}
+		p.varLengths = append(p.varLengths, length)
+	}
+	return headerPos - varHeaderPos, nil
+}
 
-				// High byte is in the first byte read, with overflow flag in bit 6
-				overflowFlag := (length & 0x40) != 0
-				length = ((length & 0x3F) << 8) | int(pageData[varHeaderPos])
-				varLenHeaderSize++
+// ParseRecord parses a record from raw page data
+func (p *CompactParser) ParseRecord(pageData []byte, recordPos int, isLeafPage bool) (*GenericRecord, error) {
+	record := &GenericRecord{Values: make(map[string]interface{}, len(p.fields))}
+	if err := p.ParseRecordInto(record, pageData, recordPos, isLeafPage); err != nil {
+		return nil, err
+	}
+	return record, nil
+}
 
-				if overflowFlag {
-					// TODO: Handle overflow pages
-					return nil, fmt.Errorf("overflow pages not yet supported")
-				}
-			}
+// ParseRecordInto parses a record like ParseRecord into an existing record,
+// reusing its Values map (see Batch). PageNumber is left unchanged.
+func (p *CompactParser) ParseRecordInto(record *GenericRecord, pageData []byte, recordPos int, isLeafPage bool) error {
+	// The actual record content starts at recordPos
+	// But we need to read backwards to get variable length headers and NULL bitmap
 
-			// Append to maintain column order
-			varLengths = append(varLengths, length)
+	// First, read the record header (5 bytes before recordPos)
+	headerPos := recordPos - format.RecordHeaderSize
+	if headerPos < 0 {
+		return fmt.Errorf("invalid record position")
+	}
+
+	header, err := ParseRecordHeader(pageData, headerPos)
+	if err != nil {
+		return fmt.Errorf("parse record header: %w", err)
+	}
+
+	record.Header = header
+	record.PrimaryKeyPos = recordPos
+	record.ChildPageNumber = 0
+	record.Data = nil
+	if record.Values == nil {
+		record.Values = make(map[string]interface{}, len(p.fields))
+	} else {
+		for k := range record.Values {
+			delete(record.Values, k)
+		}
+	}
+
+	// Handle special records (INFIMUM/SUPREMUM)
+	if header.Type == format.RecInfimum || header.Type == format.RecSupremum {
+		if recordPos+format.SystemRecordBytes > len(pageData) {
+			return format.ErrShortRead
 		}
+		record.Data = pageData[recordPos : recordPos+format.SystemRecordBytes]
+		return nil
 	}
 
-	// Step 3: Parse actual column data starting from recordPos
-	// Note: Transaction fields (6-byte trx_id + 7-byte roll_ptr) are stored
-	// AFTER the primary key columns in clustered index leaf pages.
+	if _, err := p.readLayout(pageData, headerPos, isLeafPage); err != nil {
+		return err
+	}
+
+	// Parse actual column data starting from recordPos, in field order.
+	// Leaf records hold every column with the transaction fields after the
+	// primary key; node pointers hold the key and then the child page number.
 	dataPos := recordPos
 	varLenIdx := 0
-
-	// First parse primary key columns
-	for _, col := range p.tableDef.PrimaryKeyColumns() {
-		// Check if column is NULL
-		isNull := false
-		if col.Nullable {
-			for idx, nullCol := range p.tableDef.NullableColumns() {
-				if nullCol.Name == col.Name && nullBitmap[idx] {
-					isNull = true
-					break
+	for i := 0; i <= len(p.fields); i++ {
+		if i == p.numPK {
+			if !isLeafPage {
+				child, err := format.Be32(pageData, dataPos)
+				if err != nil {
+					return fmt.Errorf("read child page number: %w", err)
 				}
+				record.ChildPageNumber = child
+				dataPos += childPageSize
+				break
 			}
+			dataPos += sysColumnsSize
 		}
-
-		if isNull {
-			record.Values[col.Name] = nil
-			if col.IsVariableLength() {
-				varLenIdx++
-			}
-			continue
+		if i == len(p.fields) {
+			break
 		}
+		col := p.fields[i]
 
 		// Get variable length if applicable
 		varLen := 0
 		if col.IsVariableLength() {
-			if varLenIdx < len(varLengths) {
-				varLen = varLengths[varLenIdx]
-				varLenIdx++
-			}
+			varLen = p.varLengths[varLenIdx]
+			varLenIdx++
+		}
+
+		// Check if column is NULL
+		if col.NullIndex >= 0 && p.nullBitmap[col.NullIndex] {
+			record.Values[col.Name] = nil
+			continue
 		}
 
 		// Parse column value
-		value, bytesRead, err := column.ParseColumn(pageData, dataPos, col, varLen)
+		value, bytesRead, err := p.parseColumn(pageData, dataPos, col, varLen)
 		if err != nil {
-			return nil, fmt.Errorf("parse column %s: %w", col.Name, err)
+			return fmt.Errorf("parse column %s: %w", col.Name, err)
 		}
 
 		record.Values[col.Name] = value
 		dataPos += bytesRead
 	}
 
-	// Skip transaction ID and roll pointer (13 bytes total) for leaf pages
-	if isLeafPage {
-		// Skip 6-byte transaction ID and 7-byte roll pointer
-		dataPos += 13
+	// The record's data is exactly the bytes its columns occupy. Trailing
+	// NULLs or the system columns can take dataPos past a truncated page.
+	if dataPos > len(pageData) {
+		return format.ErrShortRead
 	}
+	record.Data = pageData[recordPos:dataPos]
 
-	// Now parse non-primary key columns
-	for _, col := range p.tableDef.Columns {
-		// Skip if already parsed as primary key
-		if col.IsPrimaryKey {
-			continue
-		}
+	return nil
+}
 
-		// Check if column is NULL
-		isNull := false
-		if col.Nullable {
-			for idx, nullCol := range p.tableDef.NullableColumns() {
-				if nullCol.Name == col.Name && nullBitmap[idx] {
-					isNull = true
-					break
-				}
-			}
-		}
+// RecordExtent returns the byte range [start, end) a record occupies in
+// pageData: start is the first byte of its variable-length headers and NULL
+// bitmap (node pointers have one too), end is one past its last column. It follows the same decode plan
+// as ParseRecord but only skips over column values.
+func (p *CompactParser) RecordExtent(pageData []byte, recordPos int, isLeafPage bool) (int, int, error) {
+	headerPos := recordPos - format.RecordHeaderSize
+	if headerPos < 0 {
+		return 0, 0, fmt.Errorf("invalid record position")
+	}
+	header, err := ParseRecordHeader(pageData, headerPos)
+	if err != nil {
+		return 0, 0, fmt.Errorf("parse record header: %w", err)
+	}
+	if header.Type == format.RecInfimum || header.Type == format.RecSupremum {
+		return headerPos, recordPos + format.SystemRecordBytes, nil
+	}
 
-		if isNull {
-			record.Values[col.Name] = nil
-			if col.IsVariableLength() {
-				varLenIdx++
+	extra, err := p.readLayout(pageData, headerPos, isLeafPage)
+	if err != nil {
+		return 0, 0, err
+	}
+
+	dataPos := recordPos
+	varLenIdx := 0
+	for i := 0; i <= len(p.fields); i++ {
+		if i == p.numPK {
+			if !isLeafPage {
+				dataPos += childPageSize
+				break
 			}
-			continue
+			dataPos += sysColumnsSize
 		}
-
-		// Get variable length if applicable
+		if i == len(p.fields) {
+			break
+		}
+		col := p.fields[i]
 		varLen := 0
 		if col.IsVariableLength() {
-			if varLenIdx < len(varLengths) {
-				varLen = varLengths[varLenIdx]
-				varLenIdx++
-			}
+			varLen = p.varLengths[varLenIdx]
+			varLenIdx++
 		}
-
-		// Parse column value
-		value, bytesRead, err := column.ParseColumn(pageData, dataPos, col, varLen)
+		if col.NullIndex >= 0 && p.nullBitmap[col.NullIndex] {
+			continue
+		}
+		n, err := column.SkipColumn(pageData, dataPos, col, varLen)
 		if err != nil {
-			return nil, fmt.Errorf("parse column %s: %w", col.Name, err)
+			return 0, 0, fmt.Errorf("skip column %s: %w", col.Name, err)
 		}
+		dataPos += n
+	}
+	if dataPos > len(pageData) {
+		return 0, 0, format.ErrShortRead
+	}
+	return headerPos - extra, dataPos, nil
+}
 
-		record.Values[col.Name] = value
-		dataPos += bytesRead
+// LocateFields finds the columns of the clustered index leaf record at
+// recordPos without decoding them: pos[i] and size[i] receive the offset and
+// stored size of the column with Ordinal i, and size[i] is -1 for NULL. pos
+// and size must hold one entry per column. Columnar decoders call it for
+// every record of a page and then decode each column for all records at once
+// (see column.DecodeIntBatch).
+func (p *CompactParser) LocateFields(pageData []byte, recordPos int, pos, size []int) error {
+	headerPos := recordPos - format.RecordHeaderSize
+	if headerPos < 0 {
+		return fmt.Errorf("invalid record position")
+	}
+	if _, err := p.readLayout(pageData, headerPos, true); err != nil {
+		return err
 	}
 
-	// Store raw data for debugging
-	endPos := recordPos + header.NextRecOffset
-	if header.NextRecOffset <= 0 || endPos > len(pageData) {
-		// Last record or invalid offset, read a reasonable amount
-		endPos = dataPos
-		if endPos-recordPos > 100 {
-			endPos = recordPos + 100
+	dataPos := recordPos
+	varLenIdx := 0
+	for i, col := range p.fields {
+		if i == p.numPK {
+			dataPos += sysColumnsSize
+		}
+		varLen := 0
+		if col.IsVariableLength() {
+			varLen = p.varLengths[varLenIdx]
+			varLenIdx++
+		}
+		if col.NullIndex >= 0 && p.nullBitmap[col.NullIndex] {
+			pos[col.Ordinal], size[col.Ordinal] = dataPos, -1
+			continue
+		}
+		n, err := column.SkipColumn(pageData, dataPos, col, varLen)
+		if err != nil {
+			return fmt.Errorf("skip column %s: %w", col.Name, err)
 		}
+		pos[col.Ordinal], size[col.Ordinal] = dataPos, n
+		dataPos += n
 	}
-	if endPos > recordPos && endPos <= len(pageData) {
-		record.Data = pageData[recordPos:endPos]
+	if dataPos > len(pageData) {
+		return format.ErrShortRead
 	}
-
-	return record, nil
+	return nil
 }
 
-// needsTwoByteLength checks if a variable-length column needs 2-byte length header
+// needsTwoByteLength checks if a variable-length column needs 2-byte length header.
+// InnoDB uses two bytes when the first byte has its high bit set and the
+// column can hold more than 255 bytes (BLOB/TEXT types or long VARCHARs).
 func (p *CompactParser) needsTwoByteLength(col *schema.Column, firstByte int) bool {
-	// If length > 127, might need 2 bytes
-	// Also check if column can be long (BLOB/TEXT types or VARCHAR > 255)
-	if firstByte > 127 {
-		switch col.Type {
-		case schema.TypeText, schema.TypeMediumText, schema.TypeLongText,
-			schema.TypeBlob, schema.TypeMediumBlob, schema.TypeLongBlob:
-			return true
-		case schema.TypeVarchar, schema.TypeVarBinary:
-			// VARCHAR/VARBINARY needs 2 bytes if max length > 255
-			maxLen := col.Length
-			if col.Charset == "utf8mb4" {
-				maxLen *= 4
-			} else if col.Charset == "utf8" {
-				maxLen *= 3
-			}
-			return maxLen > 255
-		}
-	}
-	return false
+	return firstByte > 127 && col.MaxBytes > 255
 }
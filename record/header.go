@@ -17,16 +17,17 @@ type RecordHeader struct {
 }
 
 func ParseRecordHeader(p []byte, off int) (RecordHeader, error) {
-	if off+format.RecordHeaderSize > len(p) {
+	if off < 0 || off+format.RecordHeaderSize > len(p) {
 		return RecordHeader{}, fmt.Errorf("short record header")
 	}
-	b1 := p[off]
+	h := p[off:][:format.RecordHeaderSize]
+	b1 := h[0]
 	flags := (b1 & 0xF0) >> 4
 	nOwned := b1 & 0x0F
-	b2, _ := format.Be16(p, off+1)
+	b2 := format.U16(h, 1)
 	rtype := format.RecordType(b2 & 0x0007)
 	heap := (b2 & 0xFFF8) >> 3
-	nxtU, _ := format.Be16(p, off+3)
+	nxtU := format.U16(h, 3)
 	next := int(int16(nxtU))
 	return RecordHeader{
 		FlagsMinRec:   (flags & 0x1) != 0,
@@ -24,21 +24,22 @@ type IndexHeader struct {
 }
 
 func ParseIndexHeader(p []byte, off int) (IndexHeader, error) {
-	if off+36 > len(p) {
+	if off < 0 || off+36 > len(p) {
 		return IndexHeader{}, fmt.Errorf("short index header")
 	}
-	nSlots, _ := format.Be16(p, off+0)
-	heapTop, _ := format.Be16(p, off+2)
-	flag, _ := format.Be16(p, off+4)
-	firstGarbage, _ := format.Be16(p, off+6)
-	garbage, _ := format.Be16(p, off+8)
-	lastIns, _ := format.Be16(p, off+10)
-	dir, _ := format.Be16(p, off+12)
-	nDir, _ := format.Be16(p, off+14)
-	nRecs, _ := format.Be16(p, off+16)
-	maxTrx, _ := format.Be64(p, off+18)
-	level, _ := format.Be16(p, off+26)
-	indexID, _ := format.Be64(p, off+28)
+	h := p[off:][:36]
+	nSlots := format.U16(h, 0)
+	heapTop := format.U16(h, 2)
+	flag := format.U16(h, 4)
+	firstGarbage := format.U16(h, 6)
+	garbage := format.U16(h, 8)
+	lastIns := format.U16(h, 10)
+	dir := format.U16(h, 12)
+	nDir := format.U16(h, 14)
+	nRecs := format.U16(h, 16)
+	maxTrx := format.U64(h, 18)
+	level := format.U16(h, 26)
+	indexID := format.U64(h, 28)
 
 	fmt := format.FormatRedundant
 	if (flag & 0x8000) != 0 {
@@ -2,71 +2,176 @@
 package record
 
 import (
+	"errors"
 	"fmt"
 	"github.com/wilhasse/go-innodb/format"
 )
 
+// ErrCorruptRecordChain is returned when a page's next-record chain leaves
+// the page body, loops, or ends before SUPREMUM
+var ErrCorruptRecordChain = errors.New("corrupt record chain")
+
+// infimumPos is the content position of INFIMUM on every compact page
+const infimumPos = format.PageDataOff + format.RecordHeaderSize
+
+// Cursor walks the record chain of a compact page from INFIMUM to SUPREMUM
+// following each header's relative next offset. It yields only the content
+// position and header of each record and never allocates, so a scan can
+// decode just the records (and columns) it needs:
+//
+//	var c record.Cursor
+//	c.Reset(pageData, true)
+//	for c.Next() {
+//	    pos, hdr := c.Pos(), c.Header()
+//	    ...
+//	}
+//	if err := c.Err(); err != nil { ... }
+//
+// Every position is bounds checked against the page body and remembered in a
+// bitmap, so a corrupt page stops the walk with ErrCorruptRecordChain instead
+// of looping or reading outside the page.
+type Cursor struct {
+	data       []byte
+	pos        int
+	hdr        RecordHeader
+	skipSystem bool
+	started    bool
+	done       bool
+	err        error
+	visited    [format.PageSize / 64]uint64
+}
+
+// Reset positions the cursor before the first record of pageData.
+// If skipSystem is true, INFIMUM and SUPREMUM are not yielded.
+func (c *Cursor) Reset(pageData []byte, skipSystem bool) {
+	c.data = pageData
+	c.pos = 0
+	c.hdr = RecordHeader{}
+	c.skipSystem = skipSystem
+	c.started = false
+	c.done = false
+	c.err = nil
+	c.visited = [format.PageSize / 64]uint64{}
+}
+
+// Next advances to the next record and reports whether there is one
+func (c *Cursor) Next() bool {
+	for !c.done {
+		next := infimumPos
+		if c.started {
+			if c.hdr.Type == format.RecSupremum {
+				c.done = true
+				return false
+			}
+			if c.hdr.NextRecOffset == 0 {
+				return c.fail("chain ends at %d before SUPREMUM", c.pos)
+			}
+			next = c.pos + c.hdr.NextRecOffset
+		}
+		c.started = true
+
+		limit := len(c.data) - format.FilTrailerSize
+		if limit > format.PageSize {
+			limit = format.PageSize
+		}
+		if next < infimumPos || next >= limit {
+			return c.fail("next record position %d out of bounds", next)
+		}
+		if c.visited[next/64]&(1<<(next%64)) != 0 {
+			return c.fail("record %d visited twice", next)
+		}
+		c.visited[next/64] |= 1 << (next % 64)
+
+		hdr, err := ParseRecordHeader(c.data, next-format.RecordHeaderSize)
+		if err != nil {
+			return c.fail("%v", err)
+		}
+		c.pos, c.hdr = next, hdr
+
+		if c.skipSystem && (hdr.Type == format.RecInfimum || hdr.Type == format.RecSupremum) {
+			continue
+		}
+		return true
+	}
+	return false
+}
+
+func (c *Cursor) fail(msg string, args ...interface{}) bool {
+	c.err = fmt.Errorf("%w: "+msg, append([]interface{}{ErrCorruptRecordChain}, args...)...)
+	c.done = true
+	return false
+}
+
+// Pos returns the content position of the current record
+func (c *Cursor) Pos() int { return c.pos }
+
+// Header returns the header of the current record
+func (c *Cursor) Header() RecordHeader { return c.hdr }
+
+// Err returns the error that stopped the walk, if any
+func (c *Cursor) Err() error { return c.err }
+
+// ForEachRecord calls fn with the content position and header of each record
+// on a compact page, in key order, until fn returns false.
+func ForEachRecord(pageData []byte, skipSystem bool, fn func(pos int, hdr RecordHeader) bool) error {
+	var c Cursor
+	c.Reset(pageData, skipSystem)
+	for c.Next() {
+		if !fn(c.pos, c.hdr) {
+			return nil
+		}
+	}
+	return c.err
+}
+
 // WalkRecordsFromData walks records from raw page data following the compact record header's relative next offset.
 // If skipSystem is true, INFIMUM and SUPREMUM are not returned.
-// max limits the number of records to traverse (safety).
+// max limits the number of records returned.
 // pageNo is the page number for reference.
 // pageData is the full 16KB page data.
 // infimum is the starting infimum record.
+//
+// Without a schema the extent of a user record is unknown, so Data holds an
+// approximation; use Cursor or ForEachRecord with CompactParser.ParseRecord
+// (or RecordExtent) for exact, allocation-free scans.
 func WalkRecordsFromData(pageNo uint32, pageData []byte, infimum GenericRecord, max int, skipSystem bool) ([]GenericRecord, error) {
-	var out []GenericRecord
-	cur := infimum
-	if !skipSystem {
-		out = append(out, cur)
-	}
-	for steps := 0; steps < max; steps++ {
-		nextContent := cur.NextRecordPos()
-		if cur.Header.NextRecOffset == 0 {
-			break // usually SUPREMUM has next==0
-		}
-		if nextContent < format.FilHeaderSize+format.PageHeaderSize || nextContent >= format.PageSize-format.FilTrailerSize {
-			return out, fmt.Errorf("next content position out of bounds: %d", nextContent)
-		}
-		nextHeaderPos := nextContent - format.RecordHeaderSize
-		if nextHeaderPos < 0 {
-			return out, fmt.Errorf("negative next header pos")
-		}
-		hdr, err := ParseRecordHeader(pageData, nextHeaderPos)
-		if err != nil {
-			return out, err
+	var b Batch
+	err := WalkRecordsInto(&b, pageNo, pageData, infimum, max, skipSystem)
+	return b.Records, err
+}
+
+// WalkRecordsInto is WalkRecordsFromData appending into a reusable Batch
+func WalkRecordsInto(b *Batch, pageNo uint32, pageData []byte, infimum GenericRecord, max int, skipSystem bool) error {
+	var c Cursor
+	c.Reset(pageData, skipSystem)
+	for n := 0; n < max && c.Next(); n++ {
+		pos, hdr := c.pos, c.hdr
+		rec := b.Next()
+		if hdr.Type == format.RecInfimum {
+			values := rec.Values
+			*rec = infimum
+			if infimum.Values == nil {
+				rec.Values = values
+			}
+			continue
 		}
-		rec := GenericRecord{PageNumber: pageNo, Header: hdr, PrimaryKeyPos: nextContent}
+		rec.PageNumber, rec.Header, rec.PrimaryKeyPos = pageNo, hdr, pos
 
-		// Read the actual record data
-		// For now, read up to the next record or a reasonable amount of bytes
 		dataSize := 0
-		if hdr.NextRecOffset > 0 && hdr.NextRecOffset > format.RecordHeaderSize {
-			// Size is roughly the distance to the next record minus the header
-			dataSize = hdr.NextRecOffset - format.RecordHeaderSize
-		} else if hdr.Type == format.RecSupremum {
+		if hdr.Type == format.RecSupremum {
 			// Supremum has fixed 8-byte data
-			dataSize = 8
+			dataSize = format.SystemRecordBytes
+		} else if hdr.NextRecOffset > format.RecordHeaderSize {
+			// Roughly the distance to the next record minus its header
+			dataSize = hdr.NextRecOffset - format.RecordHeaderSize
 		} else {
-			// For the last user record or unknown cases, read a reasonable amount
-			// This is a heuristic - proper implementation needs column definitions
-			dataSize = 100 // Read up to 100 bytes of data
-			maxPos := len(pageData) - nextContent
-			if dataSize > maxPos {
-				dataSize = maxPos
-			}
-		}
-
-		if dataSize > 0 && nextContent+dataSize <= len(pageData) {
-			rec.Data = pageData[nextContent : nextContent+dataSize]
+			// Last user record or unknown: read a bounded amount
+			dataSize = 100
 		}
-
-		if rec.Header.Type == format.RecSupremum {
-			if !skipSystem {
-				out = append(out, rec)
-			}
-			break
+		if pos+dataSize > len(pageData) {
+			dataSize = len(pageData) - pos
 		}
-		out = append(out, rec)
-		cur = rec
+		rec.Data = pageData[pos : pos+dataSize]
 	}
-	return out, nil
+	return c.err
 }
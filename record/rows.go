@@ -0,0 +1,28 @@
+// rows.go - Page scans with schema-specialized row decoders
+package record
+
+// RowDecoder is implemented by the typed row structs generated from a
+// CREATE TABLE statement by cmd/innodb-gen. DecodeRecord decodes the
+// clustered index leaf record whose content starts at pos into the
+// receiver, with the table layout compiled in instead of interpreted.
+type RowDecoder interface {
+	DecodeRecord(pageData []byte, pos int) error
+}
+
+// DecodeRows decodes each user record of a clustered index leaf page into
+// row and then calls fn with the record header (delete-marked records are
+// included; check hdr.FlagsDeleted). The same row is reused for every
+// record. The scan stops when fn returns false or a record fails to decode.
+func DecodeRows(pageData []byte, row RowDecoder, fn func(hdr RecordHeader) bool) error {
+	var c Cursor
+	c.Reset(pageData, true)
+	for c.Next() {
+		if err := row.DecodeRecord(pageData, c.pos); err != nil {
+			return err
+		}
+		if !fn(c.hdr) {
+			return nil
+		}
+	}
+	return c.err
+}
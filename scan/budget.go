@@ -0,0 +1,138 @@
+// budget.go - Memory budget shared by the stages of a scan
+package scan
+
+import (
+	"sync"
+	"time"
+)
+
+// BudgetStats reports the use of a Budget
+type BudgetStats struct {
+	Limit  int64
+	InUse  int64
+	Peak   int64
+	Waits  int64         // acquisitions that had to wait for memory
+	Waited time.Duration // total time spent waiting
+}
+
+// Budget bounds the memory held by a scan and the stages after it: read
+// buffers, decoded batches, formatted output and compressed blocks. Stages
+// acquire bytes before allocating and release them once the memory is
+// handed back, so a stage that would take the total over the limit waits
+// until downstream stages drain, and the wait propagates upstream.
+//
+// Stages that drain memory (writers) must never wait, or they could wait
+// for memory only they can release; they use Charge, and bound their own
+// share. A nil *Budget is unlimited. A Budget is safe for concurrent use
+// and may be shared by several scans.
+type Budget struct {
+	mu    sync.Mutex
+	cond  *sync.Cond
+	stats BudgetStats
+}
+
+// NewBudget returns a budget of limit bytes
+func NewBudget(limit int64) *Budget {
+	b := &Budget{stats: BudgetStats{Limit: limit}}
+	b.cond = sync.NewCond(&b.mu)
+	return b
+}
+
+// Limit returns the budget in bytes, 0 for a nil (unlimited) budget
+func (b *Budget) Limit() int64 {
+	if b == nil {
+		return 0
+	}
+	return b.stats.Limit
+}
+
+// Acquire takes n bytes, waiting while they would take the budget over its
+// limit; a request larger than the limit is granted once nothing else is
+// held. It stops waiting and takes the bytes anyway as soon as urgent (if
+// not nil) reports true: ordered stages use it for the item the writer
+// needs next, whose memory is released first. urgent is called with the
+// budget locked and is evaluated again on every Release and Wake.
+func (b *Budget) Acquire(n int64, urgent func() bool) {
+	if b == nil {
+		return
+	}
+	b.mu.Lock()
+	defer b.mu.Unlock()
+	var start time.Time
+	for b.stats.InUse > 0 && b.stats.InUse+n > b.stats.Limit && (urgent == nil || !urgent()) {
+		if start.IsZero() {
+			start = time.Now()
+			b.stats.Waits++
+		}
+		b.cond.Wait()
+	}
+	if !start.IsZero() {
+		b.stats.Waited += time.Since(start)
+	}
+	b.take(n)
+}
+
+// Charge takes n bytes without waiting, even past the limit
+func (b *Budget) Charge(n int64) {
+	if b == nil {
+		return
+	}
+	b.mu.Lock()
+	b.take(n)
+	b.mu.Unlock()
+}
+
+func (b *Budget) take(n int64) {
+	b.stats.InUse += n
+	if b.stats.InUse > b.stats.Peak {
+		b.stats.Peak = b.stats.InUse
+	}
+}
+
+// Release returns n bytes and wakes the waiting stages
+func (b *Budget) Release(n int64) {
+	if b == nil {
+		return
+	}
+	b.mu.Lock()
+	b.stats.InUse -= n
+	b.mu.Unlock()
+	b.cond.Broadcast()
+}
+
+// Wake makes waiting stages evaluate their urgent functions again
+func (b *Budget) Wake() {
+	if b == nil {
+		return
+	}
+	b.mu.Lock()
+	b.mu.Unlock()
+	b.cond.Broadcast()
+}
+
+// Stats returns a snapshot of the budget's counters
+func (b *Budget) Stats() BudgetStats {
+	if b == nil {
+		return BudgetStats{}
+	}
+	b.mu.Lock()
+	defer b.mu.Unlock()
+	return b.stats
+}
+
+// FitWorkers returns how many of workers goroutines, each holding perWorker
+// bytes, fit in a quarter of the budget (at least one), leaving the rest
+// for data in flight between stages
+func (b *Budget) FitWorkers(workers int, perWorker int64) int {
+	if b == nil || perWorker <= 0 {
+		return workers
+	}
+	fit := int(b.stats.Limit / 4 / perWorker)
+	if fit < 1 {
+		fit = 1
+	}
+	if workers > fit {
+		workers = fit
+	}
+	return workers
+}
@@ -0,0 +1,211 @@
+// carve.go - INDEX page carving from raw disk images
+package scan
+
+import (
+	"encoding/binary"
+	"fmt"
+	"io"
+	"runtime"
+	"sort"
+	"sync"
+	"sync/atomic"
+
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/page"
+)
+
+// Positions of the system record literals on a compact INDEX page, as
+// checked by page.ParseIndexPage
+const (
+	infimumLitOff  = format.PageDataOff + format.RecordHeaderSize
+	supremumLitOff = infimumLitOff + format.SystemRecordBytes + format.RecordHeaderSize
+)
+
+var (
+	infimumWord  = binary.LittleEndian.Uint64(page.LitInfimum)
+	supremumWord = binary.LittleEndian.Uint64(page.LitSupremum)
+)
+
+// CarveOptions configures Carve
+type CarveOptions struct {
+	// Align is the step between candidate page starts in bytes (default
+	// 512, the smallest sector size). Use PageSize for images of a single
+	// tablespace, 4096 for file systems with 4K blocks.
+	Align int
+	// ChunkSize is the size of each sequential read (default 16MB)
+	ChunkSize int
+	// Workers is the number of reader goroutines (0 means GOMAXPROCS)
+	Workers int
+	// SkipChecksum accepts pages whose checksum does not verify (only the
+	// literals and LSN are checked), to recover from partially overwritten
+	// or legacy-checksum pages
+	SkipChecksum bool
+}
+
+// CarvedPage describes an INDEX page found in an image
+type CarvedPage struct {
+	Offset  int64 // byte offset of the page in the image
+	SpaceID uint32
+	PageNo  uint32
+	IndexID uint64
+	Level   uint16
+	NumRecs uint16
+	LSN     uint64
+}
+
+// Carve streams a raw image (disk, partition or unallocated-space dump) and
+// calls fn for every compact INDEX page in it. Workers read ChunkSize
+// chunks sequentially; within a chunk each Align step is tested with two
+// 8-byte compares against the INFIMUM/SUPREMUM literals, and only matches
+// are checked further: page type, header/trailer LSN and the crc32
+// checksum. fn must be safe for concurrent use; pageData is only valid
+// during the call. Pages are not reported in offset order.
+func Carve(r io.ReaderAt, size int64, opts CarveOptions, fn func(p CarvedPage, pageData []byte) error) error {
+	align := opts.Align
+	if align <= 0 {
+		align = 512
+	}
+	chunk := opts.ChunkSize
+	if chunk <= 0 {
+		chunk = 16 << 20
+	}
+	chunk -= chunk % align
+	if chunk < align {
+		chunk = align
+	}
+	workers := opts.Workers
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	chunks := (size + int64(chunk) - 1) / int64(chunk)
+	if int64(workers) > chunks {
+		workers = int(chunks)
+	}
+
+	var (
+		next     int64 = -1
+		wg       sync.WaitGroup
+		errOnce  sync.Once
+		firstErr error
+		failed   atomic.Bool
+	)
+	fail := func(err error) {
+		errOnce.Do(func() { firstErr = err })
+		failed.Store(true)
+	}
+	for w := 0; w < workers; w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			// Each chunk is read with a page of overlap so pages that
+			// straddle chunk boundaries are found by the chunk they start in
+			buf := make([]byte, chunk+format.PageSize)
+			for !failed.Load() {
+				c := atomic.AddInt64(&next, 1)
+				if c >= chunks {
+					return
+				}
+				base := c * int64(chunk)
+				b := buf
+				if rest := size - base; rest < int64(len(b)) {
+					b = b[:rest]
+				}
+				n, err := r.ReadAt(b, base)
+				if err != nil && err != io.EOF {
+					fail(fmt.Errorf("read at %d: %w", base, err))
+					return
+				}
+				if err := carveChunk(b[:n], base, chunk, align, !opts.SkipChecksum, fn); err != nil {
+					fail(err)
+					return
+				}
+			}
+		}()
+	}
+	wg.Wait()
+	return firstErr
+}
+
+// carveChunk tests the page starts in b[:limit] at align steps
+func carveChunk(b []byte, base int64, limit, align int, verify bool, fn func(CarvedPage, []byte) error) error {
+	last := len(b) - format.PageSize
+	if last >= limit {
+		last = limit - 1
+	}
+	for off := 0; off <= last; off += align {
+		p := b[off : off+format.PageSize]
+		if binary.LittleEndian.Uint64(p[infimumLitOff:]) != infimumWord ||
+			binary.LittleEndian.Uint64(p[supremumLitOff:]) != supremumWord {
+			continue
+		}
+		v, _ := page.NewView(p)
+		if !v.IsIndex() || v.Format() != format.FormatCompact || !v.LSNConsistent() {
+			continue
+		}
+		if verify && !v.ChecksumValid() {
+			continue
+		}
+		cp := CarvedPage{
+			Offset:  base + int64(off),
+			SpaceID: v.SpaceID(),
+			PageNo:  v.PageNumber(),
+			IndexID: v.IndexID(),
+			Level:   v.PageLevel(),
+			NumRecs: v.NumUserRecs(),
+			LSN:     v.LastModLSN(),
+		}
+		if err := fn(cp, p); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// CarvedIndex is the set of carved pages of one index
+type CarvedIndex struct {
+	SpaceID uint32
+	IndexID uint64
+	Pages   []CarvedPage // by page number
+}
+
+// GroupCarved groups carved pages by space ID and index ID, ordered by
+// space, then index. A page number found more than once in a space (older
+// copies left on disk, possibly of another index) keeps only the copy with
+// the highest LSN; the number of dropped copies is returned as stale.
+func GroupCarved(pages []CarvedPage) (groups []CarvedIndex, stale int) {
+	sorted := append([]CarvedPage(nil), pages...)
+	sort.Slice(sorted, func(i, j int) bool {
+		a, b := &sorted[i], &sorted[j]
+		if a.SpaceID != b.SpaceID {
+			return a.SpaceID < b.SpaceID
+		}
+		if a.PageNo != b.PageNo {
+			return a.PageNo < b.PageNo
+		}
+		return a.LSN > b.LSN
+	})
+	newest := sorted[:0]
+	for _, p := range sorted {
+		if n := len(newest); n > 0 && p.SpaceID == newest[n-1].SpaceID && p.PageNo == newest[n-1].PageNo {
+			stale++
+			continue
+		}
+		newest = append(newest, p)
+	}
+
+	sort.SliceStable(newest, func(i, j int) bool {
+		a, b := &newest[i], &newest[j]
+		if a.SpaceID != b.SpaceID {
+			return a.SpaceID < b.SpaceID
+		}
+		return a.IndexID < b.IndexID
+	})
+	for i, p := range newest {
+		if i == 0 || p.SpaceID != newest[i-1].SpaceID || p.IndexID != newest[i-1].IndexID {
+			groups = append(groups, CarvedIndex{SpaceID: p.SpaceID, IndexID: p.IndexID})
+		}
+		g := &groups[len(groups)-1]
+		g.Pages = append(g.Pages, p)
+	}
+	return groups, stale
+}
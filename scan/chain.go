@@ -0,0 +1,222 @@
+// chain.go - Leaf chain reconstruction from page headers
+package scan
+
+import (
+	"fmt"
+	"io"
+	"runtime"
+	"sort"
+	"sync"
+	"sync/atomic"
+
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/page"
+	"github.com/wilhasse/go-innodb/record"
+)
+
+// Chain is a run of leaf pages of one index linked both ways by
+// FIL_PAGE_PREV/FIL_PAGE_NEXT, in key order. An intact index has one chain
+// with First and Last set; a damaged one breaks into fragments.
+type Chain struct {
+	IndexID uint64
+	Pages   []uint32
+	Records int  // sum of PAGE_N_RECS
+	First   bool // starts at the leftmost leaf (FIL_PAGE_PREV is NULL)
+	Last    bool // ends at the rightmost leaf (FIL_PAGE_NEXT is NULL)
+}
+
+// Complete reports whether the chain covers its whole index level
+func (c *Chain) Complete() bool { return c.First && c.Last }
+
+// LeafChains rebuilds the leaf level of every index from headers alone,
+// without reading internal pages. A link p -> q is trusted only if both are
+// usable leaves of the same index, p.Next is q and q.Prev is p, so each page
+// has at most one predecessor and one successor and the leaves split into
+// disjoint chains. Chains are ordered by index ID, then the chain starting
+// at the leftmost leaf, then fragments by first page number.
+func LeafChains(headers []Header) []Chain {
+	n := len(headers)
+	linked := func(from uint32) (uint32, bool) {
+		h := &headers[from]
+		if h.Next == FilNull || int(h.Next) >= n {
+			return 0, false
+		}
+		to := &headers[h.Next]
+		if !to.IsLeaf() || to.IndexID != h.IndexID || to.Prev != from {
+			return 0, false
+		}
+		return h.Next, true
+	}
+
+	hasPred := make([]bool, n)
+	leaves := 0
+	for i := range headers {
+		if headers[i].IsLeaf() {
+			leaves++
+			if to, ok := linked(uint32(i)); ok {
+				hasPred[to] = true
+			}
+		}
+	}
+
+	pages := make([]uint32, 0, leaves)
+	visited := make([]bool, n)
+	var chains []Chain
+	follow := func(start uint32) {
+		c := Chain{IndexID: headers[start].IndexID, First: headers[start].Prev == FilNull}
+		from := len(pages)
+		for p, ok := start, true; ok && !visited[p]; p, ok = linked(p) {
+			visited[p] = true
+			pages = append(pages, p)
+			c.Records += int(headers[p].NumRecs)
+			c.Last = headers[p].Next == FilNull
+		}
+		c.Pages = pages[from:len(pages):len(pages)]
+		chains = append(chains, c)
+	}
+
+	// Chains start at leaves without a trusted predecessor; whatever is left
+	// afterwards lies on cycles, which are cut at their lowest page
+	for pass := 0; pass < 2; pass++ {
+		for i := range headers {
+			if headers[i].IsLeaf() && !visited[i] && (pass == 1 || !hasPred[i]) {
+				follow(uint32(i))
+			}
+		}
+	}
+
+	sort.SliceStable(chains, func(i, j int) bool {
+		a, b := &chains[i], &chains[j]
+		if a.IndexID != b.IndexID {
+			return a.IndexID < b.IndexID
+		}
+		if a.First != b.First {
+			return a.First
+		}
+		return a.Pages[0] < b.Pages[0]
+	})
+	return chains
+}
+
+// PageRef locates a page in the reconstructed leaf order: page Seq of
+// chains[Chain]
+type PageRef struct {
+	Chain  int
+	Seq    int
+	PageNo uint32
+}
+
+// ScanChains reads the pages of chains with workers goroutines (0 means
+// GOMAXPROCS) and calls fn for each. Chains are cut into segments of up to
+// 64 pages; each segment is read with one ReadAt per run of physically
+// consecutive pages and handed to fn in chain order by one goroutine, while
+// segments run in parallel. fn must be safe for concurrent use; pageData is
+// only valid during the call. The first error stops the scan.
+func ScanChains(r io.ReaderAt, chains []Chain, workers int, fn func(ref PageRef, pageData []byte) error) error {
+	type segment struct{ chain, start, end int }
+	var segs []segment
+	for ci := range chains {
+		for s := 0; s < len(chains[ci].Pages); s += chunkPages {
+			e := s + chunkPages
+			if e > len(chains[ci].Pages) {
+				e = len(chains[ci].Pages)
+			}
+			segs = append(segs, segment{ci, s, e})
+		}
+	}
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	if workers > len(segs) {
+		workers = len(segs)
+	}
+
+	var (
+		next     int64 = -1
+		wg       sync.WaitGroup
+		errOnce  sync.Once
+		firstErr error
+		failed   atomic.Bool
+	)
+	fail := func(err error) {
+		errOnce.Do(func() { firstErr = err })
+		failed.Store(true)
+	}
+	for w := 0; w < workers; w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			buf := make([]byte, chunkPages*format.PageSize)
+			for !failed.Load() {
+				i := int(atomic.AddInt64(&next, 1))
+				if i >= len(segs) {
+					return
+				}
+				sg := segs[i]
+				pages := chains[sg.chain].Pages[sg.start:sg.end]
+				if err := readRuns(r, pages, buf); err != nil {
+					fail(err)
+					return
+				}
+				for k, pageNo := range pages {
+					ref := PageRef{Chain: sg.chain, Seq: sg.start + k, PageNo: pageNo}
+					if err := fn(ref, buf[k*format.PageSize:(k+1)*format.PageSize]); err != nil {
+						fail(err)
+						return
+					}
+				}
+			}
+		}()
+	}
+	wg.Wait()
+	return firstErr
+}
+
+// readRuns reads pages into consecutive PageSize slots of buf, with one
+// ReadAt per run of physically consecutive page numbers
+func readRuns(r io.ReaderAt, pages []uint32, buf []byte) error {
+	for s := 0; s < len(pages); {
+		e := s + 1
+		for e < len(pages) && pages[e] == pages[e-1]+1 {
+			e++
+		}
+		b := buf[s*format.PageSize : e*format.PageSize]
+		if _, err := r.ReadAt(b, int64(pages[s])*format.PageSize); err != nil && err != io.EOF {
+			return fmt.Errorf("read pages %d-%d: %w", pages[s], pages[e-1], err)
+		}
+		s = e
+	}
+	return nil
+}
+
+// ScanLeaves rebuilds the leaf chains of a tablespace from a header pass and
+// calls fn for every user record of every leaf page, in parallel across
+// chain segments. It needs no intact internal page. fn receives the leaf
+// page as a View and the record at pos (delete-marked records included);
+// it must be safe for concurrent use.
+func ScanLeaves(r io.ReaderAt, size int64, workers int, fn func(ref PageRef, v page.View, pos int, hdr record.RecordHeader) error) ([]Chain, error) {
+	headers, err := ReadHeaders(r, size, workers)
+	if err != nil {
+		return nil, err
+	}
+	chains := LeafChains(headers)
+	err = ScanChains(r, chains, workers, func(ref PageRef, pageData []byte) error {
+		v, err := page.NewView(pageData)
+		if err != nil {
+			return err
+		}
+		var recErr error
+		err = v.ForEachRecord(true, func(pos int, hdr record.RecordHeader) bool {
+			recErr = fn(ref, v, pos, hdr)
+			return recErr == nil
+		})
+		if recErr != nil {
+			return recErr
+		}
+		if err != nil {
+			return fmt.Errorf("page %d: %w", ref.PageNo, err)
+		}
+		return nil
+	})
+	return chains, err
+}
@@ -0,0 +1,141 @@
+// headers.go - Parallel header-only pass over a tablespace
+package scan
+
+import (
+	"fmt"
+	"io"
+	"runtime"
+	"sync"
+	"sync/atomic"
+
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/page"
+)
+
+// FilNull is the on-disk page number meaning "no page"
+const FilNull = 0xFFFFFFFF
+
+// ExtentPages is the number of pages of an InnoDB extent (1MB of 16KB pages)
+const ExtentPages = 64
+
+// chunkPages is the number of pages read per I/O in the header pass (1MB)
+const chunkPages = ExtentPages
+
+// Header holds the header fields of one page needed to rebuild page links
+// without descending the B-tree. Index fields are zero unless IsIndex.
+type Header struct {
+	Pos      uint32 // page position in the file (offset / PageSize)
+	PageNo   uint32 // FIL_PAGE_OFFSET as stored
+	Type     format.PageType
+	SpaceID  uint32
+	LSN      uint64
+	Prev     uint32 // FilNull if none
+	Next     uint32 // FilNull if none
+	IndexID  uint64
+	Level    uint16
+	NumRecs  uint16
+	Compact  bool
+	Torn     bool // FIL header LSN does not match the trailer
+	Misplace bool // PageNo differs from Pos
+}
+
+// IsIndex reports whether h is a compact INDEX page usable for scans
+func (h *Header) IsIndex() bool {
+	return h.Type == format.PageTypeIndex && h.Compact && !h.Torn && !h.Misplace
+}
+
+// IsLeaf reports whether h is a usable leaf page
+func (h *Header) IsLeaf() bool { return h.IsIndex() && h.Level == 0 }
+
+// ReadHeaders reads the header of every page of a tablespace of size bytes.
+// The file is split into 1MB chunks read sequentially by workers goroutines
+// (0 means GOMAXPROCS); only page headers are kept. Result i is page i.
+func ReadHeaders(r io.ReaderAt, size int64, workers int) ([]Header, error) {
+	n := int(size / format.PageSize)
+	headers := make([]Header, n)
+	if n == 0 {
+		return headers, nil
+	}
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	chunks := (n + chunkPages - 1) / chunkPages
+	if workers > chunks {
+		workers = chunks
+	}
+
+	var (
+		next     int64 = -1
+		wg       sync.WaitGroup
+		errOnce  sync.Once
+		firstErr error
+		failed   atomic.Bool
+	)
+	for w := 0; w < workers; w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			buf := make([]byte, chunkPages*format.PageSize)
+			for !failed.Load() {
+				c := int(atomic.AddInt64(&next, 1))
+				if c >= chunks {
+					return
+				}
+				first := c * chunkPages
+				count := chunkPages
+				if first+count > n {
+					count = n - first
+				}
+				if err := readHeaderChunk(r, headers[first:first+count], first, buf); err != nil {
+					errOnce.Do(func() { firstErr = err })
+					failed.Store(true)
+					return
+				}
+			}
+		}()
+	}
+	wg.Wait()
+	return headers, firstErr
+}
+
+// readHeaderChunk reads the headers of up to chunkPages pages starting at
+// page first with one ReadAt into buf
+func readHeaderChunk(r io.ReaderAt, headers []Header, first int, buf []byte) error {
+	count := len(headers)
+	b := buf[:count*format.PageSize]
+	if _, err := r.ReadAt(b, int64(first)*format.PageSize); err != nil && err != io.EOF {
+		return fmt.Errorf("read pages %d-%d: %w", first, first+count-1, err)
+	}
+	for i := range headers {
+		parseHeader(&headers[i], uint32(first+i), b[i*format.PageSize:(i+1)*format.PageSize])
+	}
+	return nil
+}
+
+// parseHeader fills h from one full page
+func parseHeader(h *Header, pos uint32, p []byte) {
+	v, err := page.NewView(p)
+	if err != nil {
+		*h = Header{Pos: pos, Torn: true}
+		return
+	}
+	prev, _ := v.Prev()
+	next, _ := v.Next()
+	*h = Header{
+		Pos:     pos,
+		PageNo:  v.PageNumber(),
+		Type:    v.PageType(),
+		SpaceID: v.SpaceID(),
+		LSN:     v.LastModLSN(),
+		Prev:    prev,
+		Next:    next,
+	}
+	h.Torn = !v.LSNConsistent()
+	h.Misplace = h.PageNo != pos
+	if v.IsIndex() {
+		h.Compact = v.Format() == format.FormatCompact
+		h.NumRecs = v.NumUserRecs()
+		h.Level = v.PageLevel()
+		h.IndexID = v.IndexID()
+	}
+}
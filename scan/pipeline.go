@@ -0,0 +1,467 @@
+// pipeline.go - Staged page pipeline with auto-tuned per-stage parallelism
+package scan
+
+import (
+	"errors"
+	"fmt"
+	"io"
+	"runtime"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"github.com/wilhasse/go-innodb/format"
+	"github.com/wilhasse/go-innodb/page"
+	"github.com/wilhasse/go-innodb/record"
+)
+
+// defaultTuneEvery is the default of PipelineOptions.TuneEvery
+const defaultTuneEvery = 100 * time.Millisecond
+
+// ErrChecksum is returned by VerifyChecksums for a page whose stored
+// checksums do not match its contents
+var ErrChecksum = errors.New("page checksum mismatch")
+
+// Batch is a run of up to 64 pages of one chain travelling through a
+// pipeline. Each stage works on a whole batch, so a batch is only handed
+// between goroutines once per stage. Batches are recycled once the sink
+// returns; nothing may keep them, or slices of them, after that.
+type Batch struct {
+	Seq      int      // position of the batch in chain order
+	Chain    int      // index of the chain in the chains given to RunPipeline
+	Start    int      // index of Pages[0] in the chain
+	Pages    []uint32 // page numbers
+	PageSize int      // bytes per page in Data
+	Data     []byte   // page i at Data[i*PageSize:(i+1)*PageSize]
+	// Records lists the user records of the pages, in page order, once
+	// ParseRecords has run
+	Records []RecordRef
+	// Value carries the output of the last stages to the sink
+	Value interface{}
+
+	spare []byte
+}
+
+// RecordRef locates a record of a batch
+type RecordRef struct {
+	Page   int // index in Batch.Pages
+	Pos    int // offset of the record in the page
+	Header record.RecordHeader
+}
+
+// Page returns the data of page i of the batch
+func (b *Batch) Page(i int) []byte {
+	return b.Data[i*b.PageSize : (i+1)*b.PageSize]
+}
+
+// Spare returns a second buffer for pageSize-byte pages, for a stage that
+// transforms every page (decompression); Swap then makes it the data
+func (b *Batch) Spare(pageSize int) []byte {
+	n := len(b.Pages) * pageSize
+	if cap(b.spare) < n {
+		b.spare = make([]byte, n)
+	}
+	return b.spare[:n]
+}
+
+// Swap exchanges Data with the buffer returned by Spare
+func (b *Batch) Swap(pageSize int) {
+	b.Data, b.spare = b.spare[:len(b.Pages)*pageSize], b.Data
+	b.PageSize = pageSize
+}
+
+// Stage is one step of a pipeline. Run is called concurrently on different
+// batches by the stage's goroutines; the first error stops the pipeline.
+type Stage struct {
+	Name    string
+	Workers int // goroutines; 0 lets the pipeline tune the stage
+	Run     func(b *Batch) error
+}
+
+// PipelineOptions configures RunPipeline
+type PipelineOptions struct {
+	// PageSize is the physical page size read from r (default 16KB)
+	PageSize int
+	// ReadWorkers is the number of reading goroutines; 0 lets the
+	// pipeline tune the read stage
+	ReadWorkers int
+	// Workers is the number of goroutines shared by the tuned stages
+	// (0 means GOMAXPROCS). Each tuned stage has at least one.
+	Workers int
+	// InFlight is the number of batches in the pipeline at once (default
+	// twice the goroutines); memory is about InFlight * 64 pages
+	InFlight int
+	// TuneEvery is how often the goroutines are redistributed (default
+	// 100ms)
+	TuneEvery time.Duration
+	// Admit, if set, is called in Seq order before batch seq is read; it
+	// may block to bound the work in flight, as ordered writers do
+	Admit func(seq int) error
+	// OnError, if set, is called with the first error, before the
+	// pipeline waits for its goroutines; it must release anything Admit
+	// or the stages may be waiting for
+	OnError func(err error)
+	// Budget, if set, is charged for the page buffers of the batches
+	Budget *Budget
+}
+
+// StageStats reports what a stage did. Busy time is what the tuner
+// balances: a stage that needs twice the time per batch gets twice the
+// goroutines.
+type StageStats struct {
+	Name    string
+	Workers int // goroutines at the end (tuned stages) or fixed
+	Batches int64
+	Pages   int64
+	Busy    time.Duration // total time in Run (read: in ReadAt)
+	Idle    time.Duration // total time waiting for input
+}
+
+// pipeStage is a running stage
+type pipeStage struct {
+	Stage
+	tuned bool
+	max   int
+
+	mu      sync.Mutex
+	cond    *sync.Cond
+	active  int // goroutines allowed to take batches
+	drained bool
+
+	batches, pages, busy, idle int64 // atomic; busy and idle in ns
+	lastBusy                   int64
+	load                       float64 // smoothed busy time per interval
+}
+
+// admitted blocks goroutine id while it is beyond the stage's active
+// count; it reports false once the stage's input is drained
+func (s *pipeStage) admitted(id int) bool {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	for id >= s.active && !s.drained {
+		s.cond.Wait()
+	}
+	return !s.drained
+}
+
+func (s *pipeStage) setActive(n int) {
+	s.mu.Lock()
+	s.active = n
+	s.mu.Unlock()
+	s.cond.Broadcast()
+}
+
+func (s *pipeStage) drain() {
+	s.mu.Lock()
+	s.drained = true
+	s.mu.Unlock()
+	s.cond.Broadcast()
+}
+
+// RunPipeline reads the pages of chains, cut into batches of up to 64
+// pages, and passes every batch through stages in order, then to sink.
+// Each stage runs on its own goroutines, connected to the next by a
+// channel; a stage only waits for the one before it, so CPU-heavy stages
+// (inflate, decoding) scale independently of the reads. The read stage
+// reads each run of physically consecutive pages with one ReadAt.
+//
+// Stages with Workers set keep that many goroutines. The others, read
+// included unless ReadWorkers is set, share opts.Workers goroutines: every
+// TuneEvery the tuner gives each of them a share proportional to its
+// recent busy time, so the slowest stage gets the most.
+//
+// sink is called by the last stage's goroutines, concurrently and in no
+// particular order (Batch.Seq gives the order). RunPipeline returns the
+// first error and the statistics of every stage, read first.
+func RunPipeline(r io.ReaderAt, chains []Chain, stages []Stage, opts PipelineOptions, sink func(b *Batch) error) ([]StageStats, error) {
+	pageSize := opts.PageSize
+	if pageSize <= 0 {
+		pageSize = format.PageSize
+	}
+	workers := opts.Workers
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	tuneEvery := opts.TuneEvery
+	if tuneEvery <= 0 {
+		tuneEvery = defaultTuneEvery
+	}
+
+	type segment struct{ chain, start, end int }
+	var segs []segment
+	for ci := range chains {
+		for s := 0; s < len(chains[ci].Pages); s += chunkPages {
+			e := s + chunkPages
+			if e > len(chains[ci].Pages) {
+				e = len(chains[ci].Pages)
+			}
+			segs = append(segs, segment{ci, s, e})
+		}
+	}
+
+	read := Stage{Name: "read", Workers: opts.ReadWorkers, Run: func(b *Batch) error {
+		return readPages(r, b)
+	}}
+	ps := make([]*pipeStage, 0, len(stages)+1)
+	var tuned []*pipeStage
+	fixed := 0
+	for _, st := range append([]Stage{read}, stages...) {
+		s := &pipeStage{Stage: st, tuned: st.Workers <= 0, max: st.Workers}
+		s.cond = sync.NewCond(&s.mu)
+		if s.tuned {
+			s.max = workers
+			tuned = append(tuned, s)
+		} else {
+			fixed += st.Workers
+		}
+		ps = append(ps, s)
+	}
+	for _, s := range tuned {
+		s.active = workers / len(tuned)
+		if s.active < 1 {
+			s.active = 1
+		}
+	}
+	for _, s := range ps {
+		if !s.tuned {
+			s.active = s.max
+		}
+	}
+
+	inFlight := opts.InFlight
+	if inFlight <= 0 {
+		inFlight = 2 * (workers + fixed)
+	}
+	if inFlight > len(segs) {
+		inFlight = len(segs)
+	}
+	bufBytes := int64(inFlight) * chunkPages * int64(pageSize)
+	opts.Budget.Charge(bufBytes)
+	defer opts.Budget.Release(bufBytes)
+	free := make(chan *Batch, inFlight)
+	for i := 0; i < inFlight; i++ {
+		free <- &Batch{}
+	}
+
+	var (
+		errOnce  sync.Once
+		firstErr error
+		failed   atomic.Bool
+	)
+	fail := func(err error) {
+		errOnce.Do(func() {
+			firstErr = err
+			failed.Store(true)
+			if opts.OnError != nil {
+				opts.OnError(err)
+			}
+		})
+	}
+
+	// Channels hold every batch in flight, so only the source and idle
+	// goroutines ever wait
+	chans := make([]chan *Batch, len(ps)+1)
+	for i := range chans {
+		chans[i] = make(chan *Batch, inFlight)
+	}
+
+	var wg sync.WaitGroup
+	wg.Add(1)
+	go func() {
+		defer wg.Done()
+		defer close(chans[0])
+		for seq, sg := range segs {
+			if failed.Load() {
+				return
+			}
+			if opts.Admit != nil {
+				if err := opts.Admit(seq); err != nil {
+					fail(err)
+					return
+				}
+			}
+			b := <-free
+			pages := chains[sg.chain].Pages[sg.start:sg.end]
+			*b = Batch{Seq: seq, Chain: sg.chain, Start: sg.start, Pages: pages, PageSize: pageSize,
+				Data: b.Data, Records: b.Records[:0], spare: b.spare}
+			chans[0] <- b
+		}
+	}()
+
+	for i, s := range ps {
+		in, out := chans[i], chans[i+1]
+		last := i == len(ps)-1
+		var swg sync.WaitGroup
+		swg.Add(s.max)
+		for id := 0; id < s.max; id++ {
+			go func(s *pipeStage, id int) {
+				defer swg.Done()
+				for s.admitted(id) {
+					t0 := time.Now()
+					b, ok := <-in
+					t1 := time.Now()
+					if !ok {
+						s.drain()
+						return
+					}
+					atomic.AddInt64(&s.idle, int64(t1.Sub(t0)))
+					if failed.Load() {
+						// Keep draining so the stages before can finish
+						free <- b
+						continue
+					}
+					err := s.Run(b)
+					atomic.AddInt64(&s.busy, int64(time.Since(t1)))
+					atomic.AddInt64(&s.batches, 1)
+					atomic.AddInt64(&s.pages, int64(len(b.Pages)))
+					if err == nil && last {
+						err = sink(b)
+					}
+					if err != nil {
+						fail(err)
+					}
+					if last || err != nil {
+						free <- b
+						continue
+					}
+					out <- b
+				}
+			}(s, id)
+		}
+		go func() {
+			swg.Wait()
+			close(out)
+		}()
+	}
+
+	done := make(chan struct{})
+	if len(tuned) > 1 {
+		go tune(tuned, workers, tuneEvery, done)
+	}
+	for range chans[len(ps)] {
+		// The last stage hands nothing on; this waits for it to finish
+	}
+	close(done)
+	wg.Wait()
+
+	stats := make([]StageStats, len(ps))
+	for i, s := range ps {
+		s.mu.Lock()
+		active := s.active
+		s.mu.Unlock()
+		stats[i] = StageStats{
+			Name:    s.Name,
+			Workers: active,
+			Batches: atomic.LoadInt64(&s.batches),
+			Pages:   atomic.LoadInt64(&s.pages),
+			Busy:    time.Duration(atomic.LoadInt64(&s.busy)),
+			Idle:    time.Duration(atomic.LoadInt64(&s.idle)),
+		}
+	}
+	return stats, firstErr
+}
+
+// tune redistributes workers goroutines between stages every interval in
+// proportion to their smoothed busy time, each keeping at least one
+func tune(stages []*pipeStage, workers int, every time.Duration, done chan struct{}) {
+	t := time.NewTicker(every)
+	defer t.Stop()
+	for {
+		select {
+		case <-done:
+			return
+		case <-t.C:
+		}
+		var total float64
+		for _, s := range stages {
+			busy := atomic.LoadInt64(&s.busy)
+			s.load = (s.load + float64(busy-s.lastBusy)) / 2
+			s.lastBusy = busy
+			total += s.load
+		}
+		if total == 0 {
+			continue
+		}
+		spare := workers - len(stages)
+		for _, s := range stages {
+			n := 1
+			if spare > 0 {
+				n += int(float64(spare)*s.load/total + 0.5)
+			}
+			if n > s.max {
+				n = s.max
+			}
+			s.setActive(n)
+		}
+	}
+}
+
+// readPages reads the pages of b into its data buffer, with one ReadAt per
+// run of physically consecutive pages
+func readPages(r io.ReaderAt, b *Batch) error {
+	n := len(b.Pages) * b.PageSize
+	if cap(b.Data) < chunkPages*b.PageSize {
+		b.Data = make([]byte, chunkPages*b.PageSize)
+	}
+	b.Data = b.Data[:n]
+	for s := 0; s < len(b.Pages); {
+		e := s + 1
+		for e < len(b.Pages) && b.Pages[e] == b.Pages[e-1]+1 {
+			e++
+		}
+		buf := b.Data[s*b.PageSize : e*b.PageSize]
+		if _, err := r.ReadAt(buf, int64(b.Pages[s])*int64(b.PageSize)); err != nil && err != io.EOF {
+			return fmt.Errorf("read pages %d-%d: %w", b.Pages[s], b.Pages[e-1], err)
+		}
+		s = e
+	}
+	return nil
+}
+
+// VerifyChecksums is a stage function failing on the first page of a
+// batch whose checksums do not match (see page.View.ChecksumValid)
+func VerifyChecksums(b *Batch) error {
+	for i, pageNo := range b.Pages {
+		v, err := page.NewView(b.Page(i))
+		if err != nil {
+			return fmt.Errorf("page %d: %w", pageNo, err)
+		}
+		if !v.ChecksumValid() {
+			return fmt.Errorf("page %d: %w", pageNo, ErrChecksum)
+		}
+	}
+	return nil
+}
+
+// ParseRecords is a stage function listing the user records of the leaf
+// pages of a batch in b.Records, delete-marked ones included
+func ParseRecords(b *Batch) error {
+	b.Records = b.Records[:0]
+	for i, pageNo := range b.Pages {
+		v, err := page.NewView(b.Page(i))
+		if err != nil {
+			return fmt.Errorf("page %d: %w", pageNo, err)
+		}
+		err = v.ForEachRecord(true, func(pos int, hdr record.RecordHeader) bool {
+			b.Records = append(b.Records, RecordRef{Page: i, Pos: pos, Header: hdr})
+			return true
+		})
+		if err != nil {
+			return fmt.Errorf("page %d: %w", pageNo, err)
+		}
+	}
+	return nil
+}
+
+// FilterDeleted is a stage function dropping delete-marked records from
+// b.Records
+func FilterDeleted(b *Batch) error {
+	kept := b.Records[:0]
+	for _, rec := range b.Records {
+		if !rec.Header.FlagsDeleted {
+			kept = append(kept, rec)
+		}
+	}
+	b.Records = kept
+	return nil
+}
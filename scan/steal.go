@@ -0,0 +1,215 @@
+// steal.go - Work-stealing pool for tasks of uneven size
+package scan
+
+import (
+	"runtime"
+	"sync"
+	"sync/atomic"
+	"time"
+)
+
+// Task is a unit of work run by RunPool. It may split itself by spawning
+// more tasks with Worker.Spawn, but must not wait for them: they may be
+// queued behind it on the same worker.
+type Task func(w *Worker) error
+
+// PoolStats reports what the workers of a pool did
+type PoolStats struct {
+	Workers int
+	Tasks   int64         // tasks run, spawned ones included
+	Steals  int64         // tasks taken from another worker's queue
+	Busy    time.Duration // total time running tasks
+	Idle    time.Duration // total time waiting for a task
+}
+
+// Worker is one goroutine of a pool, passed to the tasks it runs
+type Worker struct {
+	ID   int
+	pool *pool
+
+	mu    sync.Mutex
+	deque []Task
+
+	tasks, steals int64
+	busy, idle    time.Duration
+}
+
+// pool is the state shared by the workers of RunPool
+type pool struct {
+	workers []*Worker
+	queued  int64 // tasks in the deques (atomic)
+	pending int64 // tasks queued or running (atomic)
+	failed  atomic.Bool
+
+	mu   sync.Mutex
+	cond *sync.Cond
+}
+
+// RunPool runs tasks and every task they spawn on workers goroutines (0
+// means GOMAXPROCS) and returns once all have completed, or the first
+// error once the running tasks have returned; queued tasks are then
+// dropped.
+//
+// Each worker has its own queue. It runs its newest task first, usually
+// one it has just spawned, so a task's subtasks are done while their data
+// is hot; a worker whose queue is empty steals the oldest task of another
+// worker's queue, the one its owner would have run last. The initial
+// tasks are dealt round-robin and each worker runs those dealt to it in
+// order, so they should come largest first. A large task that splits
+// itself thus gets the help of every worker that runs out of work,
+// instead of leaving one worker running it alone after the small ones
+// are done.
+func RunPool(workers int, tasks []Task) (PoolStats, error) {
+	if workers <= 0 {
+		workers = runtime.GOMAXPROCS(0)
+	}
+	p := &pool{workers: make([]*Worker, workers)}
+	p.cond = sync.NewCond(&p.mu)
+	for i := range p.workers {
+		p.workers[i] = &Worker{ID: i, pool: p}
+	}
+	// Deques are popped from the end: deal the last tasks first
+	for i := len(tasks) - 1; i >= 0; i-- {
+		w := p.workers[i%workers]
+		w.deque = append(w.deque, tasks[i])
+	}
+	p.queued = int64(len(tasks))
+	p.pending = int64(len(tasks))
+
+	var (
+		wg       sync.WaitGroup
+		errOnce  sync.Once
+		firstErr error
+	)
+	for _, w := range p.workers {
+		wg.Add(1)
+		go func(w *Worker) {
+			defer wg.Done()
+			if err := w.run(); err != nil {
+				errOnce.Do(func() { firstErr = err })
+				p.failed.Store(true)
+				p.wake()
+			}
+		}(w)
+	}
+	wg.Wait()
+
+	st := PoolStats{Workers: workers}
+	for _, w := range p.workers {
+		st.Tasks += w.tasks
+		st.Steals += w.steals
+		st.Busy += w.busy
+		st.Idle += w.idle
+	}
+	return st, firstErr
+}
+
+// Spawn queues t on w's queue. w runs it after the task that spawned it,
+// before older tasks, unless an idle worker steals it first.
+func (w *Worker) Spawn(t Task) {
+	p := w.pool
+	atomic.AddInt64(&p.pending, 1)
+	w.mu.Lock()
+	w.deque = append(w.deque, t)
+	w.mu.Unlock()
+	atomic.AddInt64(&p.queued, 1)
+	p.wake()
+}
+
+// Share returns how many goroutines the running task may use without
+// oversubscribing the pool: the workers divided by the tasks queued or
+// running, at least one. Tasks started while work is plentiful get one;
+// the last tasks of a run get the workers that have nothing left to do.
+func (w *Worker) Share() int {
+	n := len(w.pool.workers) / int(atomic.LoadInt64(&w.pool.pending))
+	if n < 1 {
+		n = 1
+	}
+	return n
+}
+
+// run takes tasks until none are left or the pool has failed
+func (w *Worker) run() error {
+	p := w.pool
+	for !p.failed.Load() {
+		t := w.pop()
+		if t == nil {
+			t = w.steal()
+		}
+		if t == nil {
+			start := time.Now()
+			more := p.wait()
+			w.idle += time.Since(start)
+			if !more {
+				return nil
+			}
+			continue
+		}
+		start := time.Now()
+		err := t(w)
+		w.busy += time.Since(start)
+		w.tasks++
+		if atomic.AddInt64(&p.pending, -1) == 0 {
+			p.wake()
+		}
+		if err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// pop takes the newest task of w's own queue
+func (w *Worker) pop() Task {
+	w.mu.Lock()
+	defer w.mu.Unlock()
+	n := len(w.deque)
+	if n == 0 {
+		return nil
+	}
+	t := w.deque[n-1]
+	w.deque[n-1] = nil
+	w.deque = w.deque[:n-1]
+	atomic.AddInt64(&w.pool.queued, -1)
+	return t
+}
+
+// steal takes the oldest task of the first other worker that has one,
+// starting with w's neighbour so that thieves spread over the victims
+func (w *Worker) steal() Task {
+	workers := w.pool.workers
+	for i := 1; i < len(workers); i++ {
+		v := workers[(w.ID+i)%len(workers)]
+		v.mu.Lock()
+		if len(v.deque) == 0 {
+			v.mu.Unlock()
+			continue
+		}
+		t := v.deque[0]
+		v.deque[0] = nil
+		v.deque = v.deque[1:]
+		v.mu.Unlock()
+		atomic.AddInt64(&w.pool.queued, -1)
+		w.steals++
+		return t
+	}
+	return nil
+}
+
+// wait blocks until a task is queued or none will ever be; it reports
+// whether there may be more tasks to run
+func (p *pool) wait() bool {
+	p.mu.Lock()
+	defer p.mu.Unlock()
+	for atomic.LoadInt64(&p.queued) == 0 && atomic.LoadInt64(&p.pending) > 0 && !p.failed.Load() {
+		p.cond.Wait()
+	}
+	return atomic.LoadInt64(&p.pending) > 0 && !p.failed.Load()
+}
+
+// wake makes waiting workers look for tasks again
+func (p *pool) wake() {
+	p.mu.Lock()
+	p.mu.Unlock()
+	p.cond.Broadcast()
+}
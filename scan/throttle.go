@@ -0,0 +1,202 @@
+// throttle.go - I/O rate limiting for scans beside a live server
+package scan
+
+import (
+	"io"
+	"sort"
+	"sync"
+	"time"
+)
+
+// Adaptive throttling evaluates read latencies over windows of at least
+// adaptWindow and minSamples reads. Above the target the byte rate is cut
+// by backoffFactor (not below minAdaptiveRate); below it the cut is undone
+// by recoverFactor per window until it no longer binds.
+const (
+	adaptWindow     = 500 * time.Millisecond
+	minSamples      = 8
+	backoffFactor   = 0.7
+	recoverFactor   = 1.1
+	minAdaptiveRate = 1 << 20
+)
+
+// ThrottleOptions configures a Throttle; zero values disable a limit
+type ThrottleOptions struct {
+	BytesPerSec int64 // read bandwidth limit
+	OpsPerSec   int   // ReadAt calls per second
+	// TargetLatency enables adaptive throttling: while the 99th percentile
+	// latency of recent reads is above it, the byte rate is cut, and it
+	// recovers once latency drops. Reads are up to 1MB (a header chunk or
+	// a run of leaf pages), which the target should allow for.
+	TargetLatency time.Duration
+}
+
+// ThrottleStats reports what a Throttle has done
+type ThrottleStats struct {
+	Bytes    int64
+	Ops      int64
+	Waited   time.Duration // total delay added before reads
+	P99      time.Duration // read latency of the last adaptive window
+	Limit    int64         // byte rate limit in force, 0 if none
+	Backoffs int           // adaptive rate cuts
+}
+
+// Throttle is an io.ReaderAt that limits the reads of another one with
+// token buckets for bytes and operations, so that scans of a tablespace on
+// a host that also serves traffic leave the device enough headroom. It is
+// safe for concurrent use: ScanChains and ReadHeaders workers share one
+// budget. A read larger than the burst borrows against future tokens, and
+// later reads wait for the debt to be repaid.
+type Throttle struct {
+	r    io.ReaderAt
+	opts ThrottleOptions
+
+	mu    sync.Mutex
+	bytes bucket
+	ops   bucket
+	stats ThrottleStats
+
+	// Adaptive state
+	adaptive    float64 // adaptive byte rate limit, 0 if not limiting
+	samples     []time.Duration
+	windowStart time.Time
+	windowBytes int64
+}
+
+// NewThrottle wraps r; r may be nil if the throttle is only read through
+// Reader
+func NewThrottle(r io.ReaderAt, opts ThrottleOptions) *Throttle {
+	return &Throttle{r: r, opts: opts, windowStart: time.Now()}
+}
+
+// Reader returns an io.ReaderAt reading r under the limits of t, so that
+// the scans of several files share one budget
+func (t *Throttle) Reader(r io.ReaderAt) io.ReaderAt {
+	return throttledReader{t: t, r: r}
+}
+
+// throttledReader is a file read through a shared Throttle
+type throttledReader struct {
+	t *Throttle
+	r io.ReaderAt
+}
+
+func (tr throttledReader) ReadAt(p []byte, off int64) (int, error) {
+	return tr.t.readAt(tr.r, p, off)
+}
+
+// bucket is a token bucket holding up to a tenth of a second of tokens.
+// Tokens may go negative; the debt is the wait of the next taker.
+type bucket struct {
+	tokens float64
+	last   time.Time
+}
+
+// take removes n tokens refilled at rate per second and returns how long
+// the caller must wait for them. A rate of 0 means no limit.
+func (b *bucket) take(now time.Time, n, rate float64) time.Duration {
+	if rate <= 0 {
+		b.tokens, b.last = 0, now
+		return 0
+	}
+	burst := rate / 10
+	if !b.last.IsZero() {
+		b.tokens += now.Sub(b.last).Seconds() * rate
+	}
+	if b.tokens > burst || b.last.IsZero() {
+		b.tokens = burst
+	}
+	b.last = now
+	b.tokens -= n
+	if b.tokens >= 0 {
+		return 0
+	}
+	return time.Duration(-b.tokens / rate * float64(time.Second))
+}
+
+// byteRate returns the byte rate limit in force, 0 if none
+func (t *Throttle) byteRate() float64 {
+	rate := float64(t.opts.BytesPerSec)
+	if t.adaptive > 0 && (rate <= 0 || t.adaptive < rate) {
+		rate = t.adaptive
+	}
+	return rate
+}
+
+// ReadAt waits for the tokens of len(p) bytes and one operation, then reads
+func (t *Throttle) ReadAt(p []byte, off int64) (int, error) {
+	return t.readAt(t.r, p, off)
+}
+
+func (t *Throttle) readAt(r io.ReaderAt, p []byte, off int64) (int, error) {
+	t.mu.Lock()
+	now := time.Now()
+	wait := t.bytes.take(now, float64(len(p)), t.byteRate())
+	if w := t.ops.take(now, 1, float64(t.opts.OpsPerSec)); w > wait {
+		wait = w
+	}
+	t.stats.Waited += wait
+	t.mu.Unlock()
+	if wait > 0 {
+		time.Sleep(wait)
+	}
+
+	start := time.Now()
+	n, err := r.ReadAt(p, off)
+	end := time.Now()
+
+	t.mu.Lock()
+	t.stats.Bytes += int64(n)
+	t.stats.Ops++
+	if t.opts.TargetLatency > 0 {
+		t.adapt(end, end.Sub(start), n)
+	}
+	t.mu.Unlock()
+	return n, err
+}
+
+// adapt records a read latency and, at the end of a window, moves the
+// adaptive limit: multiplicative decrease while the p99 latency is above
+// the target, gradual recovery while it is not
+func (t *Throttle) adapt(now time.Time, lat time.Duration, n int) {
+	t.samples = append(t.samples, lat)
+	t.windowBytes += int64(n)
+	elapsed := now.Sub(t.windowStart)
+	if elapsed < adaptWindow || len(t.samples) < minSamples {
+		return
+	}
+
+	sort.Slice(t.samples, func(i, j int) bool { return t.samples[i] < t.samples[j] })
+	p99 := t.samples[len(t.samples)*99/100]
+	t.stats.P99 = p99
+	observed := float64(t.windowBytes) / elapsed.Seconds()
+
+	if p99 > t.opts.TargetLatency {
+		base := t.adaptive
+		if base <= 0 || base > observed {
+			base = observed
+		}
+		t.adaptive = base * backoffFactor
+		if t.adaptive < minAdaptiveRate {
+			t.adaptive = minAdaptiveRate
+		}
+		t.stats.Backoffs++
+	} else if t.adaptive > 0 {
+		t.adaptive *= recoverFactor
+		// Drop the limit once it no longer binds
+		if max := float64(t.opts.BytesPerSec); max > 0 && t.adaptive >= max || t.adaptive > 2*observed {
+			t.adaptive = 0
+		}
+	}
+	t.samples = t.samples[:0]
+	t.windowStart, t.windowBytes = now, 0
+}
+
+// Stats returns a snapshot of the throttle's counters
+func (t *Throttle) Stats() ThrottleStats {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	st := t.stats
+	st.Limit = int64(t.byteRate())
+	return st
+}
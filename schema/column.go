@@ -77,17 +77,42 @@ type Column struct {
 	IsPrimaryKey  bool       // Part of primary key
 	EnumValues    []string   // Values for ENUM type
 	SetValues     []string   // Values for SET type
+
+	// Resolved by Resolve (called from TableDef.AddColumn)
+	Code          TypeCode // Dense type code used for decode dispatch
+	FixedSize     int      // On-disk size of fixed-length values (0 if variable)
+	MaxBytes      int      // Maximum stored byte length of a value
+	CharsetMaxLen int      // Maximum bytes per character (1, 3 or 4)
+	NullIndex     int      // Bit position in the NULL bitmap (-1 if NOT NULL)
+	varLen        bool
+	resolved      bool
+}
+
+// ResolvedCode returns the resolved type code, looking it up for columns
+// that have not been resolved yet
+func (c *Column) ResolvedCode() TypeCode {
+	if c.resolved {
+		return c.Code
+	}
+	return c.Type.Code()
 }
 
 // IsVariableLength returns true if the column has variable length storage
 func (c *Column) IsVariableLength() bool {
-	switch c.Type {
-	case TypeVarchar, TypeVarBinary,
-		TypeText, TypeTinyText, TypeMediumText, TypeLongText,
-		TypeBlob, TypeTinyBlob, TypeMediumBlob, TypeLongBlob,
-		TypeJSON:
+	if c.resolved {
+		return c.varLen
+	}
+	return c.computeVariableLength()
+}
+
+func (c *Column) computeVariableLength() bool {
+	switch c.ResolvedCode() {
+	case CodeVarchar, CodeVarBinary,
+		CodeText, CodeTinyText, CodeMediumText, CodeLongText,
+		CodeBlob, CodeTinyBlob, CodeMediumBlob, CodeLongBlob,
+		CodeJSON:
 		return true
-	case TypeChar, TypeBinary:
+	case CodeChar, CodeBinary:
 		// In InnoDB, CHAR can be variable if using multi-byte charset
 		// and actual data is longer than the defined length
 		return c.Charset != "" && c.Charset != "latin1" && c.Charset != "ascii"
@@ -98,8 +123,8 @@ func (c *Column) IsVariableLength() bool {
 
 // IsFixedLength returns true if the column has fixed length storage
 func (c *Column) IsFixedLength() bool {
-	switch c.Type {
-	case TypeChar, TypeBinary:
+	switch c.ResolvedCode() {
+	case CodeChar, CodeBinary:
 		// Only fixed if single-byte charset or small enough
 		return c.Charset == "" || c.Charset == "latin1" || c.Charset == "ascii"
 	default:
@@ -109,29 +134,50 @@ func (c *Column) IsFixedLength() bool {
 
 // StorageSize returns the storage size in bytes for fixed-length columns
 func (c *Column) StorageSize() int {
-	switch c.Type {
-	case TypeTinyInt:
+	switch c.ResolvedCode() {
+	case CodeTinyInt, CodeYear, CodeBoolean, CodeBool:
 		return 1
-	case TypeSmallInt, TypeYear:
+	case CodeSmallInt:
 		return 2
-	case TypeMediumInt, TypeDate:
+	case CodeMediumInt, CodeDate:
 		return 3
-	case TypeInt, TypeFloat:
+	case CodeInt, CodeFloat:
 		return 4
-	case TypeBigInt, TypeDouble, TypeDateTime, TypeTimestamp:
+	case CodeBigInt, CodeDouble:
 		return 8
-	case TypeTime:
+	case CodeTime:
 		return 3 + (c.Precision+1)/2
-	case TypeDecimal, TypeNumeric:
+	case CodeDateTime:
+		return 5 + (c.Precision+1)/2
+	case CodeTimestamp:
+		return 4 + (c.Precision+1)/2
+	case CodeDecimal, CodeNumeric:
 		// Complex calculation based on precision and scale
 		return calculateDecimalSize(c.Precision, c.Scale)
-	case TypeBit:
+	case CodeBit:
+		if c.Length == 0 {
+			return 1 // BIT defaults to BIT(1)
+		}
 		return (c.Length + 7) / 8
-	case TypeChar, TypeBinary:
+	case CodeEnum:
+		if len(c.EnumValues) > 255 {
+			return 2
+		}
+		return 1
+	case CodeSet:
+		// 1-4 bytes, or 8 bytes for sets of 33-64 members
+		n := (len(c.SetValues) + 7) / 8
+		if n == 0 {
+			return 1
+		} else if n > 4 {
+			return 8
+		}
+		return n
+	case CodeChar, CodeBinary:
 		if c.IsFixedLength() {
 			return c.Length
 		}
-	case TypeRowID:
+	case CodeRowID:
 		return 6 // Internal 6-byte row ID
 	}
 	return 0 // Variable length or unknown
@@ -4,6 +4,7 @@ package schema
 import (
 	"fmt"
 	"io/ioutil"
+	"regexp"
 	"strconv"
 	"strings"
 
@@ -29,10 +30,16 @@ func ParseTableDefFromSQL(sql string) (*TableDef, error) {
 		return nil, fmt.Errorf("no table spec in CREATE TABLE")
 	}
 
+	// Parse table options
+	// Note: Options parsing may vary depending on sqlparser version, so the
+	// charset is read from the statement text
+	tableDef.Engine = "InnoDB"
+	tableDef.Charset = tableCharset(sql)
+
 	// Parse columns
 	var primaryKeys []string
 	for _, col := range ddl.TableSpec.Columns {
-		column, err := parseColumn(col)
+		column, err := parseColumn(col, tableDef.Charset)
 		if err != nil {
 			return nil, fmt.Errorf("parse column %s failed: %w", col.Name, err)
 		}
@@ -45,12 +52,6 @@ func ParseTableDefFromSQL(sql string) (*TableDef, error) {
 		// Note: sqlparser may not expose this directly, we'll rely on indexes instead</
 	}
 
-	// Parse table options
-	// Note: Options parsing may vary depending on sqlparser version
-	// For now, set defaults
-	tableDef.Engine = "InnoDB"
-	tableDef.Charset = "utf8mb4"
-
 	// Parse indexes for primary keys
 	for _, idx := range ddl.TableSpec.Indexes {
 		if idx.Info.Primary {
@@ -80,8 +81,27 @@ func ParseTableDefFromSQLFile(filename string) (*TableDef, error) {
 	return ParseTableDefFromSQL(string(content))
 }
 
-// parseColumn converts sqlparser.ColumnDefinition to our Column type
-func parseColumn(col *sqlparser.ColumnDefinition) (*Column, error) {
+// tableCharsetRe matches the charset table option, e.g. "DEFAULT
+// CHARSET=latin1" or "CHARACTER SET utf8mb4"
+var tableCharsetRe = regexp.MustCompile(`(?i)\b(?:CHARSET|CHARACTER\s+SET)\s*=?\s*([a-z0-9_]+)`)
+
+// tableCharset returns the default charset of the table created by sql,
+// from the options after its column list, or utf8mb4 when there is none
+func tableCharset(sql string) string {
+	end := strings.LastIndexByte(sql, ')')
+	if end < 0 {
+		return "utf8mb4"
+	}
+	m := tableCharsetRe.FindStringSubmatch(sql[end:])
+	if m == nil {
+		return "utf8mb4" // Default for MySQL 8.0+
+	}
+	return strings.ToLower(m[1])
+}
+
+// parseColumn converts sqlparser.ColumnDefinition to our Column type;
+// string columns without a charset get the table's
+func parseColumn(col *sqlparser.ColumnDefinition, tableCharset string) (*Column, error) {
 	column := &Column{
 		Name: col.Name.String(),
 	}
@@ -124,21 +144,30 @@ func parseColumn(col *sqlparser.ColumnDefinition) (*Column, error) {
 		column.DefaultValue = sqlparser.String(col.Type.Default)
 	}
 
-	// Parse ENUM values
-	if column.Type == TypeEnum && col.Type.EnumValues != nil {
+	// Parse ENUM and SET values (sqlparser reports both as EnumValues)
+	if (column.Type == TypeEnum || column.Type == TypeSet) && col.Type.EnumValues != nil {
 		for _, val := range col.Type.EnumValues {
 			// Remove quotes from enum values
 			enumVal := strings.Trim(val, "'\"")
-			column.EnumValues = append(column.EnumValues, enumVal)
+			if column.Type == TypeEnum {
+				column.EnumValues = append(column.EnumValues, enumVal)
+			} else {
+				column.SetValues = append(column.SetValues, enumVal)
+			}
 		}
 	}
 
 	// Handle special type mappings
 	column.Type = normalizeColumnType(column.Type, column.Length)
 
+	// DECIMAL without (M,D) is DECIMAL(10,0)
+	if (column.Type == TypeDecimal || column.Type == TypeNumeric) && column.Precision == 0 {
+		column.Precision = 10
+	}
+
 	// Set default charset if not specified
 	if column.Charset == "" && isStringType(column.Type) {
-		column.Charset = "utf8mb4" // Default for MySQL 8.0+
+		column.Charset = tableCharset
 	}
 
 	return column, nil
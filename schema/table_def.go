@@ -41,11 +41,14 @@ func (td *TableDef) AddColumn(col *Column) error {
 	}
 
 	col.Ordinal = len(td.Columns)
+	col.Resolve()
 	td.Columns = append(td.Columns, col)
 	td.ColumnMap[col.Name] = col
 
 	// Update cached metadata
+	col.NullIndex = -1
 	if col.Nullable {
+		col.NullIndex = td.nullableCount
 		td.nullableColumns = append(td.nullableColumns, col)
 		td.nullableCount++
 		td.hasNullableColumn = true
@@ -0,0 +1,160 @@
+// type_code.go - Dense integer type codes and precomputed column storage properties
+package schema
+
+import "math"
+
+// TypeCode is a dense integer identifier for a ColumnType. Columns resolve
+// their code once when they are added to a TableDef so the decode paths can
+// dispatch on it (switch jump tables or function tables indexed by code)
+// instead of comparing type names for every value.
+type TypeCode uint8
+
+const (
+	CodeUnknown TypeCode = iota
+
+	// Integer types
+	CodeTinyInt
+	CodeSmallInt
+	CodeMediumInt
+	CodeInt
+	CodeBigInt
+
+	// String types
+	CodeChar
+	CodeVarchar
+	CodeText
+	CodeTinyText
+	CodeMediumText
+	CodeLongText
+
+	// Binary types
+	CodeBinary
+	CodeVarBinary
+	CodeBlob
+	CodeTinyBlob
+	CodeMediumBlob
+	CodeLongBlob
+
+	// Date and time types
+	CodeDate
+	CodeTime
+	CodeDateTime
+	CodeTimestamp
+	CodeYear
+
+	// Decimal types
+	CodeDecimal
+	CodeNumeric
+	CodeFloat
+	CodeDouble
+
+	// Other types
+	CodeBit
+	CodeEnum
+	CodeSet
+	CodeBoolean
+	CodeBool
+	CodeJSON
+	CodeRowID
+
+	// NumTypeCodes is the size of tables indexed by TypeCode
+	NumTypeCodes
+)
+
+var typeCodes = map[ColumnType]TypeCode{
+	TypeTinyInt:    CodeTinyInt,
+	TypeSmallInt:   CodeSmallInt,
+	TypeMediumInt:  CodeMediumInt,
+	TypeInt:        CodeInt,
+	TypeBigInt:     CodeBigInt,
+	TypeChar:       CodeChar,
+	TypeVarchar:    CodeVarchar,
+	TypeText:       CodeText,
+	TypeTinyText:   CodeTinyText,
+	TypeMediumText: CodeMediumText,
+	TypeLongText:   CodeLongText,
+	TypeBinary:     CodeBinary,
+	TypeVarBinary:  CodeVarBinary,
+	TypeBlob:       CodeBlob,
+	TypeTinyBlob:   CodeTinyBlob,
+	TypeMediumBlob: CodeMediumBlob,
+	TypeLongBlob:   CodeLongBlob,
+	TypeDate:       CodeDate,
+	TypeTime:       CodeTime,
+	TypeDateTime:   CodeDateTime,
+	TypeTimestamp:  CodeTimestamp,
+	TypeYear:       CodeYear,
+	TypeDecimal:    CodeDecimal,
+	TypeNumeric:    CodeNumeric,
+	TypeFloat:      CodeFloat,
+	TypeDouble:     CodeDouble,
+	TypeBit:        CodeBit,
+	TypeEnum:       CodeEnum,
+	TypeSet:        CodeSet,
+	TypeBoolean:    CodeBoolean,
+	TypeBool:       CodeBool,
+	TypeJSON:       CodeJSON,
+	TypeRowID:      CodeRowID,
+}
+
+// Code returns the dense type code for the column type
+func (t ColumnType) Code() TypeCode {
+	return typeCodes[t]
+}
+
+// String returns the type name for the code
+func (c TypeCode) String() string {
+	for t, code := range typeCodes {
+		if code == c {
+			return string(t)
+		}
+	}
+	return "UNKNOWN"
+}
+
+// CharsetMaxLen returns the maximum bytes per character for a charset
+func CharsetMaxLen(charset string) int {
+	switch charset {
+	case "utf8mb4":
+		return 4
+	case "utf8", "utf8mb3":
+		return 3
+	default:
+		return 1
+	}
+}
+
+// Resolve computes the column's type code and storage properties. It is
+// called by TableDef.AddColumn; call it again if Type, Length, Precision,
+// Scale or Charset are changed afterwards.
+func (c *Column) Resolve() {
+	c.Code = c.Type.Code()
+	c.CharsetMaxLen = CharsetMaxLen(c.Charset)
+	c.varLen = c.computeVariableLength()
+	c.FixedSize = 0
+	if !c.varLen {
+		c.FixedSize = c.StorageSize()
+	}
+	c.MaxBytes = c.computeMaxBytes()
+	c.resolved = true
+}
+
+// computeMaxBytes returns the largest number of bytes a value can occupy
+func (c *Column) computeMaxBytes() int {
+	switch c.Code {
+	case CodeChar, CodeVarchar:
+		return c.Length * c.CharsetMaxLen
+	case CodeBinary, CodeVarBinary:
+		return c.Length
+	case CodeTinyText, CodeTinyBlob:
+		return math.MaxUint8
+	case CodeText, CodeBlob:
+		return math.MaxUint16
+	case CodeMediumText, CodeMediumBlob:
+		return 1<<24 - 1
+	case CodeLongText, CodeLongBlob, CodeJSON:
+		return math.MaxInt32
+	default:
+		return c.StorageSize()
+	}
+}